@@ -30,6 +30,29 @@ namespace vp {
   class clock_event;
   class component;
 
+  // Level of the timing wheel used for events which are too far to fit the
+  // circular buffer. Each slot contains the events of a block of 1 << shift
+  // cycles and the level covers as many blocks as it has slots, starting
+  // from the block of the current cycle.
+  class clock_wheel_level
+  {
+  public:
+    clock_wheel_level(int size, int shift) : mask(size - 1), size(size), shift(shift) {}
+
+    clock_event *slots[64] = {};
+
+    // Bitmap of the slots having at least one event
+    uint64_t slots_bitmap = 0;
+
+    int mask;
+    int size;
+    int shift;
+
+    int nb_events = 0;
+
+    vp::trace events_trace;
+  };
+
   class clock_engine : public time_engine_client
   {
 
@@ -74,15 +97,20 @@ namespace vp {
       return this->enqueue(event, cycles);
     }
 
-    clock_event *event_new(component_clock *comp, clock_event_meth_t *meth)
+    inline clock_event *event_new(component_clock *comp, clock_event_meth_t *meth)
     {
-      clock_event *event = new clock_event(comp, meth);
-      return event;
+      return this->event_new(comp, (void *)static_cast<vp::component *>(comp), meth);
     }
 
-    clock_event *event_new(component_clock *comp, void *_this, clock_event_meth_t *meth)
+    inline clock_event *event_new(component_clock *comp, void *_this, clock_event_meth_t *meth)
     {
-      clock_event *event = new clock_event(comp, _this, meth);
+      clock_event *event = this->free_events;
+      if (likely(event != NULL))
+        this->free_events = event->next;
+      else
+        event = this->alloc_events();
+
+      event->init(comp, _this, meth);
       return event;
     }
 
@@ -91,9 +119,14 @@ namespace vp {
 
     vp::clock_event *get_next_event();
 
-    void event_del(component_clock *comp, clock_event *event)
+    // Deleted events are kept in a free list for the next allocations, with
+    // their data if any.
+    inline void event_del(component_clock *comp, clock_event *event)
     {
-      delete event;
+      vp_assert(!event->enqueued, 0, "Deleting enqueued event\n");
+
+      event->next = this->free_events;
+      this->free_events = event;
     }
 
     int64_t exec();
@@ -102,7 +135,11 @@ namespace vp {
 
     void update();
 
-    void set_time_engine(vp::time_engine *engine) { this->engine = engine; }
+    void set_time_engine(vp::time_engine *engine)
+    {
+      this->engine = engine;
+      this->scheduler = engine->get_scheduler(this->partition);
+    }
 
     vp::time_engine *get_engine() { return engine; }
 
@@ -114,27 +151,88 @@ namespace vp {
 
     int64_t get_frequency() { return freq; }
 
-    bool has_events() { return this->nb_enqueued_to_cycle || this->delayed_queue; }
+    int get_partition_latency() { return partition_latency; }
+
+    bool has_events() { return this->nb_enqueued_to_cycle || this->nb_enqueued_to_wheel; }
+
+    // These methods allow the event being executed to move the engine forward
+    // by several cycles from its callback, as if it had been reenqueued and
+    // executed again, provided that no other event would have been executed
+    // in-between. init_skip_cycles must be called first from the callback.
+    void init_skip_cycles();
+
+    inline bool can_skip_cycles(int64_t cycles);
+
+    inline void skip_cycles(int64_t cycles);
 
   protected:
 
-    void flush_delayed_queue();
+    clock_event *alloc_events();
+
+    void flush_wheel();
+
+    void wheel_insert(clock_event *event);
+
+    void wheel_remove(clock_event *event);
+
+    void wheel_cascade(clock_event *event);
+
+    clock_event *get_next_wheel_event();
+
+    int64_t get_wheel_first_cycle();
+
+    void update_wheel_overflow_first_cycle();
+
+    void build_wheel_traces();
+
+    static inline int get_first_slot(uint64_t slots, int current, int size);
 
     inline void enqueue_to_cycle(clock_event *event, int64_t cycles)
     {
       // The position of one round of the circular buffer is always aligned
       // on the buffer size.
       int cycle = (current_cycle + cycles) & CLOCK_EVENT_QUEUE_MASK;
-      event->next = event_queue[cycle];
+      clock_event *first = event_queue[cycle];
+      event->next = first;
+      event->prev = NULL;
+      event->level = 0;
+      event->slot = cycle;
+      if (first)
+        first->prev = event;
       event_queue[cycle] = event;
+      event_queue_slots |= 1ULL << cycle;
       nb_enqueued_to_cycle++;
       event->cycle = cycles + get_cycles();
+      if (event->cycle < this->skip_limit)
+        this->skip_limit = event->cycle;
     }
 
     clock_event *enqueue_other(clock_event *event, int64_t cycles);
 
     clock_event *event_queue[CLOCK_EVENT_QUEUE_SIZE];
-    clock_event *delayed_queue = NULL;
+
+    // Events which can be reused by event_new
+    clock_event *free_events = NULL;
+
+    // Upper levels of the timing wheel, for events which do not fit the
+    // circular buffer, and unsorted queue for events which do not even fit
+    // the last level.
+    std::vector<clock_wheel_level *> wheel_levels;
+    clock_event *wheel_overflow = NULL;
+    // Cycle of the first event of the overflow queue, which is not sorted
+    int64_t wheel_overflow_first_cycle = INT64_MAX;
+
+    // Cycle count when the events of the upper levels were last moved down,
+    // so that the next flush knows which blocks it has to go through.
+    int64_t wheel_cycles = 0;
+
+    // Number of events enqueued to the upper levels and overflow queue.
+    int nb_enqueued_to_wheel = 0;
+    int nb_wheel_overflow = 0;
+
+    // Bitmap of the circular buffer slots having at least one event, used to
+    // quickly find the next event.
+    uint64_t event_queue_slots = 0;
     int current_cycle = 0;
     int64_t period = 0;
     int64_t freq;
@@ -146,7 +244,8 @@ namespace vp {
     int64_t cycles = 0;
 
     // Tells how many events are enqueued to the circular buffer.
-    // If it is zero, there could still be some events in the delayed queue.
+    // If it is zero, there could still be some events in the upper levels of
+    // the wheel.
     int nb_enqueued_to_cycle = 0;
 
     // This time is relevant only when no event is enqueued into the circular
@@ -157,9 +256,24 @@ namespace vp {
     // external event.
     int64_t stop_time = 0;
 
-    bool must_flush_delayed_queue;
+    bool must_flush_wheel;
+
+    // Partition in which this clock domain is simulated, when the engine is
+    // running several partitions in parallel.
+    int partition;
+
+    // Minimum number of cycles taken by the interconnect for anything
+    // entering this clock domain from another partition. This bounds the
+    // quantum of the parallel simulation.
+    int partition_latency;
+
+    // Cycle of the first pending event, computed by init_skip_cycles and then
+    // only lowered when events are enqueued, so that it stays a safe bound.
+    int64_t skip_limit = 0;
 
     vp::trace cycles_trace;
+    vp::trace wheel_overflow_trace;
+    vp::trace wheel_cascade_trace;
   };    
 
 };
@@ -180,6 +294,40 @@ inline vp::clock_event *vp::clock_engine::reenqueue(vp::clock_event *event, int6
   return event;
 }
 
+inline bool vp::clock_engine::can_skip_cycles(int64_t cycles)
+{
+#ifdef __VP_USE_SYSTEMC
+  return false;
+#else
+  return this->cycles + cycles < this->skip_limit &&
+    !this->scheduler->has_event_before(this->get_time() + cycles * this->period);
+#endif
+}
+
+inline void vp::clock_engine::skip_cycles(int64_t cycles)
+{
+  // Going through a block of the first wheel level must trigger a flush of the
+  // wheel, as when the cycles are executed one by one.
+  if ((this->cycles & CLOCK_EVENT_QUEUE_MASK) + cycles >= CLOCK_EVENT_QUEUE_SIZE)
+    this->must_flush_wheel = true;
+
+  this->current_cycle = (this->current_cycle + cycles) & CLOCK_EVENT_QUEUE_MASK;
+  this->cycles += cycles;
+  this->scheduler->update(this->get_time() + cycles * this->period);
+}
+
+// Returns the index of the first slot having an event, starting from the
+// current one and wrapping around.
+inline int vp::clock_engine::get_first_slot(uint64_t slots, int current, int size)
+{
+  if (current)
+    slots = (slots >> current) | (slots << (size - current));
+  if (size < 64)
+    slots &= (1ULL << size) - 1;
+
+  return (current + __builtin_ctzll(slots)) & (size - 1);
+}
+
 inline vp::clock_event *vp::clock_engine::reenqueue_ext(vp::clock_event *event, int64_t enqueue_cycles)
 {
   this->sync();
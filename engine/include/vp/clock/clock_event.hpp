@@ -33,9 +33,23 @@ namespace vp {
   #define CLOCK_EVENT_NB_ARGS 8
   #define CLOCK_EVENT_QUEUE_SIZE 32
   #define CLOCK_EVENT_QUEUE_MASK (CLOCK_EVENT_QUEUE_SIZE - 1)
+  #define CLOCK_EVENT_SLAB_SIZE 64
+
+  #if CLOCK_EVENT_QUEUE_SIZE > 64
+  #error "The clock event queue must fit the 64 bits slot bitmap"
+  #endif
 
   typedef void (clock_event_meth_t)(void *, clock_event *event);
 
+  // Data which can be attached to an event by the model. This is allocated
+  // only when it is first accessed, to keep the event itself small.
+  class clock_event_data
+  {
+  public:
+    uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
+    void *args[CLOCK_EVENT_NB_ARGS];
+  };
+
   class clock_event
   {
 
@@ -46,28 +60,57 @@ namespace vp {
     clock_event(component_clock *comp, clock_event_meth_t *meth);
 
     clock_event(component_clock *comp, void *_this, clock_event_meth_t *meth) 
-      : comp(comp), _this(_this), meth(meth), enqueued(false) {}
+      : _this(_this), meth(meth), comp(comp), enqueued(false) {}
+
+    ~clock_event() { delete this->data; }
 
     inline int get_payload_size() { return CLOCK_EVENT_PAYLOAD_SIZE; }
-    inline uint8_t *get_payload() { return payload; }
+    inline uint8_t *get_payload() { return this->get_data()->payload; }
 
     inline int get_nb_args() { return CLOCK_EVENT_NB_ARGS; }
-    inline void **get_args() { return args; }
+    inline void **get_args() { return this->get_data()->args; }
 
     inline bool is_enqueued() { return enqueued; }
 
     int64_t get_cycle() { return cycle; }
 
   private:
-    uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
-    void *args[CLOCK_EVENT_NB_ARGS];
-    component_clock *comp;
+    // Only used by the clock engine to allocate events by slabs
+    clock_event() : enqueued(false) {}
+
+    inline void init(component_clock *comp, void *_this, clock_event_meth_t *meth)
+    {
+      this->comp = comp;
+      this->_this = _this;
+      this->meth = meth;
+    }
+
+    inline clock_event_data *get_data()
+    {
+      if (this->data == NULL)
+        this->data = new clock_event_data();
+      return this->data;
+    }
+
+    // The fields used for scheduling come first and the whole event fits
+    // a cache line.
+    clock_event *next;
+    clock_event *prev;
+    int64_t cycle;
     void *_this;
     clock_event_meth_t *meth;
-    clock_event *next;
+    component_clock *comp;
+    clock_event_data *data = NULL;
     bool enqueued;
-    int64_t cycle;
-  };    
+
+    // Level of the timing wheel where the event is enqueued (0 for the
+    // circular buffer, -1 for the overflow queue) and slot inside this level,
+    // so that it can be removed without searching for it.
+    int16_t level;
+    int16_t slot;
+  };
+
+  static_assert(sizeof(clock_event) <= 64, "Clock event must fit a cache line");
 
 };
 
@@ -52,6 +52,16 @@ namespace vp {
   class clock_engine;
   class component;
 
+  // Functional mode, where latencies and durations are not modeled and cores
+  // execute one instruction per cycle. It is selected at runtime with
+  // gvsoc/no_timing, or forced at compile time with VP_NO_TIMING so that
+  // the timing code is removed.
+#ifdef VP_NO_TIMING
+  static const bool no_timing = true;
+#else
+  extern bool no_timing;
+#endif
+
   class reg
   {
 
@@ -102,6 +102,16 @@ namespace vp {
     return _this->sync_back_meth_freq_cross((component *)_this->slave_context_for_freq_cross, value);
   }
 
+  template<class T>
+  inline void wire_master<T>::sync_partition_cross_stub(wire_master<T> *_this, T value)
+  {
+    // The slave may be running on another thread, the value is posted to its
+    // partition and will be received at the end of the quantum.
+    _this->master_scheduler->post(_this->slave_scheduler, [_this, value]() {
+      _this->sync_meth_partition_cross((component *)_this->slave_context_for_partition_cross, value);
+    });
+  }
+
   template<class T>
   inline void wire_master<T>::finalize()
   {
@@ -120,6 +130,40 @@ namespace vp {
       this->slave_context_for_freq_cross = this->get_remote_context();
       this->set_remote_context(this);
     }
+
+    // Same when the binding is crossing partitions simulated in parallel.
+    // Only the master to slave direction is handled. Values read back from
+    // the slave or sent by the slave to the master are needed immediately,
+    // which is not possible with the other side running in parallel, so such
+    // bindings are rejected.
+    vp::clock_engine *master_clock = this->get_owner()->get_clock();
+    vp::clock_engine *slave_clock = this->remote_port->get_owner()->get_clock();
+
+    if (master_clock && slave_clock && master_clock->get_scheduler() != slave_clock->get_scheduler())
+    {
+      if (this->slave_port->sync_back != NULL || this->slave_port->sync_back_mux != NULL ||
+        this->master_sync_meth != &wire_master<T>::sync_default)
+      {
+        this->get_comp()->get_trace()->fatal("Wire binding with sync_back or slave to master sync is crossing partitions (master: %s, slave: %s)\n",
+          master_clock->get_path().c_str(), slave_clock->get_path().c_str());
+      }
+
+      if (slave_clock->get_partition_latency() <= 0)
+      {
+        this->get_comp()->get_trace()->fatal("Wire binding is crossing partitions without partition latency (slave: %s)\n",
+          slave_clock->get_path().c_str());
+      }
+      master_clock->get_engine()->add_partition_crossing(slave_clock);
+
+      this->master_scheduler = master_clock->get_scheduler();
+      this->slave_scheduler = slave_clock->get_scheduler();
+
+      this->sync_meth_partition_cross = this->sync_meth;
+      this->sync_meth = (void (*)(void *, T))&wire_master<T>::sync_partition_cross_stub;
+
+      this->slave_context_for_partition_cross = this->get_remote_context();
+      this->set_remote_context(this);
+    }
   }
 
 
@@ -26,6 +26,7 @@
 namespace vp {
 
   class component;
+  class time_scheduler;
 
   template<class T>
   class wire_slave;
@@ -64,6 +65,7 @@ namespace vp {
     static inline void sync_freq_cross_stub(wire_master *_this, T value);
     static inline void sync_back_freq_cross_stub(wire_master *_this, T *value);
     static inline void sync_back_muxed(wire_master *_this, T *value);
+    static inline void sync_partition_cross_stub(wire_master *_this, T value);
     void (*sync_meth)(void *, T value);
     void (*sync_meth_mux)(void *, T value, int id);
     void (*sync_back_meth)(void *, T *value);
@@ -86,6 +88,11 @@ namespace vp {
 
     void *slave_context_for_freq_cross;
 
+    void (*sync_meth_partition_cross)(void *, T value);
+    void *slave_context_for_partition_cross;
+    vp::time_scheduler *master_scheduler;
+    vp::time_scheduler *slave_scheduler;
+
     int master_sync_mux_id;
   };
 
@@ -22,11 +22,14 @@
 #define __VP_ITF_IO_HPP__
 
 #include "vp/vp.hpp"
+#include <algorithm>
 
 namespace vp {
 
   class io_slave;
+  class io_master;
   class io_req;
+  class io_dmi;
 
   typedef enum
   {
@@ -38,7 +41,12 @@ namespace vp {
 
   typedef enum
   {
-    IO_REQ_FLAGS_DEBUG = (1<<0)
+    IO_REQ_FLAGS_DEBUG = (1<<0),
+    // Set by a master running ahead of its clock domain
+    IO_REQ_FLAGS_DECOUPLED = (1<<1),
+    // Set when the request was not handled because the slave must see the
+    // master at its local time. The master must synchronize and send it again.
+    IO_REQ_FLAGS_SYNC = (1<<2)
   } io_req_flags_e;
 
   #define IO_REQ_PAYLOAD_SIZE 64
@@ -50,6 +58,81 @@ namespace vp {
   typedef void (io_resp_meth_t)(void *, io_req *);
   typedef void (io_grant_meth_t)(void *, io_req *);
 
+  typedef bool (io_dmi_meth_t)(void *, uint64_t addr, io_dmi *dmi);
+  typedef void (io_dmi_inval_meth_t)(void *);
+
+
+
+  /*
+   * Direct memory interface descriptor
+   */
+
+  // This describes an area where a master can directly access the memory
+  // through a host pointer, instead of sending IO requests.
+  // It is filled by the final slave when the master asks for direct access
+  // and updated by all the components on the path which translate addresses.
+  // When access is denied, it still describes the area where it is denied so
+  // that the master does not ask again for each access.
+  class io_dmi
+  {
+  public:
+    io_dmi() { this->init(); }
+
+    // Mark the descriptor as not describing anything
+    inline void init() { base = 0; size = 0; mem = NULL; latency = 0; read_only = false; align = 0; }
+
+    // Fill the descriptor with the area where direct access is denied
+    inline void deny(uint64_t base, uint64_t size) { init(); this->base = base; this->size = size; }
+
+    // Fill the descriptor with the area where direct access is granted
+    inline void grant(uint64_t base, uint64_t size, uint8_t *mem, bool read_only=false);
+
+    // Tell if the access is inside the area described by the descriptor
+    inline bool is_inside(uint64_t addr, uint64_t size) { return addr - base < this->size && size <= this->size - (addr - base); }
+
+    // Tell if the access can be done directly through the host pointer
+    inline bool is_granted(uint64_t addr, uint64_t size, bool is_write)
+    {
+      return mem != NULL && (!is_write || !read_only) && is_inside(addr, size) &&
+        (align == 0 || ((addr ^ (addr + size - 1)) & ~(align - 1)) == 0);
+    }
+
+    // Host pointer for the specified address, only valid if the access is granted
+    inline uint8_t *get_mem(uint64_t addr) { return mem + addr - base; }
+
+    // Move the area to another address space, when going back through a component
+    // translating addresses from addr to slave_addr
+    inline void translate(uint64_t slave_addr, uint64_t addr) { base = base - slave_addr + addr; }
+
+    // Restrict the area to the one specified, which must contain the address
+    // for which the direct access was asked
+    inline void restrict(uint64_t base, uint64_t size);
+
+    // Increase the latency of the accesses
+    inline void inc_latency(int64_t incr) { if (!vp::no_timing) this->latency += incr; }
+
+    // Restrict the direct accesses to the ones not crossing the specified
+    // alignment, as the other ones would be handled differently
+    inline void set_align(uint64_t align) { if (this->align == 0 || align < this->align) this->align = align; }
+
+    uint64_t base;
+    uint64_t size;
+    uint8_t *mem;
+    int64_t latency;
+    bool read_only;
+    uint64_t align;
+  };
+
+  // Data which can be attached to a request by the components it goes
+  // through. This is allocated only when it is first accessed, to keep the
+  // request fields used for routing close together.
+  class io_req_data
+  {
+  public:
+    uint8_t payload[IO_REQ_PAYLOAD_SIZE];
+    void *args[IO_REQ_NB_ARGS];
+  };
+
   class io_req
   {
     friend class io_master;
@@ -64,6 +147,12 @@ namespace vp {
       init();
     }
 
+    ~io_req() { delete this->req_data; }
+
+    // The request owns its attached data, so it can't be copied
+    io_req(const io_req &) = delete;
+    io_req &operator=(const io_req &) = delete;
+
     io_slave *get_resp_port() { return resp_port;}
     void set_next(io_req *req) { next = req; }
     io_req *get_next() { return next; }
@@ -80,11 +169,12 @@ namespace vp {
     void set_actual_size(uint64_t actual_size) { this->actual_size = actual_size; }
     uint64_t get_actual_size() { return actual_size; }
 
-    inline void set_latency(uint64_t latency) { this->latency = latency; }
+    // Latencies and durations stay at 0 in functional mode
+    inline void set_latency(uint64_t latency) { if (!vp::no_timing) this->latency = latency; }
     inline uint64_t get_latency() { return this->latency; }
-    inline void inc_latency(uint64_t incr) { this->latency += incr; }
+    inline void inc_latency(uint64_t incr) { if (!vp::no_timing) this->latency += incr; }
 
-    inline void set_duration(uint64_t duration) { if (duration > this->duration) this->duration = duration; }
+    inline void set_duration(uint64_t duration) { if (!vp::no_timing && duration > this->duration) this->duration = duration; }
     inline uint64_t get_duration() { return this->duration; }
 
     inline uint64_t get_full_latency() { return latency + duration; }
@@ -93,10 +183,10 @@ namespace vp {
     void set_data(uint8_t *data) { this->data = data; }
 
     inline int get_payload_size() { return IO_REQ_PAYLOAD_SIZE; }
-    inline uint8_t *get_payload() { return payload; }
+    inline uint8_t *get_payload() { return this->get_req_data()->payload; }
 
     inline int get_nb_args() { return IO_REQ_NB_ARGS; }
-    inline void **get_args() { return args; }
+    inline void **get_args() { return this->get_req_data()->args; }
 
     inline void set_int(int index, int value) { *(int *)&get_args()[index] = value; }
     inline int get_int(int index) { return *(int *)&get_args()[index]; }
@@ -110,36 +200,52 @@ namespace vp {
         this->flags &= ~IO_REQ_FLAGS_DEBUG;
     }
 
+    inline bool is_decoupled() { return this->flags & IO_REQ_FLAGS_DECOUPLED; }
+    inline void set_decoupled() { this->flags |= IO_REQ_FLAGS_DECOUPLED; }
+
+    inline bool is_sync_required() { return this->flags & IO_REQ_FLAGS_SYNC; }
+
     inline int arg_alloc() { return current_arg++; }
     inline void arg_free() { current_arg--; }
 
-    inline void arg_push(void *arg) { this->args[this->current_arg++] = arg; }
-    inline void *arg_pop() { return this->args[--this->current_arg];}
+    inline void arg_push(void *arg) { this->get_args()[this->current_arg++] = arg; }
+    inline void *arg_pop() { return this->get_args()[--this->current_arg];}
 
-    inline void **arg_get() { return &args[current_arg-1]; }
-    inline void **arg_get(int index) { return &args[index]; }
-    inline void **arg_get_last() { return &args[current_arg]; }
+    inline void **arg_get() { return &get_args()[current_arg-1]; }
+    inline void **arg_get(int index) { return &get_args()[index]; }
+    inline void **arg_get_last() { return &get_args()[current_arg]; }
 
     inline void prepare() { latency = 0; duration=0; flags=0; }
     inline void init() { prepare(); current_arg=0; }
 
-    uint64_t flags;
+    // The fields used for routing the request come first so that they share
+    // the same cache lines.
     uint64_t addr;
     uint8_t *data;
     uint64_t size;
-    uint64_t actual_size;
     bool is_write;
     io_req_status_e status;
     io_slave *resp_port;
+    uint64_t flags;
+    uint64_t actual_size;
 
 
   private:
-    io_req *next;
+    inline io_req_data *get_req_data()
+    {
+      if (unlikely(this->req_data == NULL))
+        this->req_data = new io_req_data();
+      return this->req_data;
+    }
+
     int64_t latency;
     int64_t duration;
-    uint8_t payload[IO_REQ_PAYLOAD_SIZE];
-    void *args[IO_REQ_NB_ARGS];
+    io_req *next;
     int current_arg = 0;
+    io_req_data *req_data = NULL;
+
+    // Master port whose pool the request goes back to when it is freed
+    io_master *pool = NULL;
   };
 
 
@@ -159,7 +265,10 @@ namespace vp {
     // Can be called to allocate an IO request.
     inline io_req *req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write);
 
-    // Can be called to deallocate an IO request.
+    // Can be called to deallocate an IO request. The request goes back to the
+    // pool of the master port which allocated it, whichever port frees it, so
+    // it must be freed before that port is destroyed and from the partition
+    // it is simulated in.
     inline void req_del(io_req *req);
 
     // Return if this master port is bound.
@@ -179,6 +288,11 @@ namespace vp {
     // on which port the response will be sent back by the slave.
     inline io_req_status_e req(io_req *req, io_slave *slave_port);
 
+    // Can be called by master component to ask for direct access to the
+    // memory containing the specified address. Returns true if it is granted,
+    // in which case the descriptor can be used until the slave invalidates it.
+    inline bool dmi_req(uint64_t addr, io_dmi *dmi);
+
 
 
     /*
@@ -193,6 +307,10 @@ namespace vp {
     // an IO request response. Before being set, a default empty callback is active.
     inline void set_resp_meth(io_resp_meth_t *meth);
 
+    // Set the callback on master side called when the slave is invalidating
+    // the direct accesses it granted. Before being set, a default empty callback is active.
+    inline void set_dmi_inval_meth(io_dmi_inval_meth_t *meth);
+
 
 
     /*
@@ -202,6 +320,9 @@ namespace vp {
     // Constructor
     inline io_master();
 
+    // Destructor, frees the pooled requests and the partition crossing port
+    inline ~io_master();
+
     // Called by the framework to bind the master port to a slave port.
     virtual inline void bind_to(vp::port *port, vp::config *config);
 
@@ -233,6 +354,22 @@ namespace vp {
     // Default response callback, just do nothing.
     static inline void resp_default(void *, io_req *);
 
+    // Direct access invalidation callback set by the user.
+    // This is set to an empty callback by default.
+    void (*dmi_inval_meth)(void *context);
+
+    // Default direct access invalidation callback, just do nothing.
+    static inline void dmi_inval_default(void *);
+
+
+    /*
+     * Request pool
+     */
+
+    // Requests freed with req_del, reused by req_new to avoid allocating
+    // them for each transaction. They keep their attached data if any.
+    io_req *free_reqs = NULL;
+
 
     /*
      * Slave callbacks
@@ -248,6 +385,22 @@ namespace vp {
     // setup instead
     io_req_status_e (*req_meth_freq_cross)(void *, io_req *);
 
+    // req_meth when the binding is crossing partitions simulated in parallel
+    // as a stub is setup instead
+    io_req_status_e (*req_meth_partition_cross)(void *, io_req *);
+
+    // req_meth when the slave must synchronize with decoupled masters as a
+    // stub is setup instead
+    io_req_status_e (*req_meth_sync_on_access)(void *, io_req *);
+
+    // Direct access callback set by the user on slave port and retrieved during
+    // binding. This one is never stubbed as it does not have any timing impact
+    // on the slave side.
+    bool (*dmi_meth)(void *, uint64_t addr, io_dmi *dmi);
+
+    // Slave context for the direct access callback.
+    void *dmi_context = NULL;
+
 
     /*
      * Stubs
@@ -263,6 +416,18 @@ namespace vp {
     // domain before we call it.
     static inline io_req_status_e req_freq_cross_stub(io_master *_this, io_req *req);
 
+    // These are stubs setup when the binding is crossing 2 partitions simulated
+    // in parallel so that requests and responses go through the partition
+    // mailboxes and are delivered at the end of the quantum.
+    static inline io_req_status_e req_partition_cross_stub(io_master *_this, io_req *req);
+
+    // This is a stub setup when the slave must synchronize with decoupled
+    // masters so that we can send back their requests before the slave sees
+    // them.
+    static inline io_req_status_e req_sync_on_access_stub(io_master *_this, io_req *req);
+    static inline void resp_partition_cross_stub(io_master *_this, io_req *req);
+    static inline void grant_partition_cross_stub(io_master *_this, io_req *req);
+
 
     /*
      * Internal data
@@ -281,6 +446,22 @@ namespace vp {
     // so that the stub is working well.
     void *slave_context_for_freq_cross = NULL;
 
+    // Slave context when the binding is crossing partitions, same as for
+    // frequency domains.
+    void *slave_context_for_partition_cross = NULL;
+
+    // Slave context when the slave must synchronize with decoupled masters.
+    void *slave_context_for_sync_on_access = NULL;
+
+    // Schedulers of the master and slave partitions when the binding is
+    // crossing partitions.
+    vp::time_scheduler *master_scheduler = NULL;
+    vp::time_scheduler *slave_scheduler = NULL;
+
+    // Port given as response port to the slave when the binding is crossing
+    // partitions, so that the response is sent back through the mailboxes.
+    io_slave *partition_cross_port = NULL;
+
     // This data is the multiplex ID that we need to send to the slave when the slave port
     // is multiplexed.
     int slave_req_mux_id = -1;
@@ -322,6 +503,12 @@ namespace vp {
     // owned back by the master which can then proceed with the request.
     inline void resp(io_req *req) { this->master_resp_meth(this->get_remote_context(), req); }
 
+    // Can be called to invalidate all the direct accesses granted through this port.
+    // This must be called anytime the slave changes something which would make
+    // the direct accesses behave differently from IO requests, like a mapping,
+    // a power, check or bandwidth modeling change.
+    inline void dmi_invalidate();
+
 
 
     /*
@@ -337,6 +524,17 @@ namespace vp {
     // when calling the callback, and can be used to multiplex a slave port
     inline void set_req_meth_muxed(io_req_meth_muxed_t *meth, int id);
 
+    // Set the callback on slave side called when the master is asking for a
+    // direct access. Before being set, a default callback denying any direct
+    // access is active.
+    inline void set_dmi_meth(io_dmi_meth_t *meth);
+
+    // Tell that the slave must see the masters at their local time. Requests
+    // from masters running ahead of their clock domain are then sent back
+    // with the sync flag so that they first synchronize. This must be set
+    // before the port is bound.
+    inline void set_sync_on_access(bool sync) { this->sync_on_access = sync; }
+
 
 
     /*
@@ -367,6 +565,13 @@ namespace vp {
     // Default request callback, just do nothing.
     static inline io_req_status_e req_default(io_slave *, io_req *);
 
+    // Direct access callback set by the user.
+    // This is set to a callback denying the access by default.
+    bool (*dmi_meth)(void *context, uint64_t addr, io_dmi *dmi);
+
+    // Default direct access callback, deny it for the whole address space.
+    static inline bool dmi_default(void *, uint64_t addr, io_dmi *dmi);
+
     // Multiplexed request callback set by the user.
     // Similar to the req callback but with an associated data.
     // This one gets called instead of the normal once in case it is not NULL
@@ -418,6 +623,13 @@ namespace vp {
     // Multiplexed ID set by the slave when port is multiplxed
     int req_mux_id;
 
+    // True if decoupled masters must synchronize before accessing the slave
+    bool sync_on_access = false;
+
+    // Master ports bound to this port, which must be notified when direct
+    // accesses are invalidated.
+    std::vector<io_master *> dmi_masters;
+
 
     // Master context when the binding is crossing frequency domains.
     // We keep here a copy of the master context when the binding is crossing frequency
@@ -433,6 +645,22 @@ namespace vp {
     // Set default callbacks in case the user does not set them
     this->resp_meth = &io_master::resp_default;
     this->grant_meth = &io_master::grant_default;
+    this->dmi_inval_meth = &io_master::dmi_inval_default;
+    this->dmi_meth = &io_slave::dmi_default;
+  }
+
+
+
+  inline io_master::~io_master()
+  {
+    while (this->free_reqs)
+    {
+      io_req *req = this->free_reqs;
+      this->free_reqs = req->next;
+      delete req;
+    }
+
+    delete this->partition_cross_port;
   }
 
 
@@ -467,10 +695,30 @@ namespace vp {
 
 
 
+  inline bool io_master::dmi_req(uint64_t addr, io_dmi *dmi)
+  {
+    return this->dmi_meth(this->dmi_context, addr, dmi);
+  }
+
+
+
   inline io_req *io_master::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
   {
-    // For now we allocate new requests but this would be better to manage a pool of requests
-    io_req *req = new io_req(addr, data, size, is_write);
+    io_req *req = this->free_reqs;
+    if (likely(req != NULL))
+    {
+      this->free_reqs = req->next;
+      req->addr = addr;
+      req->data = data;
+      req->size = size;
+      req->is_write = is_write;
+      req->init();
+    }
+    else
+    {
+      req = new io_req(addr, data, size, is_write);
+      req->pool = this;
+    }
 
     return req;
   }
@@ -479,7 +727,16 @@ namespace vp {
 
   inline void io_master::req_del(io_req *req)
   {
-    delete req;
+    // Requests which were not allocated by a master port join our pool
+    io_master *pool = req->pool;
+    if (pool == NULL)
+    {
+      pool = this;
+      req->pool = this;
+    }
+
+    req->next = pool->free_reqs;
+    pool->free_reqs = req;
   }
 
 
@@ -498,12 +755,25 @@ namespace vp {
 
 
 
+  inline void io_master::set_dmi_inval_meth(io_dmi_inval_meth_t *meth)
+  {
+    dmi_inval_meth = meth;
+  }
+
+
+
   inline void io_master::resp_default(void *, io_req *)
   {
   }
 
 
 
+  inline void io_master::dmi_inval_default(void *)
+  {
+  }
+
+
+
   inline void io_master::grant_default(void *, io_req *)
   {
   }
@@ -518,6 +788,9 @@ namespace vp {
     vp_assert(port != NULL, this->get_owner()->get_trace(),
       "Binding to NULL slave port\n");
 
+    this->dmi_meth = port->dmi_meth;
+    this->dmi_context = port->get_context();
+
     if (port->req_meth_mux == NULL)
     {
       // Normal binding, just register the method and context into the master
@@ -535,6 +808,16 @@ namespace vp {
       this->slave_context_for_mux = port->get_context();
       this->slave_req_mux_id = port->req_mux_id;
     }
+
+    if (port->sync_on_access)
+    {
+      // The slave must synchronize with decoupled masters, tweak the
+      // callback to check the requests before they reach it.
+      this->req_meth_sync_on_access = this->req_meth;
+      this->req_meth = (io_req_meth_t *)&io_master::req_sync_on_access_stub;
+      this->slave_context_for_sync_on_access = this->get_remote_context();
+      this->set_remote_context(this);
+    }
   }
 
 
@@ -554,6 +837,22 @@ namespace vp {
 
 
 
+  inline io_req_status_e io_master::req_sync_on_access_stub(io_master *_this, io_req *req)
+  {
+    // The master is ahead of its clock domain and the slave would see it in
+    // the past. Give the request back so that the master synchronizes and
+    // sends it again.
+    if (req->is_decoupled())
+    {
+      req->flags |= IO_REQ_FLAGS_SYNC;
+      return IO_REQ_OK;
+    }
+
+    return _this->req_meth_sync_on_access((component *)_this->slave_context_for_sync_on_access, req);
+  }
+
+
+
   inline io_req_status_e io_master::req_freq_cross_stub(io_master *_this, io_req *req)
   {
     // The normal callback was tweaked in order to get there when the master is sending a
@@ -566,6 +865,50 @@ namespace vp {
 
 
 
+  inline io_req_status_e io_master::req_partition_cross_stub(io_master *_this, io_req *req)
+  {
+    // The slave may be running on another thread, the request is posted to its
+    // partition and the master gets a pending status. The response port is
+    // saved in the request and replaced by our port so that the response
+    // also goes back through the mailboxes.
+    req->arg_push(req->resp_port);
+    req->resp_port = _this->partition_cross_port;
+
+    _this->master_scheduler->post(_this->slave_scheduler, [_this, req]() {
+      io_req_status_e status = _this->req_meth_partition_cross((component *)_this->slave_context_for_partition_cross, req);
+
+      // Since the master was told the request is pending, a synchronous
+      // answer from the slave must be turned into a response
+      if (status == IO_REQ_OK || status == IO_REQ_INVALID)
+      {
+        req->status = status;
+        _this->partition_cross_port->resp(req);
+      }
+    });
+
+    return IO_REQ_PENDING;
+  }
+
+
+
+  inline void io_master::resp_partition_cross_stub(io_master *_this, io_req *req)
+  {
+    _this->slave_scheduler->post(_this->master_scheduler, [req]() {
+      io_slave *resp_port = (io_slave *)req->arg_pop();
+      req->resp_port = resp_port;
+      resp_port->resp(req);
+    });
+  }
+
+
+
+  inline void io_master::grant_partition_cross_stub(io_master *_this, io_req *req)
+  {
+    // The master already got a pending status, the grant is meaningless for it
+  }
+
+
+
   inline void io_master::finalize()
   {
     vp_assert(this->get_owner() != NULL, NULL,
@@ -592,12 +935,53 @@ namespace vp {
       this->slave_context_for_freq_cross = this->get_remote_context();
       this->set_remote_context(this);
     }
+
+    // Same when the binding is crossing partitions simulated in parallel, as
+    // the slave cannot be called directly. Direct accesses are denied since
+    // the master would access the memory while the slave is running.
+    vp::clock_engine *master_clock = this->get_owner()->get_clock();
+    vp::clock_engine *slave_clock = this->remote_port->get_owner()->get_clock();
+    vp::time_scheduler *master_scheduler = master_clock->get_scheduler();
+    vp::time_scheduler *slave_scheduler = slave_clock->get_scheduler();
+
+    if (master_scheduler != slave_scheduler)
+    {
+      // Requests take effect in the slave partition and responses in the
+      // master one at the end of the quantum, which must not be later than
+      // the latency of the interconnect.
+      if (master_clock->get_partition_latency() <= 0 || slave_clock->get_partition_latency() <= 0)
+      {
+        this->get_comp()->get_trace()->fatal("IO binding is crossing partitions without partition latency (master: %s, slave: %s)\n",
+          master_clock->get_path().c_str(), slave_clock->get_path().c_str());
+      }
+      master_clock->get_engine()->add_partition_crossing(master_clock);
+      master_clock->get_engine()->add_partition_crossing(slave_clock);
+
+      this->master_scheduler = master_scheduler;
+      this->slave_scheduler = slave_scheduler;
+
+      this->req_meth_partition_cross = this->req_meth;
+      this->req_meth = (io_req_meth_t *)&io_master::req_partition_cross_stub;
+      this->slave_context_for_partition_cross = this->get_remote_context();
+      this->set_remote_context(this);
+
+      this->partition_cross_port = new io_slave();
+      this->partition_cross_port->set_owner(this->remote_port->get_owner());
+      this->partition_cross_port->master_resp_meth = (void (*)(void *, io_req *))&io_master::resp_partition_cross_stub;
+      this->partition_cross_port->master_grant_meth = (void (*)(void *, io_req *))&io_master::grant_partition_cross_stub;
+      this->partition_cross_port->set_remote_context(this);
+
+      this->dmi_meth = &io_slave::dmi_default;
+      std::vector<io_master *> &dmi_masters = ((io_slave *)this->remote_port)->dmi_masters;
+      dmi_masters.erase(std::remove(dmi_masters.begin(), dmi_masters.end(), this), dmi_masters.end());
+    }
   }
 
 
 
   inline io_slave::io_slave() : req_meth(NULL), req_meth_mux(NULL) {
     req_meth = (io_req_meth_t *)&io_slave::req_default;
+    dmi_meth = &io_slave::dmi_default;
   }
 
 
@@ -613,6 +997,7 @@ namespace vp {
     port->slave_port->master_resp_meth = port->resp_meth;
     port->slave_port->master_grant_meth = port->grant_meth;
     port->slave_port->set_remote_context(port->get_context());
+    this->dmi_masters.push_back(port);
   }
 
 
@@ -633,6 +1018,23 @@ namespace vp {
 
 
 
+  inline void io_slave::set_dmi_meth(io_dmi_meth_t *meth)
+  {
+    this->dmi_meth = meth;
+  }
+
+
+
+  inline void io_slave::dmi_invalidate()
+  {
+    for (io_master *master: this->dmi_masters)
+    {
+      master->dmi_inval_meth(master->get_context());
+    }
+  }
+
+
+
   inline io_req_status_e io_slave::req_default(io_slave *, io_req *)
   {
     return IO_REQ_OK;
@@ -640,6 +1042,14 @@ namespace vp {
 
 
 
+  inline bool io_slave::dmi_default(void *, uint64_t addr, io_dmi *dmi)
+  {
+    dmi->deny(0, -1);
+    return false;
+  }
+
+
+
   inline void io_slave::grant_freq_cross_stub(io_slave *_this, io_req *req)
   {
     // The normal callback was tweaked in order to get there when the master is sending a
@@ -679,6 +1089,40 @@ namespace vp {
   }
 
 
+  inline void io_dmi::grant(uint64_t base, uint64_t size, uint8_t *mem, bool read_only)
+  {
+    this->base = base;
+    this->size = size;
+    this->mem = mem;
+    this->latency = 0;
+    this->read_only = read_only;
+    this->align = 0;
+  }
+
+
+
+  inline void io_dmi::restrict(uint64_t base, uint64_t size)
+  {
+    // Work on last addresses instead of end addresses to not overflow when
+    // the area covers the whole address space
+    uint64_t last = this->base + this->size - 1;
+    uint64_t restrict_last = base + size - 1;
+
+    if (base > this->base)
+    {
+      if (this->mem)
+        this->mem += base - this->base;
+      this->base = base;
+    }
+
+    if (restrict_last < last)
+      last = restrict_last;
+
+    this->size = last - this->base + 1;
+  }
+
+
+
   inline void io_slave::finalize()
   {
     // We have to instantiate a stub in case the binding is crossing different
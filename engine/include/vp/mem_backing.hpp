@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_MEM_BACKING_HPP__
+#define __VP_MEM_BACKING_HPP__
+
+#include <stdint.h>
+#include <atomic>
+#include "json.hpp"
+
+namespace vp {
+
+  // Memories below this size are allocated and filled at once
+  #define MEM_BACKING_LAZY_MIN_SIZE (1<<20)
+
+  // Default granularity at which lazy memories are populated
+  #define MEM_BACKING_CHUNK_SIZE (1<<21)
+  #define MEM_BACKING_HUGE_CHUNK_BITS 21
+
+  // Host storage for the content of a simulated memory.
+  //
+  // Large memories are only reserved, as anonymous memory which does not
+  // take any host memory until it is touched. They are populated by chunks:
+  // the first time a chunk is accessed, it is filled with the initial pattern.
+  // Models must thus populate any area before accessing it through the data
+  // pointer, which is cheap once the chunk is populated, and can only give
+  // direct accesses to populated chunks. An area which is not populated reads
+  // as 0 instead of the pattern, and the pattern would overwrite what was
+  // written to it.
+  class mem_backing
+  {
+  public:
+
+    typedef enum {
+      HUGE_PAGES_NONE,
+      HUGE_PAGES_TRANSPARENT,
+      HUGE_PAGES_EXPLICIT
+    } huge_pages_e;
+
+    ~mem_backing();
+
+    // Allocates the memory, with every byte initialized to fill. Large
+    // memories are populated lazily by chunks of chunk_size bytes, 0 disables
+    // it. Returns -1 if it failed.
+    int init(uint64_t size, uint8_t fill=0x57, bool check=false, huge_pages_e huge_pages=HUGE_PAGES_NONE,
+      uint64_t chunk_size=MEM_BACKING_CHUNK_SIZE);
+
+    // Gets the huge page mode from the "huge_pages" property of a component
+    // configuration, which can be "transparent" or "explicit"
+    static huge_pages_e get_huge_pages(js::config *config);
+
+    // Gets the chunk size from the "lazy_chunk_size" property of a component
+    // configuration
+    static uint64_t get_chunk_size(js::config *config);
+
+    inline uint8_t *get_data() { return this->data; }
+    inline uint64_t get_size() { return this->size; }
+
+    // Makes sure the area is populated, this must be called before accessing
+    // it through the data pointer
+    inline void populate(uint64_t offset, uint64_t size);
+
+    // Populates the area around the specified offset which can be accessed
+    // directly, and returns it. This is the whole memory if it is not lazy,
+    // and the chunk containing the offset otherwise.
+    void populate_area(uint64_t offset, uint64_t *base, uint64_t *size);
+
+    // Copies the whole content to dest, without populating it
+    void copy_to(uint8_t *dest);
+
+    // Loads the beginning of the memory with the content of a file. For lazy
+    // memories, the whole pages of the file are mapped copy-on-write instead
+    // of being read, so that only the touched ones are read, and the file is
+    // not modified. Returns -1 with errno set if it failed.
+    //
+    // The mapped pages are not a snapshot: until a page is written by the
+    // simulation, it shows the current content of the file. The file must
+    // thus not be modified by anyone else during the simulation, and
+    // truncating it makes the accesses to the pages after its new end crash
+    // with SIGBUS. It can however be given to setup_writeback_file.
+    int preload_file(const char *path);
+
+    // Moves the content to a file mapped shared, so that the file contains
+    // the memory content at the end of the simulation. The data pointer is
+    // changed. Returns -1 with errno set if it failed.
+    int setup_writeback_file(const char *path);
+
+    // Tracking of the bytes which have been written, to detect accesses to
+    // uninitialized data. This is only available if enabled at init.
+    inline bool has_check() { return this->check_bits != NULL; }
+    inline void check_set(uint64_t offset, uint64_t size);
+    inline bool check_is_set(uint64_t offset, uint64_t size);
+
+  private:
+    void populate_chunks(uint64_t first, uint64_t last);
+    void populate_chunk(uint64_t chunk);
+    void free_data();
+
+    uint8_t *data = NULL;
+    uint64_t size = 0;
+    uint8_t fill = 0;
+    bool lazy = false;
+    bool hugetlb = false;
+    bool writeback = false;
+
+    uint64_t alloc_size = 0;
+    int chunk_bits = 0;
+    uint64_t nb_chunks = 0;
+    // 0: not populated, 1: being populated, 2: populated
+    std::atomic<uint8_t> *chunk_state = NULL;
+
+    uint64_t *check_bits = NULL;
+    uint64_t check_bits_size = 0;
+  };
+
+};
+
+inline void vp::mem_backing::populate(uint64_t offset, uint64_t size)
+{
+  if (!this->lazy || size == 0)
+    return;
+
+  uint64_t first = offset >> this->chunk_bits;
+  uint64_t last = (offset + size - 1) >> this->chunk_bits;
+
+  // Most accesses fall in a chunk which is already populated
+  if (first == last && this->chunk_state[first].load(std::memory_order_acquire) == 2)
+    return;
+
+  this->populate_chunks(first, last);
+}
+
+inline void vp::mem_backing::check_set(uint64_t offset, uint64_t size)
+{
+  uint64_t first = offset, last = offset + size;
+
+  while (first < last)
+  {
+    unsigned int bit = first & 63;
+    uint64_t nb_bits = 64 - bit;
+    if (nb_bits > last - first) nb_bits = last - first;
+    uint64_t mask = (nb_bits == 64 ? ~0ULL : ((1ULL << nb_bits) - 1)) << bit;
+
+    this->check_bits[first >> 6] |= mask;
+    first += nb_bits;
+  }
+}
+
+inline bool vp::mem_backing::check_is_set(uint64_t offset, uint64_t size)
+{
+  uint64_t first = offset, last = offset + size;
+
+  while (first < last)
+  {
+    unsigned int bit = first & 63;
+    uint64_t nb_bits = 64 - bit;
+    if (nb_bits > last - first) nb_bits = last - first;
+    uint64_t mask = (nb_bits == 64 ? ~0ULL : ((1ULL << nb_bits) - 1)) << bit;
+
+    if ((this->check_bits[first >> 6] & mask) != mask)
+      return false;
+    first += nb_bits;
+  }
+
+  return true;
+}
+
+#endif
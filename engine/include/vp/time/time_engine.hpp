@@ -23,6 +23,8 @@
 
 #include "vp/vp_data.hpp"
 #include "vp/component.hpp"
+#include <atomic>
+#include <functional>
 
 #ifdef __VP_USE_SYSTEMC
 #include <systemc.h>
@@ -33,8 +35,79 @@
 namespace vp {
 
   class time_engine_client;
+  class time_engine;
+  class clock_engine;
+
+  // Holds the clients of a set of clock domains and executes them in time
+  // order. The time engine is the scheduler of the default partition and
+  // creates one more scheduler for each partition simulated in parallel.
+  class time_scheduler {
+
+    friend class time_engine;
+
+  public:
+    time_scheduler(time_engine *engine) : engine(engine) {}
+
+    bool dequeue(time_engine_client *client);
+
+    bool enqueue(time_engine_client *client, int64_t time);
+
+    inline int64_t get_time() { return time; }
+
+    inline void update(int64_t time);
+
+    inline bool has_event_before(int64_t time);
+
+    // Post a callback which will be executed by the target partition at the
+    // end of the current quantum. This is the only way for a partition to
+    // act on another one.
+    inline void post(time_scheduler *target, std::function<void()> callback);
+
+    // Scheduler of the partition being executed by the calling thread, or
+    // NULL outside of the parallel quantums.
+    static thread_local time_scheduler *current;
+
+  protected:
+    inline time_engine_client *get_first_client() { return this->clients.size() ? this->clients[0] : NULL; }
+    inline bool is_before(time_engine_client *client0, time_engine_client *client1);
+    inline void heap_up(int index);
+    inline void heap_down(int index);
+    inline void heap_push(time_engine_client *client);
+    inline time_engine_client *heap_pop();
+    inline time_engine_client *heap_replace_first(time_engine_client *client);
+    inline void heap_remove(time_engine_client *client);
+
+    // Execute all the events of this partition which are strictly before the
+    // specified time.
+    void run_until(int64_t limit);
+
+    time_engine *engine;
+
+    // Clients having pending events, organized as a binary heap ordered by
+    // next event time so that the next client to be executed is always the
+    // first one.
+    std::vector<time_engine_client *> clients;
+
+    // Incremented anytime a client is pushed to the heap, to order clients
+    // with the same next event time. The last pushed one comes first.
+    int64_t enqueue_id = 0;
+
+    int64_t time = 0;
+
+    // End of the quantum being executed. Clients are not allowed to move
+    // their time up to it, since other partitions could still post messages
+    // for the quantum.
+    int64_t limit = INT64_MAX;
+
+    // Messages posted by this partition during the current quantum, delivered
+    // by the engine once all partitions are done with it.
+    std::vector<std::pair<time_scheduler *, std::function<void()>>> outbox;
+  };
+
+  class time_engine : public component, public time_scheduler {
+
+    friend class time_scheduler;
 
-  class time_engine : public component {
   public:
     time_engine(const char *config);
 
@@ -62,23 +135,32 @@ namespace vp {
 
     inline vp::time_engine *get_time_engine() { return this; }
 
-    bool dequeue(time_engine_client *client);
+    inline int64_t get_time();
 
-    bool enqueue(time_engine_client *client, int64_t time);
+    // Return the scheduler of the specified partition. Everything goes to
+    // the engine itself if parallel simulation is not enabled.
+    time_scheduler *get_scheduler(int partition);
 
-    int64_t get_time() { return time; }
+    // Called by bindings crossing partitions for the clock domain receiving
+    // their requests or values, whose partition latency bounds the quantum.
+    void add_partition_crossing(clock_engine *clock);
 
     inline void retain() { retain_count++; }
     inline void release() { retain_count--; }
 
     inline void fatal(const char *fmt, ...);
 
-    inline void update(int64_t time);
-
     void wait_ready();
     
   private:
-    time_engine_client *first_client = NULL;
+    bool has_clients();
+    void run_partitions();
+    int64_t get_partition_quantum();
+    void run_partitions_share(int thread_id, int64_t limit);
+    void deliver_partition_messages();
+    void partition_thread_routine(int thread_id);
+    static void *partition_thread_stub(void *arg);
+
     bool locked = false;
     bool locked_run_req;
     bool run_req;
@@ -86,18 +168,27 @@ namespace vp {
     bool finished = false;
     bool init = false;
 
-
-
-
+    // Parallel simulation, with partitions executed by several threads and
+    // synchronized at the end of each quantum.
+    bool parallel = false;
+    int64_t quantum = INT64_MAX;
+    int nb_threads;
+    std::vector<clock_engine *> partition_crossings;
+    std::vector<time_scheduler *> partitions;
+    std::vector<pthread_t> partition_threads;
+    pthread_mutex_t partitions_mutex;
+    pthread_cond_t partitions_cond;
+    int64_t partitions_limit;
+    int64_t partitions_quantum_id = 0;
+    int partitions_pending;
 
     bool running;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     pthread_t run_thread;
 
-    int64_t time = 0;
     int stop_status = -1;
-    int retain_count = 0;
+    std::atomic<int> retain_count{0};
     bool no_exit;
 
 #ifdef __VP_USE_SYSTEMC
@@ -109,6 +200,7 @@ namespace vp {
   class time_engine_client : public component {
 
     friend class time_engine;
+    friend class time_scheduler;
 
   public:
     time_engine_client(const char *config)
@@ -120,15 +212,20 @@ namespace vp {
 
     inline bool enqueue_to_engine(int64_t time)
     {
-      return engine->enqueue(this, time);
+      return scheduler->enqueue(this, time);
     }
 
-    inline int64_t get_time() { return engine->get_time(); }
+    inline int64_t get_time() { return scheduler->get_time(); }
+
+    inline vp::time_scheduler *get_scheduler() { return scheduler; }
 
     virtual int64_t exec() = 0;
 
   protected:
-    time_engine_client *next;
+    // Position of the client in the engine heap and order in which it was
+    // pushed, to break ties between clients with the same next event time.
+    int heap_index = -1;
+    int64_t enqueue_id = 0;
 
     // This gives the time of the next event.
     // It is only valid when the client is not the currently active one,
@@ -137,6 +234,7 @@ namespace vp {
     int64_t next_event_time = 0;
 
     vp::time_engine *engine;
+    vp::time_scheduler *scheduler;
     bool running = false;
     bool is_enqueued = false;
   };
@@ -229,12 +327,150 @@ namespace vp {
   }
 
 
-  inline void vp::time_engine::update(int64_t time)
+  inline int64_t vp::time_engine::get_time()
+  {
+    if (likely(!this->parallel) || time_scheduler::current == NULL)
+      return this->time;
+
+    return time_scheduler::current->time;
+  }
+
+
+  inline void vp::time_scheduler::update(int64_t time)
   {
     if (time > this->time)
       this->time = time;
   }
 
+  // Tells if a client, other than the running one, has an event strictly
+  // before the specified time. The end of the current quantum is seen as
+  // an event since messages from other partitions can arrive there.
+  inline bool vp::time_scheduler::has_event_before(int64_t time)
+  {
+    time_engine_client *first = this->get_first_client();
+    return time >= this->limit || (first && first->next_event_time < time);
+  }
+
+
+  inline void vp::time_scheduler::post(time_scheduler *target, std::function<void()> callback)
+  {
+    this->outbox.push_back(std::make_pair(target, callback));
+  }
+
+
+  inline bool vp::time_scheduler::is_before(time_engine_client *client0, time_engine_client *client1)
+  {
+    return client0->next_event_time < client1->next_event_time ||
+      (client0->next_event_time == client1->next_event_time && client0->enqueue_id > client1->enqueue_id);
+  }
+
+
+  inline void vp::time_scheduler::heap_up(int index)
+  {
+    time_engine_client *client = this->clients[index];
+
+    while (index > 0)
+    {
+      int parent_index = (index - 1) / 2;
+      time_engine_client *parent = this->clients[parent_index];
+      if (!this->is_before(client, parent))
+        break;
+
+      this->clients[index] = parent;
+      parent->heap_index = index;
+      index = parent_index;
+    }
+
+    this->clients[index] = client;
+    client->heap_index = index;
+  }
+
+
+  inline void vp::time_scheduler::heap_down(int index)
+  {
+    int size = this->clients.size();
+    time_engine_client *client = this->clients[index];
+
+    while (1)
+    {
+      int child_index = index * 2 + 1;
+      if (child_index >= size)
+        break;
+
+      if (child_index + 1 < size && this->is_before(this->clients[child_index + 1], this->clients[child_index]))
+        child_index++;
+
+      time_engine_client *child = this->clients[child_index];
+      if (!this->is_before(child, client))
+        break;
+
+      this->clients[index] = child;
+      child->heap_index = index;
+      index = child_index;
+    }
+
+    this->clients[index] = client;
+    client->heap_index = index;
+  }
+
+
+  inline void vp::time_scheduler::heap_push(time_engine_client *client)
+  {
+    client->enqueue_id = this->enqueue_id++;
+    this->clients.push_back(client);
+    this->heap_up(this->clients.size() - 1);
+  }
+
+
+  inline vp::time_engine_client *vp::time_scheduler::heap_pop()
+  {
+    if (this->clients.size() == 0)
+      return NULL;
+
+    time_engine_client *first = this->clients[0];
+    time_engine_client *last = this->clients.back();
+    this->clients.pop_back();
+
+    if (this->clients.size())
+    {
+      this->clients[0] = last;
+      this->heap_down(0);
+    }
+
+    first->heap_index = -1;
+    return first;
+  }
+
+
+  // Replace the first client by the specified one and return the former first
+  // one. This is cheaper than doing a pop and a push.
+  inline vp::time_engine_client *vp::time_scheduler::heap_replace_first(time_engine_client *client)
+  {
+    time_engine_client *first = this->clients[0];
+    client->enqueue_id = this->enqueue_id++;
+    this->clients[0] = client;
+    this->heap_down(0);
+    first->heap_index = -1;
+    return first;
+  }
+
+
+  inline void vp::time_scheduler::heap_remove(time_engine_client *client)
+  {
+    int index = client->heap_index;
+    time_engine_client *last = this->clients.back();
+    this->clients.pop_back();
+
+    if (last != client)
+    {
+      this->clients[index] = last;
+      this->heap_up(index);
+      this->heap_down(last->heap_index);
+    }
+
+    client->heap_index = -1;
+  }
+
 
 };
 
@@ -24,6 +24,7 @@
 #include "vp/vp_data.hpp"
 #include "vp/trace/event_dumper.hpp"
 #include <stdarg.h>
+#include <functional>
 
 namespace vp {
 
@@ -65,8 +66,12 @@ namespace vp {
     void dump_warning_header();
     void dump_fatal_header();
 
-    void set_active(bool active) { is_active = active; }
-    void set_event_active(bool active) { is_event_active = active; }
+    void set_active(bool active) { is_active = active; this->notify_active(); }
+    void set_event_active(bool active) { is_event_active = active; this->notify_active(); }
+
+    // Called whenever the trace or its event gets enabled or disabled, for
+    // models selecting their execution path depending on active traces.
+    void set_active_callback(std::function<void()> callback) { active_callback = callback; }
 
   #ifndef VP_TRACE_ACTIVE
     inline bool get_active() { return false; }
@@ -96,6 +101,11 @@ namespace vp {
     trace *next;
     trace *prev;
     int64_t pending_timestamp;
+
+  private:
+    void notify_active() { if (active_callback) active_callback(); }
+
+    std::function<void()> active_callback;
   };    
 
 
@@ -1111,6 +1111,8 @@ class Runner(Platform):
 
         parser.add_argument("--gtkw", dest="gtkw", action="store_true", help="Dump events to pipe and open gtkwave in interactive mode")
 
+        parser.add_argument("--no-timing", dest="no_timing", action="store_true", help="Functional simulation, without latencies and with one cycle per instruction")
+
         [args, otherArgs] = parser.parse_known_args()
 
         if 'devices' in args.command:
@@ -1148,6 +1150,9 @@ class Runner(Platform):
         if args.gtkw:
             self.get_json().set('gvsoc/vcd/gtkw', True)
 
+        if args.no_timing:
+            self.get_json().set('gvsoc/no_timing', True)
+
 
     def devices(self):
         devices = []
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "vp/mem_backing.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+
+vp::mem_backing::~mem_backing()
+{
+  this->free_data();
+
+  if (this->check_bits)
+  {
+    munmap(this->check_bits, this->check_bits_size);
+    this->check_bits = NULL;
+  }
+}
+
+
+void vp::mem_backing::free_data()
+{
+  if (this->lazy)
+  {
+    munmap(this->data, this->alloc_size);
+    delete[] this->chunk_state;
+  }
+  else if (this->writeback)
+  {
+    munmap(this->data, this->size);
+  }
+  else
+  {
+    delete[] this->data;
+  }
+
+  this->data = NULL;
+  this->lazy = false;
+  this->writeback = false;
+}
+
+
+static int mem_backing_read(int fd, uint8_t *data, uint64_t size, uint64_t offset)
+{
+  while (size > 0)
+  {
+    ssize_t len = pread(fd, data, size, offset);
+    if (len < 0)
+    {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    if (len == 0)
+      break;
+
+    data += len;
+    offset += len;
+    size -= len;
+  }
+
+  return 0;
+}
+
+
+vp::mem_backing::huge_pages_e vp::mem_backing::get_huge_pages(js::config *config)
+{
+  js::config *conf = config->get("huge_pages");
+  if (conf != NULL)
+  {
+    std::string mode = conf->get_str();
+    if (mode == "transparent")
+      return HUGE_PAGES_TRANSPARENT;
+    else if (mode == "explicit")
+      return HUGE_PAGES_EXPLICIT;
+  }
+
+  return HUGE_PAGES_NONE;
+}
+
+
+uint64_t vp::mem_backing::get_chunk_size(js::config *config)
+{
+  js::config *conf = config->get("lazy_chunk_size");
+  if (conf != NULL)
+    return conf->get_int();
+
+  return MEM_BACKING_CHUNK_SIZE;
+}
+
+
+int vp::mem_backing::init(uint64_t size, uint8_t fill, bool check, huge_pages_e huge_pages, uint64_t chunk_size)
+{
+  this->size = size;
+  this->fill = fill;
+
+  if (check)
+  {
+    // Anonymous memory reads as 0, i.e. as never written, and only takes
+    // host memory where it is touched
+    this->check_bits_size = (size + 63) / 64 * sizeof(uint64_t);
+    void *bits = mmap(NULL, this->check_bits_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (bits == MAP_FAILED)
+      return -1;
+    this->check_bits = (uint64_t *)bits;
+  }
+
+  if (chunk_size != 0 && size >= MEM_BACKING_LAZY_MIN_SIZE)
+  {
+    // Chunks are a power of 2 of pages, or of huge pages
+    int min_bits = huge_pages == HUGE_PAGES_NONE ? __builtin_ctzll(sysconf(_SC_PAGESIZE)) : MEM_BACKING_HUGE_CHUNK_BITS;
+    this->chunk_bits = std::max(min_bits, 64 - __builtin_clzll(chunk_size - 1));
+    chunk_size = 1ULL << this->chunk_bits;
+    this->nb_chunks = (size + chunk_size - 1) >> this->chunk_bits;
+    this->alloc_size = this->nb_chunks << this->chunk_bits;
+
+    void *data = MAP_FAILED;
+    if (huge_pages == HUGE_PAGES_EXPLICIT)
+    {
+      data = mmap(NULL, this->alloc_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+      this->hugetlb = data != MAP_FAILED;
+    }
+    if (data == MAP_FAILED)
+    {
+      data = mmap(NULL, this->alloc_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+
+    if (data != MAP_FAILED)
+    {
+      if (huge_pages == HUGE_PAGES_TRANSPARENT)
+        madvise(data, this->alloc_size, MADV_HUGEPAGE);
+
+      this->data = (uint8_t *)data;
+      this->chunk_state = new std::atomic<uint8_t>[this->nb_chunks]();
+      this->lazy = true;
+
+      return 0;
+    }
+  }
+
+  // Small memory, or the lazy one could not be set up, allocate it at once
+  this->data = new uint8_t[size];
+  memset(this->data, fill, size);
+
+  return 0;
+}
+
+
+void vp::mem_backing::populate_chunk(uint64_t chunk)
+{
+  if (this->chunk_state[chunk].load(std::memory_order_acquire) == 2)
+    return;
+
+  uint8_t expected = 0;
+  if (this->chunk_state[chunk].compare_exchange_strong(expected, 1))
+  {
+    // Anonymous memory reads as 0, so only other patterns need to be written
+    if (this->fill != 0)
+      memset(this->data + (chunk << this->chunk_bits), this->fill, 1ULL << this->chunk_bits);
+
+    this->chunk_state[chunk].store(2, std::memory_order_release);
+  }
+  else
+  {
+    // Another thread is populating it, it can only be accessed once it is done
+    while (this->chunk_state[chunk].load(std::memory_order_acquire) != 2) {}
+  }
+}
+
+
+void vp::mem_backing::populate_chunks(uint64_t first, uint64_t last)
+{
+  for (uint64_t chunk = first; chunk <= last; chunk++)
+  {
+    this->populate_chunk(chunk);
+  }
+}
+
+
+void vp::mem_backing::populate_area(uint64_t offset, uint64_t *base, uint64_t *size)
+{
+  if (!this->lazy)
+  {
+    *base = 0;
+    *size = this->size;
+    return;
+  }
+
+  uint64_t chunk = offset >> this->chunk_bits;
+  this->populate_chunk(chunk);
+
+  *base = chunk << this->chunk_bits;
+  *size = std::min((uint64_t)1 << this->chunk_bits, this->size - *base);
+}
+
+
+void vp::mem_backing::copy_to(uint8_t *dest)
+{
+  if (!this->lazy)
+  {
+    memcpy(dest, this->data, this->size);
+    return;
+  }
+
+  for (uint64_t chunk = 0; chunk < this->nb_chunks; chunk++)
+  {
+    uint64_t offset = chunk << this->chunk_bits;
+    uint64_t size = 1ULL << this->chunk_bits;
+    if (offset + size > this->size)
+      size = this->size - offset;
+
+    if (this->chunk_state[chunk].load() == 2)
+      memcpy(dest + offset, this->data + offset, size);
+    else
+      memset(dest + offset, this->fill, size);
+  }
+}
+
+
+int vp::mem_backing::preload_file(const char *path)
+{
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  if (file_stat.st_size == 0)
+  {
+    close(fd);
+    errno = ENODATA;
+    return -1;
+  }
+
+  uint64_t size = std::min((uint64_t)file_stat.st_size, this->size);
+  uint64_t mapped = 0;
+
+  // Huge page mappings cannot be partially replaced by a file mapping
+  if (this->lazy && !this->hugetlb)
+  {
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t len = size & ~(page_size - 1);
+
+    if (len != 0 && mmap(this->data, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED)
+    {
+      mapped = len;
+
+      // The chunks covered by the file are now populated. The pattern of the
+      // last one is only written after the file, as writing the mapped part
+      // would replace the content of the file.
+      uint64_t last = (len - 1) >> this->chunk_bits;
+      uint64_t end = std::min((last + 1) << this->chunk_bits, this->alloc_size);
+      if (this->fill != 0 && end > len && this->chunk_state[last].load() != 2)
+        memset(this->data + len, this->fill, end - len);
+
+      for (uint64_t chunk = 0; chunk <= last; chunk++)
+      {
+        this->chunk_state[chunk].store(2);
+      }
+    }
+  }
+
+  // The rest of the file is read, this includes the last page of the file, as
+  // the part after its end must keep the pattern
+  this->populate(mapped, size - mapped);
+  int err = mem_backing_read(fd, this->data + mapped, size - mapped, mapped);
+
+  close(fd);
+
+  return err;
+}
+
+
+int vp::mem_backing::setup_writeback_file(const char *path)
+{
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return -1;
+
+  if (ftruncate(fd, this->size) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  void *data = mmap(NULL, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  // The mapping keeps the file alive, and the content is written back to it
+  // by the kernel, at the latest when the simulation exits
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return -1;
+
+  this->copy_to((uint8_t *)data);
+  this->free_data();
+
+  this->data = (uint8_t *)data;
+  this->writeback = true;
+
+  return 0;
+}
@@ -35,6 +35,10 @@
 
 char vp_error[VP_ERROR_SIZE];
 
+#ifndef VP_NO_TIMING
+bool vp::no_timing = false;
+#endif
+
 vp::component::component(const char *config_string) : traces(*this), power(*this), reset_done_from_itf(false)
 {
   this->set_config(config_string);
@@ -115,27 +119,20 @@ void vp::component_clock::pre_build(component *comp) {
   comp->traces.new_trace("warning", &comp->warning, vp::WARNING);
 }
 
-bool vp::time_engine::dequeue(time_engine_client *client)
+thread_local vp::time_scheduler *vp::time_scheduler::current = NULL;
+
+bool vp::time_scheduler::dequeue(time_engine_client *client)
 {
   if (!client->is_enqueued) return false;
 
   client->is_enqueued = false;
 
-  time_engine_client *current = this->first_client, *prev = NULL;
-  while (current && current != client)
-  {
-    prev = current;
-    current = current->next;
-  }
-  if (prev)
-    prev->next = client->next;
-  else
-    this->first_client = client->next;
+  this->heap_remove(client);
 
   return true;
 }
 
-bool vp::time_engine::enqueue(time_engine_client *client, int64_t time)
+bool vp::time_scheduler::enqueue(time_engine_client *client, int64_t time)
 {
   vp_assert(time >= 0, NULL, "Time must be positive\n");
 
@@ -144,7 +141,7 @@ bool vp::time_engine::enqueue(time_engine_client *client, int64_t time)
 #ifdef __VP_USE_SYSTEMC
   // Notify to the engine that something has been pushed in case it is done
   // by an external systemC component and the engine needs to be waken up
-  if (started) sync_event.notify();
+  if (engine->started) engine->sync_event.notify();
 #endif
 
   if (client->is_running())
@@ -159,16 +156,8 @@ bool vp::time_engine::enqueue(time_engine_client *client, int64_t time)
 
   client->is_enqueued = true;
 
-  time_engine_client *current = first_client, *prev = NULL;
   client->next_event_time = full_time;
-  while (current && current->next_event_time < client->next_event_time)
-  {
-    prev = current;
-    current = current->next;
-  }
-  if (prev) prev->next = client;
-  else first_client = client;
-  client->next = current;
+  this->heap_push(client);
 
   return true;
 }
@@ -178,14 +167,14 @@ bool vp::clock_engine::dequeue_from_engine()
   if (this->is_running() || !this->is_enqueued)
     return false;
 
-  this->engine->dequeue(this);
+  this->scheduler->dequeue(this);
 
   return true;
 }
 
 void vp::clock_engine::reenqueue_to_engine()
 {
-  this->engine->enqueue(this, this->next_event_time);
+  this->scheduler->enqueue(this, this->next_event_time);
 }
 
 void vp::clock_engine::apply_frequency(int frequency)
@@ -235,7 +224,7 @@ void vp::clock_engine::update()
   if ((int64_t)sc_time_stamp().to_double() > this->get_time())
     diff = (int64_t)sc_time_stamp().to_double() - this->stop_time;
 
-  engine->update((int64_t)sc_time_stamp().to_double());
+  scheduler->update((int64_t)sc_time_stamp().to_double());
 #endif
 
   if (diff > 0)
@@ -272,125 +261,364 @@ vp::clock_event *vp::clock_engine::enqueue_other(vp::clock_event *event, int64_t
   }
   else
   {
-    this->must_flush_delayed_queue = true;
+    // When the engine is not running, the cycles may not be up-to-date and
+    // the event may end up in the block of the current cycle, which must then
+    // be moved down to the circular buffer before executing the next cycle.
+    if (!this->is_running())
+      this->must_flush_wheel = true;
+
     if (this->period != 0)
       enqueue_to_engine(cycle*period);
 
-    vp::clock_event *current = delayed_queue, *prev = NULL;
-    int64_t full_cycle = cycle + get_cycles();
-    while (current && current->cycle < full_cycle)
+    event->cycle = cycle + get_cycles();
+    if (event->cycle < this->skip_limit)
+      this->skip_limit = event->cycle;
+
+    this->wheel_insert(event);
+  }
+  return event;
+}
+
+void vp::clock_engine::wheel_insert(vp::clock_event *event)
+{
+  // Put the event in the first level which covers its cycle. Since each level
+  // starts at the block of the cycle of the insertion, an event inserted
+  // later can end up in a lower level than an event which is after it, so the
+  // next event must be searched in all the levels.
+  for (unsigned int i=0; i<this->wheel_levels.size(); i++)
+  {
+    clock_wheel_level *level = this->wheel_levels[i];
+    int64_t current_block = this->cycles >> level->shift;
+    int64_t block = event->cycle >> level->shift;
+
+    if (block < current_block)
+      block = current_block;
+
+    if (block - current_block < level->size)
     {
-      prev = current;
-      current = current->next;
+      int slot = block & level->mask;
+      clock_event *first = level->slots[slot];
+
+      event->next = first;
+      event->prev = NULL;
+      event->level = i + 1;
+      event->slot = slot;
+      if (first)
+        first->prev = event;
+      level->slots[slot] = event;
+      level->slots_bitmap |= 1ULL << slot;
+      level->nb_events++;
+      level->events_trace.event_real(level->nb_events);
+
+      this->nb_enqueued_to_wheel++;
+
+      return;
     }
-    if (prev) prev->next = event;
-    else delayed_queue = event;
-    event->next = current;
-    event->cycle = full_cycle;
   }
-  return event;
+
+  event->next = this->wheel_overflow;
+  event->prev = NULL;
+  event->level = -1;
+  event->slot = 0;
+  if (this->wheel_overflow)
+    this->wheel_overflow->prev = event;
+  this->wheel_overflow = event;
+  this->nb_wheel_overflow++;
+  this->wheel_overflow_trace.event_real(this->nb_wheel_overflow);
+  if (event->cycle < this->wheel_overflow_first_cycle)
+    this->wheel_overflow_first_cycle = event->cycle;
+
+  this->nb_enqueued_to_wheel++;
 }
 
-vp::clock_event *vp::clock_engine::get_next_event()
+void vp::clock_engine::update_wheel_overflow_first_cycle()
 {
-  // There is no quick way of getting the next event.
-  // We have to first check if there is an event in the circular buffer
-  // and if not in the delayed queue
+  this->wheel_overflow_first_cycle = INT64_MAX;
+  for (clock_event *event = this->wheel_overflow; event; event = event->next)
+  {
+    if (event->cycle < this->wheel_overflow_first_cycle)
+      this->wheel_overflow_first_cycle = event->cycle;
+  }
+}
 
-  if (this->nb_enqueued_to_cycle)
+void vp::clock_engine::wheel_remove(vp::clock_event *event)
+{
+  if (event->next)
+    event->next->prev = event->prev;
+
+  if (event->level == -1)
+  {
+    if (event->prev)
+      event->prev->next = event->next;
+    else
+      this->wheel_overflow = event->next;
+
+    this->nb_wheel_overflow--;
+    this->wheel_overflow_trace.event_real(this->nb_wheel_overflow);
+    if (event->cycle == this->wheel_overflow_first_cycle)
+      this->update_wheel_overflow_first_cycle();
+  }
+  else
   {
-    for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
+    clock_wheel_level *level = this->wheel_levels[event->level - 1];
+
+    if (event->prev)
     {
-      int cycle = (current_cycle + i) & CLOCK_EVENT_QUEUE_MASK;
-      vp::clock_event *event = event_queue[cycle];
-      if (event)
-      {
-        return event;
-      }
+      event->prev->next = event->next;
+    }
+    else
+    {
+      level->slots[event->slot] = event->next;
+      if (event->next == NULL)
+        level->slots_bitmap &= ~(1ULL << event->slot);
     }
-    vp_assert(false, 0, "Didn't find any event in circular buffer while it is not empty\n");
+
+    level->nb_events--;
+    level->events_trace.event_real(level->nb_events);
   }
 
-  return this->delayed_queue;
+  this->nb_enqueued_to_wheel--;
 }
 
-void vp::clock_engine::cancel(vp::clock_event *event)
+void vp::clock_engine::wheel_cascade(vp::clock_event *event)
 {
-  if (!event->is_enqueued())
-    return;
+  // Move an event which was in an upper level of the wheel down to the circular
+  // buffer if it now fits, or to another level.
+  int64_t cycles = event->cycle - this->cycles;
 
-  // There is no way to know if the event is enqueued into the circular buffer
-  // or in the delayed queue so first go through the delayed queue and if it is
-  // not found, look in the circular buffer
+  if (cycles < CLOCK_EVENT_QUEUE_SIZE)
+    this->enqueue_to_cycle(event, cycles > 0 ? cycles : 0);
+  else
+    this->wheel_insert(event);
+}
+
+vp::clock_event *vp::clock_engine::get_next_event()
+{
+  // First check if there is an event in the circular buffer, by finding the
+  // first slot having an event starting from the current cycle.
+  // Events in the upper levels of the wheel are usually after, but they can
+  // be before in case the circular buffer covers part of the next block of
+  // the first level, so take them into account when it is the case.
+  vp::clock_event *event = NULL;
 
-  // First the delayed queue
-  vp::clock_event *current = delayed_queue, *prev = NULL;
-  while (current)
+  if (this->nb_enqueued_to_cycle)
   {
-    if (current == event)
-    {
-      if (prev)
-        prev->next = event->next;
-      else
-        delayed_queue = event->next;
+    vp_assert(this->event_queue_slots != 0, 0, "Didn't find any event in circular buffer while it is not empty\n");
 
-      goto end;
-    }
+    event = event_queue[get_first_slot(this->event_queue_slots, this->current_cycle, CLOCK_EVENT_QUEUE_SIZE)];
+  }
 
-    prev = current;
-    current = current->next;
+  if (this->nb_enqueued_to_wheel && (event == NULL || this->get_wheel_first_cycle() < event->cycle))
+  {
+    vp::clock_event *wheel_event = this->get_next_wheel_event();
+    if (event == NULL || wheel_event->cycle < event->cycle)
+      event = wheel_event;
   }
 
-  // Then in the circular buffer
-  for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
+  return event;
+}
+
+int64_t vp::clock_engine::get_wheel_first_cycle()
+{
+  // Returns the first cycle of the first block having events in any level, or
+  // the first overflow event, which is a lower bound of the cycle of the next
+  // event in the upper levels of the wheel.
+  // This is cheaper than getting the event since events inside a block are not
+  // sorted.
+  int64_t result = this->wheel_overflow_first_cycle;
+
+  for (auto level: this->wheel_levels)
   {
-    vp::clock_event *current = event_queue[i], *prev = NULL;
-    while (current)
+    if (level->slots_bitmap)
     {
-      if (current == event)
-      {
-        if (prev)
-          prev->next = event->next;
-        else
-          event_queue[i] = event->next;
+      int64_t current_block = this->cycles >> level->shift;
+      int slot = get_first_slot(level->slots_bitmap, current_block & level->mask, level->size);
+      int64_t block = current_block + ((slot - current_block) & level->mask);
+      if ((block << level->shift) < result)
+        result = block << level->shift;
+    }
+  }
+
+  return result;
+}
 
-        this->nb_enqueued_to_cycle--;
+vp::clock_event *vp::clock_engine::get_next_wheel_event()
+{
+  // Inside a level, the first block having events contains the first event of
+  // the level, but any level can contain the next event, so take the first
+  // one of each level. Events in the same slot or in the overflow queue are not
+  // sorted.
+  vp::clock_event *result = NULL;
+
+  for (auto level: this->wheel_levels)
+  {
+    if (level->slots_bitmap)
+    {
+      int64_t current_block = this->cycles >> level->shift;
+      vp::clock_event *event = level->slots[get_first_slot(level->slots_bitmap, current_block & level->mask, level->size)];
 
-        goto end;
+      for (; event; event = event->next)
+      {
+        if (result == NULL || event->cycle < result->cycle)
+          result = event;
       }
+    }
+  }
 
-      prev = current;
-      current = current->next;
+  if (this->wheel_overflow && (result == NULL || this->wheel_overflow_first_cycle < result->cycle))
+  {
+    for (vp::clock_event *event = this->wheel_overflow; event; event = event->next)
+    {
+      if (event->cycle == this->wheel_overflow_first_cycle)
+        return event;
     }
   }
 
-  vp_assert(0, NULL, "Didn't find event in any queue while canceling event\n");
+  return result;
+}
+
+void vp::clock_engine::init_skip_cycles()
+{
+  vp::clock_event *event = NULL;
+
+  if (this->nb_enqueued_to_cycle)
+    event = event_queue[get_first_slot(this->event_queue_slots, this->current_cycle, CLOCK_EVENT_QUEUE_SIZE)];
+
+  this->skip_limit = event ? event->get_cycle() : INT64_MAX;
+
+  // For the upper levels of the wheel, just take the start of the first block
+  // of all levels to keep it cheap, this is a safe bound.
+  if (this->nb_enqueued_to_wheel)
+  {
+    int64_t wheel_cycle = this->get_wheel_first_cycle();
+    if (wheel_cycle < this->skip_limit)
+      this->skip_limit = wheel_cycle;
+  }
+}
+
+void vp::clock_engine::cancel(vp::clock_event *event)
+{
+  if (!event->is_enqueued())
+    return;
+
+  // The event knows where it is enqueued, either in a slot of the circular
+  // buffer, or in the upper levels of the wheel, so it can be directly removed.
+  if (event->level != 0)
+  {
+    this->wheel_remove(event);
+  }
+  else
+  {
+    if (event->next)
+      event->next->prev = event->prev;
+
+    if (event->prev)
+    {
+      event->prev->next = event->next;
+    }
+    else
+    {
+      event_queue[event->slot] = event->next;
+      if (event->next == NULL)
+        event_queue_slots &= ~(1ULL << event->slot);
+    }
+
+    this->nb_enqueued_to_cycle--;
+  }
 
-end:
   event->enqueued = false;
 
   if (!this->has_events())
     this->dequeue_from_engine();
 }
 
-void vp::clock_engine::flush_delayed_queue()
+void vp::clock_engine::flush_wheel()
 {
-  clock_event *event = delayed_queue;
-  this->must_flush_delayed_queue = false;
-  while (event)
+  this->must_flush_wheel = false;
+
+  if (this->nb_enqueued_to_wheel == 0)
   {
-    if (nb_enqueued_to_cycle == 0) cycles = event->cycle;
+    this->wheel_cycles = this->cycles;
+    return;
+  }
 
-    uint64_t cycle_diff = event->cycle - get_cycles();
-    if (cycle_diff >= CLOCK_EVENT_QUEUE_SIZE) break;
+  // If the circular buffer is empty, the engine was woken up for the first
+  // event of the wheel, so the cycles must be moved to it.
+  if (this->nb_enqueued_to_cycle == 0)
+  {
+    clock_event *event = this->get_next_wheel_event();
+    if (event->cycle > this->cycles)
+      this->cycles = event->cycle;
+  }
 
-    clock_event *next = event->next;
+  int nb_cascaded = 0;
 
-    enqueue_to_cycle(event, cycle_diff);
+  // Events in the overflow queue can get into the last level only when its
+  // current block has changed.
+  clock_wheel_level *last_level = this->wheel_levels.back();
+  if (this->wheel_overflow && (this->cycles >> last_level->shift) != (this->wheel_cycles >> last_level->shift))
+  {
+    clock_event *event = this->wheel_overflow;
+    this->wheel_overflow = NULL;
+    this->wheel_overflow_first_cycle = INT64_MAX;
+    this->nb_enqueued_to_wheel -= this->nb_wheel_overflow;
+    this->nb_wheel_overflow = 0;
+
+    while (event)
+    {
+      clock_event *next = event->next;
+      this->wheel_cascade(event);
+      nb_cascaded++;
+      event = next;
+    }
 
-    event = next;
-    delayed_queue = event;
+    this->wheel_overflow_trace.event_real(this->nb_wheel_overflow);
   }
+
+  // Then go through the levels from the last one and move down the events of
+  // all the blocks we went through since the last flush, including the one of
+  // the current cycle. Events can only be moved to lower levels, so each level
+  // is done once.
+  for (int i=this->wheel_levels.size()-1; i>=0; i--)
+  {
+    clock_wheel_level *level = this->wheel_levels[i];
+    int64_t block = this->wheel_cycles >> level->shift;
+    int64_t last_block = this->cycles >> level->shift;
+
+    if (level->slots_bitmap == 0)
+      continue;
+
+    if (last_block - block > level->mask)
+      block = last_block - level->mask;
+
+    for (; block <= last_block; block++)
+    {
+      int slot = block & level->mask;
+      if ((level->slots_bitmap & (1ULL << slot)) == 0)
+        continue;
+
+      clock_event *event = level->slots[slot];
+      level->slots[slot] = NULL;
+      level->slots_bitmap &= ~(1ULL << slot);
+
+      while (event)
+      {
+        clock_event *next = event->next;
+        level->nb_events--;
+        this->nb_enqueued_to_wheel--;
+        this->wheel_cascade(event);
+        nb_cascaded++;
+        event = next;
+      }
+    }
+
+    level->events_trace.event_real(level->nb_events);
+  }
+
+  this->wheel_cycles = this->cycles;
+
+  if (nb_cascaded)
+    this->wheel_cascade_trace.event_real(nb_cascaded);
 }
 
 int64_t vp::clock_engine::exec()
@@ -401,13 +629,12 @@ int64_t vp::clock_engine::exec()
   this->cycles_trace.event_real(this->cycles);
 
   // The clock engine has a circular buffer of events to be executed.
-  // Events longer than the buffer as put temporarly in a queue.
-  // Everytime we start again at the beginning of the buffer, we need
-  // to check if events must be enqueued from the queue to the buffer
-  // in case they fit the window.
-  if (unlikely(this->must_flush_delayed_queue))
+  // Events further than the buffer are put in the upper levels of a timing
+  // wheel. Everytime we enter a new block of the first level, we need
+  // to move the events of this block down to the circular buffer.
+  if (unlikely(this->must_flush_wheel))
   {
-    this->flush_delayed_queue();
+    this->flush_wheel();
   }
 
   vp_assert(this->get_next_event(), NULL, "Executing clock engine while it has no next event\n");
@@ -418,7 +645,12 @@ int64_t vp::clock_engine::exec()
 
   while (likely(current != NULL))
   {
-    event_queue[current_cycle] = current->next;
+    clock_event *next = current->next;
+    event_queue[current_cycle] = next;
+    if (next)
+      next->prev = NULL;
+    else
+      event_queue_slots &= ~(1ULL << current_cycle);
     current->enqueued = false;
     nb_enqueued_to_cycle--;
 
@@ -435,26 +667,26 @@ int64_t vp::clock_engine::exec()
   {
     cycles++;
     current_cycle = (current_cycle + 1) & CLOCK_EVENT_QUEUE_MASK;
-    if (unlikely(current_cycle == 0))
-      this->must_flush_delayed_queue = true;
+    if (unlikely((cycles & CLOCK_EVENT_QUEUE_MASK) == 0))
+      this->must_flush_wheel = true;
 
     return period;
   }
   else
   {
-    // Otherwise if there is an event in the delayed queue, return the time
+    // Otherwise if there is an event in the wheel, return the time
     // to this event.
-    // In both cases, force the delayed queue flush so that the next event to be
+    // In both cases, force the wheel flush so that the next event to be
     // executed is moved to the circular buffer.
-    this->must_flush_delayed_queue = true;
+    this->must_flush_wheel = true;
 
     // Also remember the current time in order to resynchronize the clock engine
     // in case we enqueue and event from another engine.
     this->stop_time = this->get_time();
 
-    if (delayed_queue)
+    if (this->nb_enqueued_to_wheel)
     {
-      return (delayed_queue->cycle - get_cycles()) * period;
+      return (this->get_next_wheel_event()->cycle - get_cycles()) * period;
     }
     else
     {
@@ -467,11 +699,35 @@ int64_t vp::clock_engine::exec()
 
 
 vp::clock_event::clock_event(component_clock *comp, clock_event_meth_t *meth) 
-: comp(comp), _this((void *)static_cast<vp::component *>((vp::component_clock *)(comp))), meth(meth), enqueued(false)
+: _this((void *)static_cast<vp::component *>((vp::component_clock *)(comp))), meth(meth), comp(comp), enqueued(false)
 {
 
 }
 
+vp::clock_event *vp::clock_engine::alloc_events()
+{
+  // Events are allocated by slabs aligned on cache lines, so that they do not
+  // cross lines and consecutive allocations are close in memory.
+  // The first one is returned and the others are pushed to the free list.
+  void *slab;
+  if (posix_memalign(&slab, 64, sizeof(clock_event) * CLOCK_EVENT_SLAB_SIZE) != 0)
+    throw std::bad_alloc();
+
+  clock_event *events = (clock_event *)slab;
+  for (int i=0; i<CLOCK_EVENT_SLAB_SIZE; i++)
+  {
+    new (&events[i]) clock_event();
+  }
+
+  for (int i=CLOCK_EVENT_SLAB_SIZE-1; i>0; i--)
+  {
+    events[i].next = this->free_events;
+    this->free_events = &events[i];
+  }
+
+  return &events[0];
+}
+
 vp::time_engine *vp::component::get_time_engine()
 {
   if (this->time_engine_ptr == NULL)
@@ -71,6 +71,8 @@ int clock_domain::build()
 
   this->traces.new_trace_event_real("cycles", &this->cycles_trace);
 
+  this->build_wheel_traces();
+
   return 0;
 }
 
@@ -81,14 +83,59 @@ void clock_domain::pre_start()
 
 
 vp::clock_engine::clock_engine(const char *config)
-  : vp::time_engine_client(config), cycles(0), period(0), freq(0), must_flush_delayed_queue(true)
+  : vp::time_engine_client(config), cycles(0), period(0), freq(0), must_flush_wheel(true)
 {
-  delayed_queue = NULL;
   for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
   {
     event_queue[i] = NULL;
   }
   current_cycle = 0;
+
+  // The upper levels of the timing wheel can be tuned per platform with the
+  // number of slots of each level. The first one has blocks of the size of the
+  // circular buffer, and each next level has blocks covering a full round of
+  // the previous one.
+  std::vector<int> level_sizes = { 64, 64, 64 };
+  js::config *levels_config = this->get_js_config()->get("wheel_levels");
+  if (levels_config != NULL)
+  {
+    level_sizes.clear();
+    for (auto x: levels_config->get_elems())
+    {
+      level_sizes.push_back(x->get_int());
+    }
+  }
+
+  if (level_sizes.size() == 0)
+    throw std::logic_error("Clock engine timing wheel must have at least one level");
+
+  int shift = __builtin_ctz(CLOCK_EVENT_QUEUE_SIZE);
+  for (auto size: level_sizes)
+  {
+    if (size < 2 || size > 64 || (size & (size - 1)) != 0)
+      throw std::logic_error("Clock engine timing wheel level size must be a power of 2 between 2 and 64 (size: " + std::to_string(size) + ")");
+
+    this->wheel_levels.push_back(new vp::clock_wheel_level(size, shift));
+    shift += __builtin_ctz(size);
+  }
+
+  js::config *partition_config = this->get_js_config()->get("partition");
+  this->partition = partition_config != NULL ? partition_config->get_int() : 0;
+
+  js::config *partition_latency_config = this->get_js_config()->get("partition_latency");
+  this->partition_latency = partition_latency_config != NULL ? partition_latency_config->get_int() : 0;
+}
+
+
+void vp::clock_engine::build_wheel_traces()
+{
+  for (unsigned int i=0; i<this->wheel_levels.size(); i++)
+  {
+    this->traces.new_trace_event_real("wheel/level_" + std::to_string(i + 1), &this->wheel_levels[i]->events_trace);
+  }
+
+  this->traces.new_trace_event_real("wheel/overflow", &this->wheel_overflow_trace);
+  this->traces.new_trace_event_real("wheel/cascaded", &this->wheel_cascade_trace);
 }
 
 
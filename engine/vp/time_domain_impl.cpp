@@ -22,6 +22,7 @@
 #include "vp/time/time_engine.hpp"
 #include <pthread.h>
 #include <signal.h>
+#include <algorithm>
 
 static pthread_t sigint_thread;
 
@@ -119,7 +120,7 @@ static void *engine_routine(void *arg) {
 }
 
 vp::time_engine::time_engine(const char *config)
-  : vp::component(config), first_client(NULL)
+  : vp::component(config), vp::time_scheduler(this)
 {
   pthread_mutex_init(&mutex, NULL);
   pthread_cond_init(&cond, NULL);
@@ -127,6 +128,103 @@ vp::time_engine::time_engine(const char *config)
 
   run_req = false;
   stop_req = false;
+
+  // This must be known before the components are built, as some of them
+  // configure their timing model from it.
+#ifndef VP_NO_TIMING
+  js::config *no_timing_conf = this->get_js_config()->get("**/gvsoc/no_timing");
+  vp::no_timing = no_timing_conf != NULL && no_timing_conf->get_bool();
+#endif
+
+  // Clock domains can be assigned to partitions which are then simulated
+  // in parallel, by quantums during which they cannot see each other. The
+  // quantum is derived from the latencies of the partition crossings, the
+  // user can only make it smaller.
+  this->partitions.push_back(this);
+
+  js::config *parallel_conf = this->get_js_config()->get("**/gvsoc/parallel");
+  if (parallel_conf != NULL && parallel_conf->get_child_bool("enabled"))
+  {
+    this->parallel = true;
+    this->nb_threads = parallel_conf->get_child_int("nb_threads");
+
+    js::config *quantum_conf = parallel_conf->get("quantum");
+    if (quantum_conf != NULL)
+    {
+      this->quantum = quantum_conf->get_int();
+      if (this->quantum <= 0)
+        throw std::logic_error("Parallel simulation quantum must be strictly positive (quantum: " + std::to_string(this->quantum) + ")");
+    }
+
+    if (this->nb_threads <= 0)
+      this->nb_threads = 1;
+
+    // Traces and events are dumped without any locking, keep everything in
+    // the engine thread. Partitions and quantums are kept so that the
+    // simulation gives the same results.
+    js::config *vcd_conf = this->get_js_config()->get("**/gvsoc/vcd/active");
+    js::config *traces_conf = this->get_js_config()->get("**/gvsoc/trace");
+    js::config *events_conf = this->get_js_config()->get("**/gvsoc/event");
+
+    if ((vcd_conf != NULL && vcd_conf->get_bool()) ||
+      (traces_conf != NULL && traces_conf->get_size() != 0) ||
+      (events_conf != NULL && events_conf->get_size() != 0))
+    {
+      this->nb_threads = 1;
+    }
+
+    pthread_mutex_init(&partitions_mutex, NULL);
+    pthread_cond_init(&partitions_cond, NULL);
+  }
+}
+
+
+vp::time_scheduler *vp::time_engine::get_scheduler(int partition)
+{
+  if (!this->parallel || partition <= 0)
+    return this;
+
+  while ((int)this->partitions.size() <= partition)
+  {
+    this->partitions.push_back(new vp::time_scheduler(this));
+  }
+
+  return this->partitions[partition];
+}
+
+
+void vp::time_engine::add_partition_crossing(vp::clock_engine *clock)
+{
+  if (std::find(this->partition_crossings.begin(), this->partition_crossings.end(), clock) == this->partition_crossings.end())
+  {
+    this->partition_crossings.push_back(clock);
+  }
+}
+
+
+// A request or value crossing partitions takes effect at the end of the
+// quantum, which must then not be later than the latency modeled by the
+// interconnect for it. This is computed again for each quantum since clock
+// domains can change their frequency. Stopped clock domains do not constrain
+// the quantum as they do not handle anything.
+int64_t vp::time_engine::get_partition_quantum()
+{
+  int64_t quantum = this->quantum;
+
+  for (vp::clock_engine *clock: this->partition_crossings)
+  {
+    int64_t period = clock->get_period();
+    if (period > 0)
+      quantum = std::min(quantum, clock->get_partition_latency() * period);
+  }
+
+  if (quantum == INT64_MAX)
+  {
+    this->fatal("Parallel simulation quantum can not be derived as no partition crossing is clocked, it must be specified with gvsoc/parallel/quantum\n");
+    return -1;
+  }
+
+  return quantum;
 }
 
 
@@ -212,7 +310,7 @@ void vp::time_engine::start()
 
 void vp::time_engine::wait_ready()
 {
-  while (!first_client)
+  while (!this->get_first_client())
   {
   }
 }
@@ -251,15 +349,34 @@ void vp::time_engine::run_loop()
       pthread_create(&sigint_thread, NULL, signal_routine, (void *)this);
 
       signal (SIGINT, sigint_handler);
+
+      // Partition threads are created after SIGINT is blocked so that they
+      // inherit it.
+      if (this->parallel && this->partitions.size() > 1)
+      {
+        int nb_threads = std::min(this->nb_threads, (int)this->partitions.size());
+        for (int i=1; i<nb_threads; i++)
+        {
+          pthread_t thread;
+          pthread_create(&thread, NULL, partition_thread_stub, (void *)this);
+          this->partition_threads.push_back(thread);
+        }
+      }
     }
 
     pthread_mutex_unlock(&mutex);
 
-    time_engine_client *current = first_client;
+    time_engine_client *current = NULL;
+
+#ifndef __VP_USE_SYSTEMC
+    if (this->partitions.size() > 1)
+      this->run_partitions();
+    else
+#endif
+      current = this->heap_pop();
 
     if (current)
     {
-      first_client = current->next;
       current->is_enqueued = false;
 
       // Update the global engine time with the current event time
@@ -285,19 +402,7 @@ void vp::time_engine::run_loop()
         {
           time += this->time;
           current->next_event_time = time;
-          time_engine_client *client = first_client, *prev = NULL;
-
-          while (client && client->next_event_time < time)
-          {
-            prev = client;
-            client = client->next;
-          }
-          if (prev)
-            prev->next = current;
-          else
-            first_client = current;
-
-          current->next = client;
+          this->heap_push(current);
           current->is_enqueued = true;
         }
 
@@ -308,6 +413,8 @@ void vp::time_engine::run_loop()
         // enqueues a new event.
         while(1)
         {
+          time_engine_client *first_client = this->get_first_client();
+
           if (!first_client)
           {
             if (stop_req || locked) {
@@ -331,12 +438,11 @@ void vp::time_engine::run_loop()
           }
         }
 
-        current = first_client;
+        current = this->heap_pop();
         if (current)
         {
-          vp_assert(first_client->next_event_time >= get_time(), NULL, "event time is before vp time\n");
+          vp_assert(current->next_event_time >= get_time(), NULL, "event time is before vp time\n");
 
-          first_client = current->next;
           current->is_enqueued = false;
         }
 
@@ -344,7 +450,7 @@ void vp::time_engine::run_loop()
     
         int64_t time = current->exec();
 
-        time_engine_client *next = first_client;
+        time_engine_client *next = this->get_first_client();
 
         // Shortcut to quickly continue with the same client
         if (likely(time > 0))
@@ -359,9 +465,8 @@ void vp::time_engine::run_loop()
             }
             else
             {
-              current->next = first_client;
-              first_client = current;
               current->next_event_time = time;
+              this->heap_push(current);
               current->is_enqueued = true;
               current->running = false;
               break;
@@ -369,34 +474,36 @@ void vp::time_engine::run_loop()
           }
         }
 
-        // Otherwise remove it, reenqueue it and continue with the next one.
+        // Otherwise reenqueue it and continue with the next one.
         // We can optimize a bit the operation as we already know
-        // who to schedule next.
+        // who to schedule next, by directly replacing it in the heap.
+
+        current->running = false;
 
         if (time > 0)
         {
           current->next_event_time = time;
-          time_engine_client *client = next->next, *prev = next;
-          while (client && client->next_event_time < time)
+          current->is_enqueued = true;
+
+          if (!run_req)
           {
-            prev = client;
-            client = client->next;
+            this->heap_push(current);
+            break;
           }
-          current->next = client;
-          prev->next = current;
-          current->is_enqueued = true;
-        }
 
-        current->running = false;
+          current = this->heap_replace_first(current);
+        }
+        else
+        {
+          if (!run_req) break;
 
-        if (!run_req) break;
+          current = this->heap_pop();
+        }
 
-        current = first_client;
         if (current)
         {
-          vp_assert(first_client->next_event_time >= get_time(), NULL, "event time is before vp time\n");
+          vp_assert(current->next_event_time >= get_time(), NULL, "event time is before vp time\n");
 
-          first_client = current->next;
           current->is_enqueued = false;
         }
 
@@ -414,7 +521,7 @@ void vp::time_engine::run_loop()
 
     running = false;
 
-    while(!first_client && retain_count && !locked)
+    while(!this->has_clients() && retain_count && !locked)
     {
 #ifdef __VP_USE_SYSTEMC
       pthread_mutex_unlock(&mutex);
@@ -425,9 +532,7 @@ void vp::time_engine::run_loop()
 #endif
     }
 
-    current = first_client;
-
-    if (first_client == NULL && !locked && !retain_count)
+    if (!this->has_clients() && !locked && !retain_count)
     {
 #ifdef __VP_USE_SYSTEMC
       sc_stop();
@@ -441,6 +546,189 @@ void vp::time_engine::run_loop()
 
 
 
+bool vp::time_engine::has_clients()
+{
+  for (auto partition: this->partitions)
+  {
+    if (partition->get_first_client())
+      return true;
+  }
+  return false;
+}
+
+
+void vp::time_scheduler::run_until(int64_t limit)
+{
+  time_scheduler::current = this;
+  this->limit = limit;
+
+  while (1)
+  {
+    time_engine_client *current = this->get_first_client();
+    if (current == NULL || current->next_event_time >= limit)
+      break;
+
+    this->heap_pop();
+    current->is_enqueued = false;
+    current->running = true;
+    this->time = current->next_event_time;
+
+    while (1)
+    {
+      int64_t time = current->exec();
+
+      if (time > 0)
+      {
+        // Shortcut to quickly continue with the same client
+        time += this->time;
+        time_engine_client *next = this->get_first_client();
+        if (time < limit && (!next || next->next_event_time >= time))
+        {
+          this->time = time;
+          continue;
+        }
+
+        current->next_event_time = time;
+        current->is_enqueued = true;
+        this->heap_push(current);
+      }
+
+      current->running = false;
+      break;
+    }
+  }
+
+  this->limit = INT64_MAX;
+  time_scheduler::current = NULL;
+}
+
+
+// Run the partitions assigned to the specified thread up to the end of the
+// quantum.
+void vp::time_engine::run_partitions_share(int thread_id, int64_t limit)
+{
+  int nb_threads = this->partition_threads.size() + 1;
+
+  for (unsigned int i=thread_id; i<this->partitions.size(); i+=nb_threads)
+  {
+    this->partitions[i]->run_until(limit);
+  }
+}
+
+
+void *vp::time_engine::partition_thread_stub(void *arg)
+{
+  vp::time_engine *engine = (vp::time_engine *)arg;
+  static std::atomic<int> thread_id{1};
+  engine->partition_thread_routine(thread_id++);
+  return NULL;
+}
+
+
+void vp::time_engine::partition_thread_routine(int thread_id)
+{
+  int64_t quantum_id = 0;
+
+  while (1)
+  {
+    pthread_mutex_lock(&this->partitions_mutex);
+    while (this->partitions_quantum_id == quantum_id)
+    {
+      pthread_cond_wait(&this->partitions_cond, &this->partitions_mutex);
+    }
+    quantum_id = this->partitions_quantum_id;
+    int64_t limit = this->partitions_limit;
+    pthread_mutex_unlock(&this->partitions_mutex);
+
+    this->run_partitions_share(thread_id, limit);
+
+    pthread_mutex_lock(&this->partitions_mutex);
+    if (--this->partitions_pending == 0)
+      pthread_cond_broadcast(&this->partitions_cond);
+    pthread_mutex_unlock(&this->partitions_mutex);
+  }
+}
+
+
+// Messages are delivered partition after partition, in the order they were
+// posted, so that the result does not depend on how partitions were
+// scheduled on threads. Messages posted during the delivery are delivered
+// the same way until there is none.
+void vp::time_engine::deliver_partition_messages()
+{
+  bool delivered = true;
+
+  while (delivered)
+  {
+    delivered = false;
+
+    for (auto partition: this->partitions)
+    {
+      std::vector<std::pair<time_scheduler *, std::function<void()>>> outbox;
+      outbox.swap(partition->outbox);
+
+      for (auto &message: outbox)
+      {
+        time_scheduler::current = message.first;
+        message.second();
+        delivered = true;
+      }
+    }
+  }
+
+  time_scheduler::current = NULL;
+}
+
+
+// Partitions are executed by quantums starting at the first pending event.
+// Stop requests are only taken into account between quantums so that all
+// partitions are always at the same time when the engine is stopped.
+void vp::time_engine::run_partitions()
+{
+  while (this->run_req)
+  {
+    int64_t start = INT64_MAX;
+    for (auto partition: this->partitions)
+    {
+      time_engine_client *first = partition->get_first_client();
+      if (first && first->next_event_time < start)
+        start = first->next_event_time;
+    }
+
+    if (start == INT64_MAX)
+      break;
+
+    int64_t quantum = this->get_partition_quantum();
+    if (quantum < 0)
+      break;
+
+    int64_t limit = start + quantum;
+
+    pthread_mutex_lock(&this->partitions_mutex);
+    this->partitions_limit = limit;
+    this->partitions_pending = this->partition_threads.size();
+    this->partitions_quantum_id++;
+    pthread_cond_broadcast(&this->partitions_cond);
+    pthread_mutex_unlock(&this->partitions_mutex);
+
+    this->run_partitions_share(0, limit);
+
+    pthread_mutex_lock(&this->partitions_mutex);
+    while (this->partitions_pending)
+    {
+      pthread_cond_wait(&this->partitions_cond, &this->partitions_mutex);
+    }
+    pthread_mutex_unlock(&this->partitions_mutex);
+
+    for (auto partition: this->partitions)
+    {
+      partition->time = limit;
+    }
+
+    this->deliver_partition_messages();
+  }
+}
+
 
 static void init_sigint_handler(int s) {
   raise(SIGTERM);
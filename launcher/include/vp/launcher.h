@@ -24,8 +24,12 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// The default is the timed mode, so that a zero-initialized configuration
+// keeps it. GV_CONF_NO_TIMING is the former name of the default.
 typedef enum {
-  GV_CONF_NO_TIMING = 0
+  GV_CONF_TIMING = 0,
+  GV_CONF_NO_TIMING = GV_CONF_TIMING,
+  GV_CONF_FUNCTIONAL = 1
 } gv_conf_timing_e;
 
 typedef struct {
@@ -40,6 +40,7 @@ typedef struct {
   char **opts;
   int nb_opt;
   char *config_file;
+  gv_conf_timing_e timing;
 } gv_launcher_t;
 
 typedef struct {
@@ -56,7 +57,7 @@ static pid_t child_id = -1;
 
 void gv_init(gv_conf_t *gv_conf)
 {
-  gv_conf->timing = GV_CONF_NO_TIMING;
+  gv_conf->timing = GV_CONF_TIMING;
 }
 
 static void add_option(gv_launcher_t *gv, char *opt) {
@@ -73,6 +74,7 @@ void *gv_create(gv_conf_t *gv_conf, char *config_file)
   gv->opts = NULL;
   gv->nb_opt = 0;
   gv->config_file = strdup(config_file);
+  gv->timing = gv_conf->timing;
 
   add_option(gv, (char *)"pulp-run");
 
@@ -84,6 +86,8 @@ static void gv_process(gv_launcher_t *gv)
   add_option(gv, (char *)"--platform=gvsoc");
   add_option(gv, (char *)"--config-file");
   add_option(gv, gv->config_file);
+  if (gv->timing == GV_CONF_FUNCTIONAL)
+    add_option(gv, (char *)"--no-timing");
   add_option(gv, NULL);
   //close(gv->snd_pipe[1]);
   //close(gv->rcv_pipe[0]);
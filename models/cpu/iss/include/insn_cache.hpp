@@ -26,4 +26,10 @@ void iss_cache_flush(iss_t *iss);
 iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc);
 iss_insn_t *insn_cache_get_decoded(iss_t *iss, iss_addr_t pc);
 
+// Compute the number of instructions of the superblock starting at the
+// specified decoded instruction, i.e. the straight-line run ending at the first
+// branch, hardware loop end or stalling instruction, with at most max_size
+// instructions.
+int insn_cache_superblock(iss_t *iss, iss_insn_t *insn, int max_size);
+
 #endif
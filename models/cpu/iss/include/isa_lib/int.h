@@ -23,6 +23,7 @@
 #include <strings.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "isa_lib/vec.h"
 #define MAX(a,b) ((a)>=(b)?(a):(b))
 #define MIN(a,b) ((a)<=(b)?(a):(b))
 
@@ -413,65 +414,23 @@ static inline type lib_VEC_##operName##_SC_##elemType##_to_##type(iss_cpu_state_
   return out;                                                                           \
 }
 
-#define VEC_OP_DIV2(operName, type, elemType, elemSize, num_elem, oper)                \
-static inline type lib_VEC_##operName##_##elemType##_to_##type##_div2(iss_cpu_state_t *s, type a, type b) {  \
-  elemType *tmp_a = (elemType*)&a;                                                \
-  elemType *tmp_b = (elemType*)&b;                                                \
-  type out;                                                                       \
-  elemType *tmp_out = (elemType*)&out;                                            \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    tmp_out[i] = ((elemType)(tmp_a[i] oper tmp_b[i]))>>1;                         \
-  return out;                                                                     \
-}
-
-#define VEC_OP_DIV4(operName, type, elemType, elemSize, num_elem, oper)                \
-static inline type lib_VEC_##operName##_##elemType##_to_##type##_div4(iss_cpu_state_t *s, type a, type b) {  \
-  elemType *tmp_a = (elemType*)&a;                                                \
-  elemType *tmp_b = (elemType*)&b;                                                \
-  type out;                                                                       \
-  elemType *tmp_out = (elemType*)&out;                                            \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    tmp_out[i] = ((elemType)(tmp_a[i] oper tmp_b[i]))>>2;                         \
-  return out;                                                                     \
-}
-
-#define VEC_OP_DIV8(operName, type, elemType, elemSize, num_elem, oper)                \
-static inline type lib_VEC_##operName##_##elemType##_to_##type##_div8(iss_cpu_state_t *s, type a, type b) {  \
-  elemType *tmp_a = (elemType*)&a;                                                \
-  elemType *tmp_b = (elemType*)&b;                                                \
-  type out;                                                                       \
-  elemType *tmp_out = (elemType*)&out;                                            \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    tmp_out[i] = ((elemType)(tmp_a[i] oper tmp_b[i]))>>3;                         \
-  return out;                                                                     \
-}
-
-#define VEC_EXPR(operName, type, elemType, elemSize, num_elem, expr)                \
+// Operations implemented in vec.h, which uses host SIMD instructions when
+// available
+#define VEC_SIMD(operName, type, elemType, width, name)                                \
 static inline type lib_VEC_##operName##_##elemType##_to_##type(iss_cpu_state_t *s, type a, type b) {  \
-  elemType *tmp_a = (elemType*)&a;                                                \
-  elemType *tmp_b = (elemType*)&b;                                                \
-  type out;                                                                       \
-  elemType *tmp_out = (elemType*)&out;                                            \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    tmp_out[i] = expr;                                                            \
-  return out;                                                                     \
+  return vec_##name(a, b);                                                        \
+}                                                                                 \
+                                                                                  \
+static inline type lib_VEC_##operName##_SC_##elemType##_to_##type(iss_cpu_state_t *s, type a, elemType b) { \
+  return vec_##name(a, vec_splat_##width(b));                                           \
 }
 
-#define VEC_EXPR_SC(operName, type, elemType, elemSize, num_elem, expr)                \
-static inline type lib_VEC_##operName##_SC_##elemType##_to_##type(iss_cpu_state_t *s, type a, elemType b) { \
-  elemType *tmp_a = (elemType*)&a;                                                      \
-  type out;                                                                             \
-  elemType *tmp_out = (elemType*)&out;                                                  \
-  int i;                                                                                \
-  for (i = 0; i < num_elem; i++)                                                        \
-    tmp_out[i] = expr;                                                                  \
-  return out;                                                                           \
+#define VEC_SIMD_DIV(operName, type, elemType, div, name)                              \
+static inline type lib_VEC_##operName##_##elemType##_to_##type##_div##div(iss_cpu_state_t *s, type a, type b) {  \
+  return vec_##name(a, b);                                                        \
 }
 
+
 #define VEC_CMP(operName, type, elemType, elemSize, num_elem, oper)                   \
 static inline type lib_VEC_CMP##operName##_##elemType##_to_##type(iss_cpu_state_t *s, type a, type b) {  \
   elemType *tmp_a = (elemType*)&a;                                                    \
@@ -672,66 +631,48 @@ VEC_CMP(NE, int32_t, int16_t, 2, 2, !=)
 
 
 
-VEC_OP(ADD, int32_t, int8_t, 1, 4, +)
-VEC_OP_DIV2(ADD, int32_t, int8_t, 1, 4, +)
-VEC_OP_DIV4(ADD, int32_t, int8_t, 1, 4, +)
-VEC_OP(ADD, int32_t, int16_t, 2, 2, +)
-VEC_OP_DIV2(ADD, int32_t, int16_t, 2, 2, +)
-VEC_OP_DIV4(ADD, int32_t, int16_t, 2, 2, +)
-VEC_OP_DIV8(ADD, int32_t, int16_t, 2, 2, +)
+VEC_SIMD(ADD, int32_t, int8_t, 8, add_8)
+VEC_SIMD_DIV(ADD, int32_t, int8_t, 2, add_div2_8)
+VEC_SIMD_DIV(ADD, int32_t, int8_t, 4, add_div4_8)
+VEC_SIMD(ADD, int32_t, int16_t, 16, add_16)
+VEC_SIMD_DIV(ADD, int32_t, int16_t, 2, add_div2_16)
+VEC_SIMD_DIV(ADD, int32_t, int16_t, 4, add_div4_16)
+VEC_SIMD_DIV(ADD, int32_t, int16_t, 8, add_div8_16)
 
-VEC_OP(SUB, int32_t, int8_t, 1, 4, -)
-VEC_OP_DIV2(SUB, int32_t, int8_t, 1, 4, -)
-VEC_OP_DIV4(SUB, int32_t, int8_t, 1, 4, -)
-VEC_OP(SUB, int32_t, int16_t, 2, 2, -)
-VEC_OP_DIV2(SUB, int32_t, int16_t, 2, 2, -)
-VEC_OP_DIV4(SUB, int32_t, int16_t, 2, 2, -)
-VEC_OP_DIV8(SUB, int32_t, int16_t, 2, 2, -)
+VEC_SIMD(SUB, int32_t, int8_t, 8, sub_8)
+VEC_SIMD_DIV(SUB, int32_t, int8_t, 2, sub_div2_8)
+VEC_SIMD_DIV(SUB, int32_t, int8_t, 4, sub_div4_8)
+VEC_SIMD(SUB, int32_t, int16_t, 16, sub_16)
+VEC_SIMD_DIV(SUB, int32_t, int16_t, 2, sub_div2_16)
+VEC_SIMD_DIV(SUB, int32_t, int16_t, 4, sub_div4_16)
+VEC_SIMD_DIV(SUB, int32_t, int16_t, 8, sub_div8_16)
 
-VEC_EXPR(AVG, int32_t, int8_t, 1, 4, ((int8_t)(tmp_a[i] + tmp_b[i])>>(int8_t)1))
-VEC_EXPR(AVG, int32_t, int16_t, 2, 2, ((int16_t)(tmp_a[i] + tmp_b[i])>>(int16_t)1))
-VEC_EXPR_SC(AVG, int32_t, int8_t, 1, 4, ((int8_t)(tmp_a[i] + b)>>(int8_t)1))
-VEC_EXPR_SC(AVG, int32_t, int16_t, 2, 2, ((int16_t)(tmp_a[i] + b)>>(int16_t)1))
+VEC_SIMD(AVG, int32_t, int8_t, 8, add_div2_8)
+VEC_SIMD(AVG, int32_t, int16_t, 16, add_div2_16)
 
-VEC_EXPR(AVGU, uint32_t, uint8_t, 1, 4, ((uint8_t)(tmp_a[i] + tmp_b[i])>>(uint8_t)1))
-VEC_EXPR(AVGU, uint32_t, uint16_t, 2, 2, ((uint16_t)(tmp_a[i] + tmp_b[i])>>(uint16_t)1))
-VEC_EXPR_SC(AVGU, uint32_t, uint8_t, 1, 4, ((uint8_t)(tmp_a[i] + b)>>(uint8_t)1))
-VEC_EXPR_SC(AVGU, uint32_t, uint16_t, 2, 2, ((uint16_t)(tmp_a[i] + b)>>(uint16_t)1))
+VEC_SIMD(AVGU, uint32_t, uint8_t, 8, avgu_8)
+VEC_SIMD(AVGU, uint32_t, uint16_t, 16, avgu_16)
 
-VEC_EXPR(MIN, int32_t, int8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
-VEC_EXPR(MIN, int32_t, int16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
-VEC_EXPR_SC(MIN, int32_t, int8_t, 1, 4, (tmp_a[i]>b ? b : tmp_a[i]))
-VEC_EXPR_SC(MIN, int32_t, int16_t, 2, 2, (tmp_a[i]>b ? b : tmp_a[i]))
+VEC_SIMD(MIN, int32_t, int8_t, 8, min_8)
+VEC_SIMD(MIN, int32_t, int16_t, 16, min_16)
 
-VEC_EXPR(MINU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
-VEC_EXPR(MINU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
-VEC_EXPR_SC(MINU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>b ? b : tmp_a[i]))
-VEC_EXPR_SC(MINU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>b ? b : tmp_a[i]))
+VEC_SIMD(MINU, uint32_t, uint8_t, 8, minu_8)
+VEC_SIMD(MINU, uint32_t, uint16_t, 16, minu_16)
 
-VEC_EXPR(MAX, int32_t, int8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
-VEC_EXPR(MAX, int32_t, int16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
-VEC_EXPR_SC(MAX, int32_t, int8_t, 1, 4, (tmp_a[i]>b ? tmp_a[i] : b))
-VEC_EXPR_SC(MAX, int32_t, int16_t, 2, 2, (tmp_a[i]>b ? tmp_a[i] : b))
+VEC_SIMD(MAX, int32_t, int8_t, 8, max_8)
+VEC_SIMD(MAX, int32_t, int16_t, 16, max_16)
 
-VEC_EXPR(MAXU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
-VEC_EXPR(MAXU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
-VEC_EXPR_SC(MAXU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>b ? tmp_a[i] : b))
-VEC_EXPR_SC(MAXU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>b ? tmp_a[i] : b))
+VEC_SIMD(MAXU, uint32_t, uint8_t, 8, maxu_8)
+VEC_SIMD(MAXU, uint32_t, uint16_t, 16, maxu_16)
 
-VEC_EXPR(SRL, uint32_t, uint8_t, 1, 4, (tmp_a[i] >> (tmp_b[i] & 0x7)))
-VEC_EXPR_SC(SRL, uint32_t, uint8_t, 1, 4, (tmp_a[i] >> (b & 0x7)))
-VEC_EXPR(SRL, uint32_t, uint16_t, 1, 2, (tmp_a[i] >> (tmp_b[i] & 0xF)))
-VEC_EXPR_SC(SRL, uint32_t, uint16_t, 1, 2, (tmp_a[i] >> (b & 0xF)))
+VEC_SIMD(SRL, uint32_t, uint8_t, 8, srl_8)
+VEC_SIMD(SRL, uint32_t, uint16_t, 16, srl_16)
 
-VEC_EXPR(SRA, int32_t, int8_t, 1, 4, (tmp_a[i] >> (tmp_b[i] & 0x7)))
-VEC_EXPR_SC(SRA, int32_t, int8_t, 1, 4, (tmp_a[i] >> (b & 0x7)))
-VEC_EXPR(SRA, int32_t, int16_t, 1, 2, (tmp_a[i] >> (tmp_b[i] & 0xF)))
-VEC_EXPR_SC(SRA, int32_t, int16_t, 1, 2, (tmp_a[i] >> (b & 0xF)))
+VEC_SIMD(SRA, int32_t, int8_t, 8, sra_8)
+VEC_SIMD(SRA, int32_t, int16_t, 16, sra_16)
 
-VEC_EXPR(SLL, uint32_t, uint8_t, 1, 4, (tmp_a[i] << (tmp_b[i] & 0x7)))
-VEC_EXPR_SC(SLL, uint32_t, uint8_t, 1, 4, (tmp_a[i] << (b & 0x7)))
-VEC_EXPR(SLL, uint32_t, uint16_t, 1, 2, (tmp_a[i] << (tmp_b[i] & 0xF)))
-VEC_EXPR_SC(SLL, uint32_t, uint16_t, 1, 2, (tmp_a[i] << (b & 0xF)))
+VEC_SIMD(SLL, uint32_t, uint8_t, 8, sll_8)
+VEC_SIMD(SLL, uint32_t, uint16_t, 16, sll_16)
 
 VEC_OP(MUL, int32_t, int8_t, 1, 4, *)
 VEC_OP(MUL, int32_t, int16_t, 2, 2, *)
@@ -821,10 +762,7 @@ static inline unsigned int getShuffleHalf(unsigned int a, unsigned int b, unsign
 }
 
 static inline unsigned int lib_VEC_SHUFFLE_16(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
-  return getShuffleHalf(a, b, 16) | getShuffleHalf(a, b, 0);
-  unsigned int low = b & 1 ? a >> 16 : a & 0xffff;
-  unsigned int high = b & (1<<16) ? a >> 16 : a & 0xffff;
-  return low | (high << 16);
+  return vec_shuffle_16(a, b);
 }
 
 static inline unsigned int getShuffleHalfSci(unsigned int a, unsigned int b, unsigned int pos) {
@@ -843,7 +781,7 @@ static inline unsigned int getShuffleByte(unsigned int a, unsigned int b, unsign
 }
 
 static inline unsigned int lib_VEC_SHUFFLE_8(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
-  return getShuffleByte(a, b, 24) | getShuffleByte(a, b, 16) | getShuffleByte(a, b, 8) | getShuffleByte(a, b, 0);
+  return vec_shuffle_8(a, b);
 }
 
 static inline unsigned int getShuffleByteSci(unsigned int a, unsigned int b, unsigned int pos) {
@@ -873,19 +811,11 @@ static inline unsigned int lib_VEC_SHUFFLEI3_SCI_8(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_VEC_SHUFFLE2_16(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c) {
-#ifdef RISCV
-  return getShuffleHalf(b&(1<<17)?a:c, b, 16) | getShuffleHalf(b&(1<<1)?a:c, b, 0);
-#else
-  return getShuffleHalf(b&(1<<17)?c:a, b, 16) | getShuffleHalf(b&(1<<1)?c:a, b, 0);
-#endif
+  return vec_shuffle2_16(a, b, c);
 }
 
 static inline unsigned int lib_VEC_SHUFFLE2_8(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c) {
-#ifdef RISCV
-  return getShuffleByte(b&(1<<26)?a:c, b, 24) | getShuffleByte(b&(1<<18)?a:c, b, 16) | getShuffleByte(b&(1<<10)?a:c, b, 8) | getShuffleByte(b&(1<<2)?a:c, b, 0);
-#else
-  return getShuffleByte(b&(1<<26)?c:a, b, 24) | getShuffleByte(b&(1<<18)?c:a, b, 16) | getShuffleByte(b&(1<<10)?c:a, b, 8) | getShuffleByte(b&(1<<2)?c:a, b, 0);
-#endif
+  return vec_shuffle2_8(a, b, c);
 }
 
 static inline unsigned int lib_VEC_PACK_SC_16(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
@@ -901,65 +831,43 @@ static inline unsigned int lib_VEC_PACKLO_SC_8(iss_cpu_state_t *s, unsigned int
 }
 
 
-#define VEC_DOTP(operName, typeOut, typeA, typeB, elemTypeA, elemTypeB, elemSize, num_elem, oper)                \
+#define VEC_DOTP(operName, typeOut, typeA, typeB, elemSize, width)                \
 static inline typeOut lib_VEC_##operName##_##elemSize(iss_cpu_state_t *s, typeA a, typeB b) {  \
-  elemTypeA *tmp_a = (elemTypeA*)&a;                                                \
-  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
-  typeOut out = 0;                                                                       \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    out += tmp_a[i] oper tmp_b[i];                                          \
-  return out;                                                                     \
+  return vec_##width(a, b);                                                       \
 }                                                                                 \
                                                                                   \
 static inline typeOut lib_VEC_##operName##_SC_##elemSize(iss_cpu_state_t *s, typeA a, typeB b) { \
-  elemTypeA *tmp_a = (elemTypeA*)&a;                                                      \
-  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
-  typeOut out = 0;                                                                             \
-  int i;                                                                                \
-  for (i = 0; i < num_elem; i++)                                                        \
-    out += tmp_a[i] oper tmp_b[0];                                                       \
-  return out;                                                                           \
+  return vec_##width(a, vec_splat_##elemSize(b));                                 \
 }
 
-VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, int16_t, int16_t, 16, 2, *)
-VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, int8_t, int8_t, 8, 4, *)
+VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, 16, dotsp_16)
+VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, 8, dotsp_8)
 
-VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t, 16, 2, *)
-VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, uint8_t, uint8_t, 8, 4, *)
+VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, 16, dotup_16)
+VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, 8, dotup_8)
 
-VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, uint16_t, int16_t, 16, 2, *)
-VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, uint8_t, int8_t, 8, 4, *)
+VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, 16, dotusp_16)
+VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, 8, dotusp_8)
 
 
 
-#define VEC_SDOT(operName, typeOut, typeA, typeB, elemTypeA, elemTypeB, elemSize, num_elem, oper)                \
+#define VEC_SDOT(operName, typeOut, typeA, typeB, elemSize, width)                \
 static inline typeOut lib_VEC_##operName##_##elemSize(iss_cpu_state_t *s, typeOut out, typeA a, typeB b) {  \
-  elemTypeA *tmp_a = (elemTypeA*)&a;                                                \
-  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
-  int i;                                                                          \
-  for (i = 0; i < num_elem; i++)                                                  \
-    out += tmp_a[i] oper tmp_b[i];                                          \
-  return out;                                                                     \
+  return out + vec_##width(a, b);                                                 \
 }                                                                                 \
                                                                                   \
 static inline typeOut lib_VEC_##operName##_SC_##elemSize(iss_cpu_state_t *s, typeOut out, typeA a, typeB b) { \
-  elemTypeA *tmp_a = (elemTypeA*)&a;                                                      \
-  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
-  int i;                                                                                \
-  for (i = 0; i < num_elem; i++)                                                        \
-    out += tmp_a[i] oper tmp_b[0];                                                       \
-  return out;                                                                           \
+  return out + vec_##width(a, vec_splat_##elemSize(b));                           \
 }
 
-VEC_SDOT(SDOTSP, int32_t, int32_t, int32_t, int16_t, int16_t, 16, 2, *)
-VEC_SDOT(SDOTSP, int32_t, int32_t, int32_t, int8_t, int8_t, 8, 4, *)
+VEC_SDOT(SDOTSP, int32_t, int32_t, int32_t, 16, dotsp_16)
+VEC_SDOT(SDOTSP, int32_t, int32_t, int32_t, 8, dotsp_8)
 
-VEC_SDOT(SDOTUP, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t, 16, 2, *)
-VEC_SDOT(SDOTUP, uint32_t, uint32_t, uint32_t, uint8_t, uint8_t, 8, 4, *)
+VEC_SDOT(SDOTUP, uint32_t, uint32_t, uint32_t, 16, dotup_16)
+VEC_SDOT(SDOTUP, uint32_t, uint32_t, uint32_t, 8, dotup_8)
 
-VEC_SDOT(SDOTUSP, int32_t, uint32_t, int32_t, uint16_t, int16_t, 16, 2, *)
-VEC_SDOT(SDOTUSP, int32_t, uint32_t, int32_t, uint8_t, int8_t, 8, 4, *)
+VEC_SDOT(SDOTUSP, int32_t, uint32_t, int32_t, 16, dotusp_16)
+VEC_SDOT(SDOTUSP, int32_t, uint32_t, int32_t, 8, dotusp_8)
 
 
 /*
@@ -1325,21 +1233,21 @@ static inline unsigned int lib_VEC_PACK_SC_HL_16(iss_cpu_state_t *s, unsigned in
 
 #define FF_EXEC_1(s, name, a, e, m) \
   FF_INIT_(a, e, m) \
-  feclearexcept(FE_ALL_EXCEPT); \
+  lib_ff_clear_fenv(s); \
   name(&ff_res, &ff_a); \
   update_fflags_fenv(s); \
   return flexfloat_get_bits(&ff_res);
 
 #define FF_EXEC_2(s, name, a, b, e, m) \
   FF_INIT_2(a, b, e, m) \
-  feclearexcept(FE_ALL_EXCEPT); \
+  lib_ff_clear_fenv(s); \
   name(&ff_res, &ff_a, &ff_b); \
   update_fflags_fenv(s); \
   return flexfloat_get_bits(&ff_res);
 
 #define FF_EXEC_3(s, name, a, b, c, e, m) \
   FF_INIT_3(a, b, c, e, m) \
-  feclearexcept(FE_ALL_EXCEPT); \
+  lib_ff_clear_fenv(s); \
   name(&ff_res, &ff_a, &ff_b, &ff_c); \
   update_fflags_fenv(s); \
   return flexfloat_get_bits(&ff_res);
@@ -1366,6 +1274,86 @@ static inline void update_fflags_fenv(iss_cpu_state_t *s)
   set_fflags(s, flags);
 }
 
+// Native binary32 operations leave the host exception flags and rounding mode
+// pending while the core owns the host floating-point environment. This folds
+// the pending flags into fflags and gives the environment back with the default
+// rounding mode, it must be called before anything else uses the host fenv.
+static inline void lib_float_host_release(iss_cpu_state_t *s)
+{
+  if (unlikely(s->fp_host_owned))
+  {
+    update_fflags_fenv(s);
+    if (s->fp_host_round != 0)
+      fesetround(FE_TONEAREST);
+    s->fp_host_owned = false;
+  }
+}
+
+// Used by the flexfloat operations instead of clearing the host flags directly
+// so that flags pending from native operations are not lost
+static inline void lib_ff_clear_fenv(iss_cpu_state_t *s)
+{
+  lib_float_host_release(s);
+  feclearexcept(FE_ALL_EXCEPT);
+}
+
+#define FLOAT32_CANONICAL_NAN 0x7fc00000
+
+static inline float lib_float32_get(unsigned int a)
+{
+  union { unsigned int i; float f; } u = { a };
+  return u.f;
+}
+
+static inline unsigned int lib_float32_set(float f)
+{
+  union { float f; unsigned int i; } u = { f };
+  // RISC-V always produces the canonical NaN
+  if (unlikely((u.i & 0x7fffffff) > 0x7f800000))
+    return FLOAT32_CANONICAL_NAN;
+  return u.i;
+}
+
+static inline bool lib_float32_is_nan(unsigned int a)
+{
+  return (a & 0x7fffffff) > 0x7f800000;
+}
+
+static inline bool lib_float32_is_snan(unsigned int a)
+{
+  return lib_float32_is_nan(a) && !(a & 0x00400000);
+}
+
+// Takes ownership of the host environment and makes its rounding mode follow
+// the instruction one. Returns false for modes the host does not implement,
+// which are then handled by flexfloat.
+static inline bool lib_float32_acquire(iss_cpu_state_t *s, unsigned int round)
+{
+  static const int host_modes[] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD };
+
+  if (round == 7)
+    round = s->fcsr.frm;
+
+  if (unlikely(round > 3))
+    return false;
+
+  if (unlikely(!s->fp_host_owned))
+  {
+    // Whatever is in the host flags has been raised by someone else
+    feclearexcept(FE_ALL_EXCEPT);
+    s->fp_host_owned = true;
+    s->fp_host_round = 0;
+  }
+
+  if (unlikely(round != s->fp_host_round))
+  {
+    fesetround(host_modes[round]);
+    s->fp_host_round = round;
+  }
+
+  return true;
+}
+
 // Inspired by https://stackoverflow.com/a/38470183
 // TODO PROPER ROUNDING WITH FLAGS
 static inline int32_t double_to_int (double dbl) {
@@ -1419,6 +1407,8 @@ static inline uint64_t double_to_ulong (double dbl) {
   }
 }
 
+#include "isa_lib/sfloat.h"
+
 static inline unsigned int lib_flexfloat_add(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
   FF_EXEC_2(s, ff_add, a, b, e, m)
 }
@@ -1439,7 +1429,7 @@ static inline unsigned int lib_flexfloat_avg(iss_cpu_state_t *s, unsigned int a,
   FF_INIT_2(a, b, e, m)
   flexfloat_t ff_two;
   ff_init_int(&ff_two, 2, (flexfloat_desc_t) {e,m});
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_add(&ff_res, &ff_a, &ff_b);
   ff_div(&ff_res, &ff_res, &ff_two);
   update_fflags_fenv(s);
@@ -1449,7 +1439,7 @@ static inline unsigned int lib_flexfloat_avg(iss_cpu_state_t *s, unsigned int a,
 // TODO proper flags
 static inline unsigned int lib_flexfloat_itof(iss_cpu_state_t *s, unsigned int a, uint8_t e, uint8_t m) {
   flexfloat_t ff_a;
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_init_int(&ff_a, a, (flexfloat_desc_t) {e,m});
   update_fflags_fenv(s);
   return flexfloat_get_bits(&ff_a);
@@ -1472,7 +1462,7 @@ static inline unsigned int lib_flexfloat_madd(iss_cpu_state_t *s, unsigned int a
 static inline unsigned int lib_flexfloat_msub(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m) {
   FF_INIT_3(a, b, c, e, m)
   ff_inverse(&ff_c, &ff_c);
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_fma(&ff_res, &ff_a, &ff_b, &ff_c);
   update_fflags_fenv(s);
   return flexfloat_get_bits(&ff_res);
@@ -1481,7 +1471,7 @@ static inline unsigned int lib_flexfloat_msub(iss_cpu_state_t *s, unsigned int a
 static inline unsigned int lib_flexfloat_nmsub(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m) {
   FF_INIT_3(a, b, c, e, m)
   ff_inverse(&ff_a, &ff_a);
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_fma(&ff_res, &ff_a, &ff_b, &ff_c);
   update_fflags_fenv(s);
   return flexfloat_get_bits(&ff_res);
@@ -1489,7 +1479,7 @@ static inline unsigned int lib_flexfloat_nmsub(iss_cpu_state_t *s, unsigned int
 
 static inline unsigned int lib_flexfloat_nmadd(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m) {
   FF_INIT_3(a, b, c, e, m)
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_fma(&ff_res, &ff_a, &ff_b, &ff_c);
   update_fflags_fenv(s);
   ff_inverse(&ff_res, &ff_res);
@@ -1498,6 +1488,7 @@ static inline unsigned int lib_flexfloat_nmadd(iss_cpu_state_t *s, unsigned int
 
 static inline unsigned int setFFRoundingMode(iss_cpu_state_t *s, unsigned int mode)
 {
+  lib_float_host_release(s);
   int old = fegetround();
   switch (mode) {
     case 0: fesetround(FE_TONEAREST); break;
@@ -1525,6 +1516,8 @@ static inline void restoreFFRoundingMode(unsigned int mode)
 }
 
 static inline unsigned int lib_flexfloat_madd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_fma_round(s, a, b, c, e, m, round, false, false);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_madd(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1532,6 +1525,8 @@ static inline unsigned int lib_flexfloat_madd_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_msub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_fma_round(s, a, b, c, e, m, round, false, true);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_msub(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1539,6 +1534,8 @@ static inline unsigned int lib_flexfloat_msub_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_nmadd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_fma_round(s, a, b, c, e, m, round, true, true);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_nmadd(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1546,6 +1543,8 @@ static inline unsigned int lib_flexfloat_nmadd_round(iss_cpu_state_t *s, unsigne
 }
 
 static inline unsigned int lib_flexfloat_nmsub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_fma_round(s, a, b, c, e, m, round, true, false);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_nmsub(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1553,6 +1552,8 @@ static inline unsigned int lib_flexfloat_nmsub_round(iss_cpu_state_t *s, unsigne
 }
 
 static inline unsigned int lib_flexfloat_add_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_add_round(s, a, b, e, m, round);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_add(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1560,6 +1561,8 @@ static inline unsigned int lib_flexfloat_add_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_sub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_sub_round(s, a, b, e, m, round);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_sub(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1567,6 +1570,8 @@ static inline unsigned int lib_flexfloat_sub_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_mul_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_mul_round(s, a, b, e, m, round);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_mul(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1574,6 +1579,8 @@ static inline unsigned int lib_flexfloat_mul_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_div_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_div_round(s, a, b, e, m, round);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_div(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1588,9 +1595,11 @@ static inline unsigned int lib_flexfloat_avg_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_sqrt_round(iss_cpu_state_t *s, unsigned int a, uint8_t e, uint8_t m, unsigned int round) {
+  if (lib_sf_supported(s, e, m, round))
+    return lib_sf_sqrt_round(s, a, e, m, round);
   int old = setFFRoundingMode(s, round);
   FF_INIT_1(a, e, m)
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_init_double(&ff_res, sqrt(ff_get_double(&ff_a)), env);
   update_fflags_fenv(s);
   restoreFFRoundingMode(old);
@@ -1617,11 +1626,15 @@ static inline unsigned int lib_flexfloat_sgnjx(iss_cpu_state_t *s, unsigned int
 
 // TODO proper nan handling
 static inline unsigned int lib_flexfloat_min(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (SF_IS_SMALL(e, m))
+    return lib_sf_min(s, a, b, e, m, false);
   FF_EXEC_2(s, ff_min, a, b, e, m)
 }
 
 // TODO proper NaN handling
 static inline unsigned int lib_flexfloat_max(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (SF_IS_SMALL(e, m))
+    return lib_sf_min(s, a, b, e, m, true);
   FF_EXEC_2(s, ff_max, a, b, e, m)
 }
 
@@ -1690,6 +1703,9 @@ static inline unsigned int lib_flexfloat_cvt_ff_lu_round(iss_cpu_state_t *s, uin
 }
 
 static inline int lib_flexfloat_cvt_ff_ff_round(iss_cpu_state_t *s, unsigned int a, uint8_t es, uint8_t ms, uint8_t ed, uint8_t md, unsigned int round) {
+  if ((SF_IS_SMALL(es, ms) || (es == 8 && ms == 23)) && (SF_IS_SMALL(ed, md) || (ed == 8 && md == 23)) &&
+    lib_sf_round_mode(s, round) <= 3)
+    return lib_sf_cvt_round(s, a, es, ms, ed, md, round);
   int old = setFFRoundingMode(s, round);
   FF_INIT_1(a, es, ms)
   ff_cast(&ff_res, &ff_a, (flexfloat_desc_t) {ed,md});
@@ -1706,24 +1722,30 @@ static inline unsigned int lib_flexfloat_fmv_ff_x(iss_cpu_state_t *s, unsigned i
 }
 
 static inline unsigned int lib_flexfloat_eq(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (SF_IS_SMALL(e, m))
+    return lib_sf_cmp(s, a, b, e, m, 0);
   FF_INIT_2(a, b, e, m)
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   int32_t res = ff_eq(&ff_a, &ff_b);
   update_fflags_fenv(s);
   return res;
 }
 
 static inline unsigned int lib_flexfloat_lt(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (SF_IS_SMALL(e, m))
+    return lib_sf_cmp(s, a, b, e, m, 1);
   FF_INIT_2(a, b, e, m)
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   int32_t res = ff_lt(&ff_a, &ff_b);
   update_fflags_fenv(s);
   return res;
 }
 
 static inline unsigned int lib_flexfloat_le(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (SF_IS_SMALL(e, m))
+    return lib_sf_cmp(s, a, b, e, m, 2);
   FF_INIT_2(a, b, e, m)
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   int32_t res = ff_le(&ff_a, &ff_b);
   update_fflags_fenv(s);
   return res;
@@ -1812,7 +1834,7 @@ static inline int lib_flexfloat_cvt_ff_x_round(iss_cpu_state_t *s, int a, uint8_
   flexfloat_t ff_a;
   a &= (0x1 << (e+m+1))-1;
   a = (a ^ sign_mask) - sign_mask;
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_init_int(&ff_a, a, (flexfloat_desc_t) {e,m});
   update_fflags_fenv(s);
   restoreFFRoundingMode(old);
@@ -1824,7 +1846,7 @@ static inline unsigned int lib_flexfloat_cvt_ff_xu_round(iss_cpu_state_t *s, uns
   int old = setFFRoundingMode(s, round);
   flexfloat_t ff_a;
   a &= (0x1 << (e+m+1))-1;
-  feclearexcept(FE_ALL_EXCEPT);
+  lib_ff_clear_fenv(s);
   ff_init_long(&ff_a, (unsigned long) a, (flexfloat_desc_t) {e,m});
   update_fflags_fenv(s);
   restoreFFRoundingMode(old);
@@ -1833,6 +1855,226 @@ static inline unsigned int lib_flexfloat_cvt_ff_xu_round(iss_cpu_state_t *s, uns
 
 
 
+// Native binary32
+//
+// Float32 operations are executed with host arithmetic instead of going through
+// flexfloat. The host rounding mode is only changed when the instruction asks
+// for a different one than the previous native operation, and the exception
+// flags are left accumulating in the host environment until fflags is read
+// or the core gives the environment back (see lib_float_host_release).
+
+static inline unsigned int lib_float32_add_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_add_round(s, a, b, 8, 23, round);
+  return lib_float32_set(lib_float32_get(a) + lib_float32_get(b));
+}
+
+static inline unsigned int lib_float32_sub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_sub_round(s, a, b, 8, 23, round);
+  return lib_float32_set(lib_float32_get(a) - lib_float32_get(b));
+}
+
+static inline unsigned int lib_float32_mul_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_mul_round(s, a, b, 8, 23, round);
+  return lib_float32_set(lib_float32_get(a) * lib_float32_get(b));
+}
+
+static inline unsigned int lib_float32_div_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_div_round(s, a, b, 8, 23, round);
+  return lib_float32_set(lib_float32_get(a) / lib_float32_get(b));
+}
+
+static inline unsigned int lib_float32_sqrt_round(iss_cpu_state_t *s, unsigned int a, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_sqrt_round(s, a, 8, 23, round);
+  return lib_float32_set(sqrtf(lib_float32_get(a)));
+}
+
+// RISC-V raises invalid for infinity * zero even when the addend is a quiet
+// NaN, while the host does not
+static inline void lib_float32_fma_check(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c) {
+  if (unlikely(lib_float32_is_nan(c)))
+  {
+    if (((a & 0x7fffffff) == 0x7f800000 && (b & 0x7fffffff) == 0) ||
+      ((b & 0x7fffffff) == 0x7f800000 && (a & 0x7fffffff) == 0))
+      s->fcsr.fflags.NV = 1;
+  }
+}
+
+static inline unsigned int lib_float32_madd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_madd_round(s, a, b, c, 8, 23, round);
+  lib_float32_fma_check(s, a, b, c);
+  return lib_float32_set(fmaf(lib_float32_get(a), lib_float32_get(b), lib_float32_get(c)));
+}
+
+static inline unsigned int lib_float32_msub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_msub_round(s, a, b, c, 8, 23, round);
+  lib_float32_fma_check(s, a, b, c);
+  return lib_float32_set(fmaf(lib_float32_get(a), lib_float32_get(b), -lib_float32_get(c)));
+}
+
+static inline unsigned int lib_float32_nmsub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_nmsub_round(s, a, b, c, 8, 23, round);
+  lib_float32_fma_check(s, a, b, c);
+  return lib_float32_set(fmaf(-lib_float32_get(a), lib_float32_get(b), lib_float32_get(c)));
+}
+
+static inline unsigned int lib_float32_nmadd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_nmadd_round(s, a, b, c, 8, 23, round);
+  lib_float32_fma_check(s, a, b, c);
+  return lib_float32_set(fmaf(-lib_float32_get(a), lib_float32_get(b), -lib_float32_get(c)));
+}
+
+// The following ones only raise invalid on NaNs, their flags are computed
+// directly and they don't need the host environment.
+
+static inline unsigned int lib_float32_sgnj(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  return (a & 0x7fffffff) | (b & 0x80000000);
+}
+
+static inline unsigned int lib_float32_sgnjn(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  return (a & 0x7fffffff) | (~b & 0x80000000);
+}
+
+static inline unsigned int lib_float32_sgnjx(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  return a ^ (b & 0x80000000);
+}
+
+static inline unsigned int lib_float32_min(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  if (lib_float32_is_snan(a) || lib_float32_is_snan(b))
+    s->fcsr.fflags.NV = 1;
+  if (lib_float32_is_nan(a))
+    return lib_float32_is_nan(b) ? FLOAT32_CANONICAL_NAN : b;
+  if (lib_float32_is_nan(b))
+    return a;
+  float fa = lib_float32_get(a), fb = lib_float32_get(b);
+  // -0.0 is considered smaller than +0.0
+  if (fa < fb || (fa == fb && (a & 0x80000000)))
+    return a;
+  return b;
+}
+
+static inline unsigned int lib_float32_max(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  if (lib_float32_is_snan(a) || lib_float32_is_snan(b))
+    s->fcsr.fflags.NV = 1;
+  if (lib_float32_is_nan(a))
+    return lib_float32_is_nan(b) ? FLOAT32_CANONICAL_NAN : b;
+  if (lib_float32_is_nan(b))
+    return a;
+  float fa = lib_float32_get(a), fb = lib_float32_get(b);
+  if (fa > fb || (fa == fb && !(a & 0x80000000)))
+    return a;
+  return b;
+}
+
+static inline unsigned int lib_float32_eq(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  if (lib_float32_is_nan(a) || lib_float32_is_nan(b))
+  {
+    if (lib_float32_is_snan(a) || lib_float32_is_snan(b))
+      s->fcsr.fflags.NV = 1;
+    return 0;
+  }
+  return lib_float32_get(a) == lib_float32_get(b);
+}
+
+static inline unsigned int lib_float32_lt(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  if (lib_float32_is_nan(a) || lib_float32_is_nan(b))
+  {
+    s->fcsr.fflags.NV = 1;
+    return 0;
+  }
+  return lib_float32_get(a) < lib_float32_get(b);
+}
+
+static inline unsigned int lib_float32_le(iss_cpu_state_t *s, unsigned int a, unsigned int b) {
+  if (lib_float32_is_nan(a) || lib_float32_is_nan(b))
+  {
+    s->fcsr.fflags.NV = 1;
+    return 0;
+  }
+  return lib_float32_get(a) <= lib_float32_get(b);
+}
+
+static inline unsigned int lib_float32_class(iss_cpu_state_t *s, unsigned int a) {
+  unsigned int frac = a & 0x7fffff;
+  unsigned int exp = (a >> 23) & 0xff;
+  bool sign = a >> 31;
+
+  if (exp == 0xff) {
+    if (frac == 0) return sign ? (0x1 << 0) : (0x1 << 7); // infinity
+    return (frac & 0x400000) ? (0x1 << 9) : (0x1 << 8);   // quiet / signalling NaN
+  } else if (exp == 0) {
+    if (frac == 0) return sign ? (0x1 << 3) : (0x1 << 4); // zero
+    return sign ? (0x1 << 2) : (0x1 << 5);                 // subnormal
+  }
+  return sign ? (0x1 << 1) : (0x1 << 6);                   // normal
+}
+
+static inline int64_t lib_float32_to_w_round(iss_cpu_state_t *s, unsigned int a, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_cvt_w_ff_round(s, a, 8, 23, round);
+  float f = lib_float32_get(a);
+  if (lib_float32_is_nan(a)) {
+    s->fcsr.fflags.NV = 1;
+    return INT32_MAX;
+  }
+  float r = nearbyintf(f);
+  if (r >= 2147483648.0f) {
+    s->fcsr.fflags.NV = 1;
+    return INT32_MAX;
+  }
+  if (r < -2147483648.0f) {
+    s->fcsr.fflags.NV = 1;
+    return INT32_MIN;
+  }
+  if (r != f)
+    s->fcsr.fflags.NX = 1;
+  return (int32_t)r;
+}
+
+static inline int64_t lib_float32_to_wu_round(iss_cpu_state_t *s, unsigned int a, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_cvt_wu_ff_round(s, a, 8, 23, round);
+  float f = lib_float32_get(a);
+  if (lib_float32_is_nan(a)) {
+    s->fcsr.fflags.NV = 1;
+    return (int32_t)UINT32_MAX;
+  }
+  float r = nearbyintf(f);
+  if (r >= 4294967296.0f) {
+    s->fcsr.fflags.NV = 1;
+    return (int32_t)UINT32_MAX;
+  }
+  if (r < 0.0f) {
+    s->fcsr.fflags.NV = 1;
+    return 0;
+  }
+  if (r != f)
+    s->fcsr.fflags.NX = 1;
+  return (int32_t)(uint32_t)r;
+}
+
+static inline unsigned int lib_float32_from_w_round(iss_cpu_state_t *s, int64_t a, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_cvt_ff_w_round(s, a, 8, 23, round);
+  return lib_float32_set((float)(int32_t)a);
+}
+
+static inline unsigned int lib_float32_from_wu_round(iss_cpu_state_t *s, int64_t a, unsigned int round) {
+  if (unlikely(!lib_float32_acquire(s, round)))
+    return lib_flexfloat_cvt_ff_wu_round(s, a, 8, 23, round);
+  return lib_float32_set((float)(uint32_t)a);
+}
+
+
+
 /////
 
 #if 0
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __ISA_LIB_SFLOAT_H__
+#define __ISA_LIB_SFLOAT_H__
+
+#include <stdint.h>
+
+/*
+ * Small floating-point formats of the transprecision extensions: f8 (5,2),
+ * f16 (5,10) and f16alt (8,7).
+ *
+ * Operands are expanded through tables to host values, which are exact, the
+ * operation is done on the host in double precision with the host rounding
+ * mode set to the instruction one, and the result is rounded to the small
+ * format by lib_sf_encode. Double precision has more than twice the precision
+ * of these formats, so rounding twice gives the same result as rounding once.
+ *
+ * For f8, add, sub, mul and div are fully precomputed, result and flags, for
+ * all operand pairs and rounding modes.
+ *
+ * The tables are built once when the first core having these extensions is
+ * opened (lib_sf_init) and are then shared by all cores.
+ *
+ * This file is included by int.h after the host floating-point environment
+ * helpers.
+ */
+
+#define SF_IS_F8(e, m)     ((e) == 5 && (m) == 2)
+#define SF_IS_F16(e, m)    ((e) == 5 && (m) == 10)
+#define SF_IS_F16ALT(e, m) ((e) == 8 && (m) == 7)
+#define SF_IS_SMALL(e, m)  (SF_IS_F8(e, m) || SF_IS_F16(e, m) || SF_IS_F16ALT(e, m))
+
+#define SF_FLAG_NX (1<<0)
+#define SF_FLAG_UF (1<<1)
+#define SF_FLAG_OF (1<<2)
+#define SF_FLAG_DZ (1<<3)
+#define SF_FLAG_NV (1<<4)
+
+enum {
+  SF_OP_ADD,
+  SF_OP_SUB,
+  SF_OP_MUL,
+  SF_OP_DIV,
+  SF_NB_OPS
+};
+
+extern float lib_sf_f8_values[1<<8];
+extern float lib_sf_f16_values[1<<16];
+
+// Result in the low byte and fflags in the high byte, indexed by rounding mode
+// and by (a << 8) | b
+extern uint16_t lib_sf_f8_ops[SF_NB_OPS][4][1<<16];
+
+void lib_sf_init(bool f16, bool f8);
+
+// Returns the bits of the binary32 value having the same value as a
+unsigned int lib_sf_to_float32_bits(unsigned int a, int e, int m);
+
+
+
+static inline unsigned int lib_sf_round_mode(iss_cpu_state_t *s, unsigned int round)
+{
+  return round == 7 ? s->fcsr.frm : round;
+}
+
+// Tells if the operation can be done here, otherwise it goes through flexfloat
+static inline bool lib_sf_supported(iss_cpu_state_t *s, uint8_t e, uint8_t m, unsigned int round)
+{
+  return SF_IS_SMALL(e, m) && lib_sf_round_mode(s, round) <= 3;
+}
+
+static inline bool lib_sf_is_nan(unsigned int a, uint8_t e, uint8_t m)
+{
+  unsigned int exp_mask = (1 << e) - 1;
+  return ((a >> m) & exp_mask) == exp_mask && (a & ((1 << m) - 1));
+}
+
+static inline bool lib_sf_is_snan(unsigned int a, uint8_t e, uint8_t m)
+{
+  return lib_sf_is_nan(a, e, m) && !((a >> (m - 1)) & 1);
+}
+
+static inline double lib_sf_decode(unsigned int a, uint8_t e, uint8_t m)
+{
+  if (SF_IS_F8(e, m))
+    return lib_sf_f8_values[a & 0xff];
+  else if (SF_IS_F16(e, m))
+    return lib_sf_f16_values[a & 0xffff];
+  else if (SF_IS_F16ALT(e, m))
+    // Same exponent as binary32, it is the upper half of it
+    return lib_float32_get((a & 0xffff) << 16);
+  else
+    return lib_float32_get(a);
+}
+
+// Tells if the dropped bits must round the kept ones up, rem being the dropped
+// bits and half the value of the first one
+static inline bool lib_sf_round_up(uint64_t q, uint64_t rem, uint64_t half, unsigned int sign, unsigned int mode)
+{
+  switch (mode)
+  {
+    case 0:  return rem > half || (rem == half && (q & 1));
+    case 1:  return false;
+    case 2:  return rem && sign;
+    default: return rem && !sign;
+  }
+}
+
+// Rounds a host value to the format, with the specified rounding mode, and
+// returns its bits. Inexact, underflow and overflow are added to flags, the
+// other ones can only come from the host operation. Sticky tells that the host
+// value itself is inexact, and was already rounded in the same direction.
+static inline unsigned int lib_sf_encode(double d, uint8_t e, uint8_t m, unsigned int mode, unsigned int *flags, bool sticky)
+{
+  union { double d; uint64_t i; } u = { d };
+  unsigned int sign = u.i >> 63;
+  unsigned int sign_bit = sign << (e + m);
+  unsigned int exp_mask = (1 << e) - 1;
+  int bias = (1 << (e - 1)) - 1;
+  int dexp = (u.i >> 52) & 0x7ff;
+  uint64_t sig = u.i & ((1ULL << 52) - 1);
+
+  if (dexp == 0x7ff)
+  {
+    if (sig)
+      return (exp_mask << m) | (1 << (m - 1));
+    return sign_bit | (exp_mask << m);
+  }
+
+  if (dexp == 0 && sig == 0)
+    return sign_bit;
+
+  int exp = dexp ? dexp - 1023 : -1022;
+  if (dexp)
+    sig |= 1ULL << 52;
+
+  // Number of bits to drop, values below the normal range of the format lose
+  // one more bit for each step below
+  int emin = 1 - bias;
+  bool tiny = exp < emin;
+  int shift = 52 - m;
+  if (tiny)
+  {
+    shift += emin - exp;
+    // Anything further than that is only sticky bits
+    if (shift > 54)
+      shift = 54;
+  }
+
+  uint64_t q = sig >> shift;
+  uint64_t rem = sig & ((1ULL << shift) - 1);
+  uint64_t half = 1ULL << (shift - 1);
+  bool inexact = rem != 0 || sticky;
+
+  q += lib_sf_round_up(q, rem, half, sign, mode);
+
+  unsigned int result;
+  unsigned int result_flags = inexact ? SF_FLAG_NX : 0;
+
+  if (tiny)
+  {
+    // Rounding up the largest subnormal gives the smallest normal, which is
+    // also what the bits give
+    result = q;
+
+    // Tininess is detected after rounding, as if the exponent was unbounded,
+    // which only matters just below the smallest normal
+    if (inexact)
+    {
+      bool tiny_after = true;
+      if (exp == emin - 1)
+      {
+        int norm_shift = 52 - m;
+        uint64_t norm_q = sig >> norm_shift;
+        uint64_t norm_rem = sig & ((1ULL << norm_shift) - 1);
+        norm_q += lib_sf_round_up(norm_q, norm_rem, 1ULL << (norm_shift - 1), sign, mode);
+        tiny_after = !(norm_q >> (m + 1));
+      }
+      if (tiny_after)
+        result_flags |= SF_FLAG_UF;
+    }
+  }
+  else
+  {
+    int biased_exp = exp + bias;
+    if (q >> (m + 1))
+    {
+      q >>= 1;
+      biased_exp++;
+    }
+
+    if (biased_exp >= (int)exp_mask)
+    {
+      bool to_inf = mode == 0 || (mode == 2 && sign) || (mode == 3 && !sign);
+      result_flags |= SF_FLAG_OF | SF_FLAG_NX;
+      result = to_inf ? exp_mask << m : ((exp_mask - 1) << m) | ((1 << m) - 1);
+    }
+    else
+    {
+      result = (biased_exp << m) | (q & ((1 << m) - 1));
+    }
+  }
+
+  *flags |= result_flags;
+
+  return sign_bit | result;
+}
+
+static inline unsigned int lib_sf_set(iss_cpu_state_t *s, double d, uint8_t e, uint8_t m, bool sticky=false)
+{
+  unsigned int flags = 0;
+  unsigned int result = lib_sf_encode(d, e, m, s->fp_host_round, &flags, sticky);
+  set_fflags(s, flags);
+  return result;
+}
+
+static inline unsigned int lib_sf_f8_op(iss_cpu_state_t *s, int op, unsigned int a, unsigned int b, unsigned int round)
+{
+  uint16_t entry = lib_sf_f8_ops[op][lib_sf_round_mode(s, round)][((a & 0xff) << 8) | (b & 0xff)];
+  set_fflags(s, entry >> 8);
+  return entry & 0xff;
+}
+
+#define SF_BINARY_OP(name, op_id, op) \
+static inline unsigned int lib_sf_##name##_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) \
+{ \
+  if (SF_IS_F8(e, m)) \
+    return lib_sf_f8_op(s, op_id, a, b, round); \
+  lib_float32_acquire(s, round); \
+  return lib_sf_set(s, lib_sf_decode(a, e, m) op lib_sf_decode(b, e, m), e, m); \
+}
+
+SF_BINARY_OP(add, SF_OP_ADD, +)
+SF_BINARY_OP(sub, SF_OP_SUB, -)
+SF_BINARY_OP(mul, SF_OP_MUL, *)
+SF_BINARY_OP(div, SF_OP_DIV, /)
+
+static inline unsigned int lib_sf_sqrt_round(iss_cpu_state_t *s, unsigned int a, uint8_t e, uint8_t m, unsigned int round)
+{
+  lib_float32_acquire(s, round);
+  return lib_sf_set(s, sqrt(lib_sf_decode(a, e, m)), e, m);
+}
+
+static inline unsigned int lib_sf_fma_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round, bool neg_prod, bool neg_add)
+{
+  lib_float32_acquire(s, round);
+  double da = lib_sf_decode(a, e, m);
+  double dc = lib_sf_decode(c, e, m);
+  // The product is exact in double precision, only the addition rounds
+  double prod = (neg_prod ? -da : da) * lib_sf_decode(b, e, m);
+  double addend = neg_add ? -dc : dc;
+  double result = prod + addend;
+
+  // Contrary to the other operations, the exact sum can have many more bits
+  // than twice the format precision, and rounding it to nearest twice can then
+  // give a different result. The double result is instead rounded to odd,
+  // which is safe, from the rounding error given by TwoSum.
+  // In the directed modes, rounding twice is safe but the double result can
+  // be exact in the format, so it just has to be known if it was rounded.
+  bool sticky = false;
+  if (s->fp_host_round != 0 && isfinite(result))
+  {
+    sticky = result - prod != addend || result - addend != prod;
+  }
+  else if (isfinite(result))
+  {
+    double bv = result - prod;
+    double error = (prod - (result - bv)) + (addend - bv);
+    if (error != 0)
+    {
+      union { double d; uint64_t i; } u = { result };
+      // Truncate toward zero, then force the last bit
+      if ((error > 0) != (result > 0))
+        u.i--;
+      u.i |= 1;
+      result = u.d;
+    }
+  }
+
+  return lib_sf_set(s, result, e, m, sticky);
+}
+
+// Conversion between 2 formats, each one being either a small one or binary32
+static inline unsigned int lib_sf_cvt_round(iss_cpu_state_t *s, unsigned int a, uint8_t es, uint8_t ms, uint8_t ed, uint8_t md, unsigned int round)
+{
+  lib_float32_acquire(s, round);
+  return lib_sf_set(s, lib_sf_decode(a, es, ms), ed, md);
+}
+
+static inline unsigned int lib_sf_min(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, bool is_max)
+{
+  if (lib_sf_is_snan(a, e, m) || lib_sf_is_snan(b, e, m))
+    set_fflags(s, SF_FLAG_NV);
+  if (lib_sf_is_nan(a, e, m))
+    return lib_sf_is_nan(b, e, m) ? (((1 << e) - 1) << m) | (1 << (m - 1)) : b;
+  if (lib_sf_is_nan(b, e, m))
+    return a;
+  double da = lib_sf_decode(a, e, m), db = lib_sf_decode(b, e, m);
+  // -0.0 is considered smaller than +0.0
+  bool a_neg = (a >> (e + m)) & 1;
+  bool a_first = da < db || (da == db && a_neg);
+  return a_first ^ is_max ? a : b;
+}
+
+static inline unsigned int lib_sf_cmp(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, int cmp)
+{
+  if (lib_sf_is_nan(a, e, m) || lib_sf_is_nan(b, e, m))
+  {
+    // eq is quiet, lt and le are signaling
+    if (cmp != 0 || lib_sf_is_snan(a, e, m) || lib_sf_is_snan(b, e, m))
+      set_fflags(s, SF_FLAG_NV);
+    return 0;
+  }
+  double da = lib_sf_decode(a, e, m), db = lib_sf_decode(b, e, m);
+  return cmp == 0 ? da == db : cmp == 1 ? da < db : da <= db;
+}
+
+#endif
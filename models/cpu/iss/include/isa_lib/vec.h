@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __ISA_LIB_VEC_H__
+#define __ISA_LIB_VEC_H__
+
+#include <stdint.h>
+
+/*
+ * Packed-SIMD operations on 32 bits registers, seen either as 4 8 bits
+ * elements or 2 16 bits elements.
+ *
+ * The operations process the elements one by one, which the compiler already
+ * vectorizes well. Only the byte shuffles have a version using the host SIMD
+ * instructions, which is used when the model is compiled for a host having
+ * SSE4.1, their scalar version being kept as vec_scalar_*. Defining
+ * ISS_VEC_NO_HOST_SIMD forces the scalar versions.
+ */
+
+#if defined(__SSE4_1__) && !defined(ISS_VEC_NO_HOST_SIMD)
+#define ISS_VEC_HOST_SIMD 1
+#include <smmintrin.h>
+#endif
+
+
+
+/*
+ * Scalar versions
+ */
+
+static inline uint32_t vec_splat_8(uint32_t a) { return (a & 0xff) * 0x01010101; }
+static inline uint32_t vec_splat_16(uint32_t a) { return (a & 0xffff) * 0x00010001; }
+
+#define VEC_SCALAR_EXPR(name, elemType, num_elem, expr)                  \
+static inline uint32_t vec_##name(uint32_t a, uint32_t b) {              \
+  elemType *tmp_a = (elemType *)&a;                                      \
+  elemType *tmp_b = (elemType *)&b;                                      \
+  uint32_t out;                                                          \
+  elemType *tmp_out = (elemType *)&out;                                  \
+  for (int i = 0; i < num_elem; i++)                                     \
+    tmp_out[i] = expr;                                                   \
+  return out;                                                            \
+}
+
+// Products are done on 32 bits unsigned values so that the result wraps
+// around as the hardware does
+#define VEC_SCALAR_DOTP(name, elemTypeA, elemTypeB, num_elem)            \
+static inline uint32_t vec_##name(uint32_t a, uint32_t b) {              \
+  elemTypeA *tmp_a = (elemTypeA *)&a;                                    \
+  elemTypeB *tmp_b = (elemTypeB *)&b;                                    \
+  uint32_t out = 0;                                                      \
+  for (int i = 0; i < num_elem; i++)                                     \
+    out += (uint32_t)tmp_a[i] * (uint32_t)tmp_b[i];                      \
+  return out;                                                            \
+}
+
+VEC_SCALAR_EXPR(add_8, int8_t, 4, tmp_a[i] + tmp_b[i])
+VEC_SCALAR_EXPR(add_16, int16_t, 2, tmp_a[i] + tmp_b[i])
+VEC_SCALAR_EXPR(sub_8, int8_t, 4, tmp_a[i] - tmp_b[i])
+VEC_SCALAR_EXPR(sub_16, int16_t, 2, tmp_a[i] - tmp_b[i])
+
+VEC_SCALAR_EXPR(add_div2_8, int8_t, 4, ((int8_t)(tmp_a[i] + tmp_b[i]))>>1)
+VEC_SCALAR_EXPR(add_div4_8, int8_t, 4, ((int8_t)(tmp_a[i] + tmp_b[i]))>>2)
+VEC_SCALAR_EXPR(add_div2_16, int16_t, 2, ((int16_t)(tmp_a[i] + tmp_b[i]))>>1)
+VEC_SCALAR_EXPR(add_div4_16, int16_t, 2, ((int16_t)(tmp_a[i] + tmp_b[i]))>>2)
+VEC_SCALAR_EXPR(add_div8_16, int16_t, 2, ((int16_t)(tmp_a[i] + tmp_b[i]))>>3)
+VEC_SCALAR_EXPR(sub_div2_8, int8_t, 4, ((int8_t)(tmp_a[i] - tmp_b[i]))>>1)
+VEC_SCALAR_EXPR(sub_div4_8, int8_t, 4, ((int8_t)(tmp_a[i] - tmp_b[i]))>>2)
+VEC_SCALAR_EXPR(sub_div2_16, int16_t, 2, ((int16_t)(tmp_a[i] - tmp_b[i]))>>1)
+VEC_SCALAR_EXPR(sub_div4_16, int16_t, 2, ((int16_t)(tmp_a[i] - tmp_b[i]))>>2)
+VEC_SCALAR_EXPR(sub_div8_16, int16_t, 2, ((int16_t)(tmp_a[i] - tmp_b[i]))>>3)
+
+VEC_SCALAR_EXPR(avgu_8, uint8_t, 4, ((uint8_t)(tmp_a[i] + tmp_b[i]))>>1)
+VEC_SCALAR_EXPR(avgu_16, uint16_t, 2, ((uint16_t)(tmp_a[i] + tmp_b[i]))>>1)
+
+VEC_SCALAR_EXPR(min_8, int8_t, 4, tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i])
+VEC_SCALAR_EXPR(min_16, int16_t, 2, tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i])
+VEC_SCALAR_EXPR(minu_8, uint8_t, 4, tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i])
+VEC_SCALAR_EXPR(minu_16, uint16_t, 2, tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i])
+VEC_SCALAR_EXPR(max_8, int8_t, 4, tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i])
+VEC_SCALAR_EXPR(max_16, int16_t, 2, tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i])
+VEC_SCALAR_EXPR(maxu_8, uint8_t, 4, tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i])
+VEC_SCALAR_EXPR(maxu_16, uint16_t, 2, tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i])
+
+VEC_SCALAR_EXPR(srl_8, uint8_t, 4, tmp_a[i] >> (tmp_b[i] & 0x7))
+VEC_SCALAR_EXPR(srl_16, uint16_t, 2, tmp_a[i] >> (tmp_b[i] & 0xF))
+VEC_SCALAR_EXPR(sra_8, int8_t, 4, tmp_a[i] >> (tmp_b[i] & 0x7))
+VEC_SCALAR_EXPR(sra_16, int16_t, 2, tmp_a[i] >> (tmp_b[i] & 0xF))
+VEC_SCALAR_EXPR(sll_8, uint8_t, 4, tmp_a[i] << (tmp_b[i] & 0x7))
+VEC_SCALAR_EXPR(sll_16, uint16_t, 2, tmp_a[i] << (tmp_b[i] & 0xF))
+
+VEC_SCALAR_DOTP(dotsp_8, int8_t, int8_t, 4)
+VEC_SCALAR_DOTP(dotsp_16, int16_t, int16_t, 2)
+VEC_SCALAR_DOTP(dotup_8, uint8_t, uint8_t, 4)
+VEC_SCALAR_DOTP(dotup_16, uint16_t, uint16_t, 2)
+VEC_SCALAR_DOTP(dotusp_8, uint8_t, int8_t, 4)
+VEC_SCALAR_DOTP(dotusp_16, uint16_t, int16_t, 2)
+
+// Element i of the result is the element of a selected by the lowest bits of
+// element i of b
+VEC_SCALAR_EXPR(scalar_shuffle_8, uint8_t, 4, ((uint8_t *)&a)[tmp_b[i] & 0x3])
+VEC_SCALAR_EXPR(shuffle_16, uint16_t, 2, ((uint16_t *)&a)[tmp_b[i] & 0x1])
+
+// Same with 2 sources, the next bit of each element of b selects the source.
+// This bit selects a on RISCV and c on the other cores.
+static inline uint32_t vec_scalar_shuffle2_8(uint32_t a, uint32_t b, uint32_t c) {
+  uint8_t *tmp_b = (uint8_t *)&b;
+  uint32_t out;
+  uint8_t *tmp_out = (uint8_t *)&out;
+  for (int i = 0; i < 4; i++)
+  {
+#ifdef RISCV
+    uint32_t src = tmp_b[i] & 0x4 ? a : c;
+#else
+    uint32_t src = tmp_b[i] & 0x4 ? c : a;
+#endif
+    tmp_out[i] = ((uint8_t *)&src)[tmp_b[i] & 0x3];
+  }
+  return out;
+}
+
+static inline uint32_t vec_shuffle2_16(uint32_t a, uint32_t b, uint32_t c) {
+  uint16_t *tmp_b = (uint16_t *)&b;
+  uint32_t out;
+  uint16_t *tmp_out = (uint16_t *)&out;
+  for (int i = 0; i < 2; i++)
+  {
+#ifdef RISCV
+    uint32_t src = tmp_b[i] & 0x2 ? a : c;
+#else
+    uint32_t src = tmp_b[i] & 0x2 ? c : a;
+#endif
+    tmp_out[i] = ((uint16_t *)&src)[tmp_b[i] & 0x1];
+  }
+  return out;
+}
+
+
+
+/*
+ * Host SIMD versions
+ */
+
+#ifdef ISS_VEC_HOST_SIMD
+
+static inline __m128i vec_simd_load(uint32_t a) { return _mm_cvtsi32_si128(a); }
+
+static inline uint32_t vec_simd_store(__m128i a) { return _mm_cvtsi128_si32(a); }
+
+static inline uint32_t vec_simd_shuffle_8(uint32_t a, uint32_t b) {
+  return vec_simd_store(_mm_shuffle_epi8(vec_simd_load(a), vec_simd_load(b & 0x03030303)));
+}
+
+// Both sources are concatenated so that the selection bit becomes part of the
+// byte index
+static inline uint32_t vec_simd_shuffle2_8(uint32_t a, uint32_t b, uint32_t c) {
+#ifdef RISCV
+  __m128i src = _mm_unpacklo_epi32(vec_simd_load(c), vec_simd_load(a));
+#else
+  __m128i src = _mm_unpacklo_epi32(vec_simd_load(a), vec_simd_load(c));
+#endif
+  return vec_simd_store(_mm_shuffle_epi8(src, vec_simd_load(b & 0x07070707)));
+}
+
+#define VEC_IMPL_SHUFFLE(name) vec_simd_##name
+
+#else
+
+#define VEC_IMPL_SHUFFLE(name) vec_scalar_##name
+
+#endif
+
+static inline uint32_t vec_shuffle_8(uint32_t a, uint32_t b) { return VEC_IMPL_SHUFFLE(shuffle_8)(a, b); }
+static inline uint32_t vec_shuffle2_8(uint32_t a, uint32_t b, uint32_t c) { return VEC_IMPL_SHUFFLE(shuffle2_8)(a, b, c); }
+
+#endif
@@ -540,7 +540,7 @@ static inline iss_insn_t *hwloop_check_exec(iss_t *iss, iss_insn_t *insn)
 
   // First execute the instructions as it is the last one of the loop body.
   // The real handler has been saved when the loop was started.
-  iss_insn_t *insn_next = iss_exec_insn_handler(iss, insn, insn->hwloop_handler);
+  iss_insn_t *insn_next = iss_exec_insn_handler(iss, insn, iss_insn_cold(insn)->hwloop_handler);
 
   // First check HW loop 0 as it has higher priority compared to HW loop 1
   if (iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPCOUNT0] && iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND0] == pc)
@@ -575,11 +575,12 @@ static inline void hwloop_set_start(iss_t *iss, iss_insn_t *insn, int index, iss
 static inline void hwloop_set_end(iss_t *iss, iss_insn_t *insn, int index, iss_reg_t end)
 {
   iss_insn_t *end_insn = insn_cache_get_decoded(iss, end);
+  iss_insn_cold_t *end_cold = iss_insn_cold(end_insn);
 
-  if (end_insn->hwloop_handler == NULL)
+  if (end_cold->hwloop_handler == NULL)
   {
-    end_insn->hwloop_handler = end_insn->handler;
-    end_insn->handler = hwloop_check_exec;
+    end_cold->hwloop_handler = end_cold->handler;
+    end_cold->handler = hwloop_check_exec;
     end_insn->fast_handler = hwloop_check_exec;
   }
 
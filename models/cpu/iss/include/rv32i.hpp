@@ -616,7 +616,7 @@ static inline iss_insn_t *ebreak_exec(iss_t *iss, iss_insn_t *insn)
   if (next)
   {
     next = iss_decode_pc_noexec(iss, next);
-    if (insn->next->opcode == 0x40705013)
+    if (iss_insn_opcode(insn->next) == 0x40705013)
     {
       iss_handle_riscv_ebreak(iss, insn);
       return insn->next;
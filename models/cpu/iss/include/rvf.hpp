@@ -47,7 +47,7 @@ static inline iss_insn_t *fsw_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fmadd_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL4(lib_flexfloat_madd_round, REG_GET(0), REG_GET(1), REG_GET(2), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL4(lib_float32_madd_round, REG_GET(0), REG_GET(1), REG_GET(2), UIM_GET(0)));
   return insn->next;
 }
 
@@ -55,7 +55,7 @@ static inline iss_insn_t *fmadd_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fmsub_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL4(lib_flexfloat_msub_round, REG_GET(0), REG_GET(1), REG_GET(2), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL4(lib_float32_msub_round, REG_GET(0), REG_GET(1), REG_GET(2), UIM_GET(0)));
   return insn->next;
 }
 
@@ -63,7 +63,7 @@ static inline iss_insn_t *fmsub_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fnmsub_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL4(lib_flexfloat_nmsub_round, REG_GET(0), REG_GET(1), REG_GET(2), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL4(lib_float32_nmsub_round, REG_GET(0), REG_GET(1), REG_GET(2), UIM_GET(0)));
   return insn->next;
 }
 
@@ -71,7 +71,7 @@ static inline iss_insn_t *fnmsub_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fnmadd_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL4(lib_flexfloat_nmadd_round, REG_GET(0), REG_GET(1), REG_GET(2), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL4(lib_float32_nmadd_round, REG_GET(0), REG_GET(1), REG_GET(2), UIM_GET(0)));
   return insn->next;
 }
 
@@ -79,7 +79,7 @@ static inline iss_insn_t *fnmadd_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fadd_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL3(lib_flexfloat_add_round, REG_GET(0), REG_GET(1), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL3(lib_float32_add_round, REG_GET(0), REG_GET(1), UIM_GET(0)));
   return insn->next;
 }
 
@@ -87,7 +87,7 @@ static inline iss_insn_t *fadd_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fsub_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL3(lib_flexfloat_sub_round, REG_GET(0), REG_GET(1), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL3(lib_float32_sub_round, REG_GET(0), REG_GET(1), UIM_GET(0)));
   return insn->next;
 }
 
@@ -95,7 +95,7 @@ static inline iss_insn_t *fsub_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fmul_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL3(lib_flexfloat_mul_round, REG_GET(0), REG_GET(1), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL3(lib_float32_mul_round, REG_GET(0), REG_GET(1), UIM_GET(0)));
   return insn->next;
 }
 
@@ -103,7 +103,7 @@ static inline iss_insn_t *fmul_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fdiv_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL3(lib_flexfloat_div_round, REG_GET(0), REG_GET(1), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL3(lib_float32_div_round, REG_GET(0), REG_GET(1), UIM_GET(0)));
   return insn->next;
 }
 
@@ -111,7 +111,7 @@ static inline iss_insn_t *fdiv_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fsqrt_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_sqrt_round, REG_GET(0), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL2(lib_float32_sqrt_round, REG_GET(0), UIM_GET(0)));
   return insn->next;
 }
 
@@ -119,7 +119,7 @@ static inline iss_insn_t *fsqrt_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fsgnj_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_sgnj, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_sgnj, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -127,7 +127,7 @@ static inline iss_insn_t *fsgnj_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fsgnjn_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_sgnjn, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_sgnjn, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -135,7 +135,7 @@ static inline iss_insn_t *fsgnjn_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fsgnjx_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_sgnjx, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_sgnjx, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -143,7 +143,7 @@ static inline iss_insn_t *fsgnjx_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fmin_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_min, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_min, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -151,7 +151,7 @@ static inline iss_insn_t *fmin_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fmax_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_max, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_max, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -159,7 +159,7 @@ static inline iss_insn_t *fmax_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fcvt_w_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_cvt_w_ff_round, REG_GET(0), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL2(lib_float32_to_w_round, REG_GET(0), UIM_GET(0)));
   return insn->next;
 }
 
@@ -167,7 +167,7 @@ static inline iss_insn_t *fcvt_w_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fcvt_wu_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_cvt_wu_ff_round, REG_GET(0), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL2(lib_float32_to_wu_round, REG_GET(0), UIM_GET(0)));
   return insn->next;
 }
 
@@ -191,7 +191,7 @@ static inline iss_insn_t *fmv_s_x_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *feq_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_eq, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_eq, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -199,7 +199,7 @@ static inline iss_insn_t *feq_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *flt_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_lt, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_lt, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -207,7 +207,7 @@ static inline iss_insn_t *flt_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fle_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_le, REG_GET(0), REG_GET(1), 8, 23));
+  REG_SET(0, LIB_CALL2(lib_float32_le, REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -215,7 +215,7 @@ static inline iss_insn_t *fle_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fclass_s_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL1(lib_flexfloat_class, REG_GET(0), 8, 23));
+  REG_SET(0, LIB_CALL1(lib_float32_class, REG_GET(0)));
   return insn->next;
 }
 
@@ -223,7 +223,7 @@ static inline iss_insn_t *fclass_s_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fcvt_s_w_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_cvt_ff_w_round, REG_GET(0), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL2(lib_float32_from_w_round, REG_GET(0), UIM_GET(0)));
   return insn->next;
 }
 
@@ -231,7 +231,7 @@ static inline iss_insn_t *fcvt_s_w_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *fcvt_s_wu_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_FF_CALL2(lib_flexfloat_cvt_ff_wu_round, REG_GET(0), 8, 23, UIM_GET(0)));
+  REG_SET(0, LIB_CALL2(lib_float32_from_wu_round, REG_GET(0), UIM_GET(0)));
   return insn->next;
 }
 
@@ -82,19 +82,37 @@ class iss;
 #define ISS_NB_FREGS 32
 #define ISS_NB_TOTAL_REGS (ISS_NB_REGS + ISS_NB_FREGS)
 
+// Index of the first floating-point register in the register file
+#ifndef ISS_SINGLE_REGFILE
+#define ISS_FREG_OFFSET ISS_NB_REGS
+#else
+#define ISS_FREG_OFFSET 0
+#endif
+
 #define ISS_PREFETCHER_SIZE (ISS_OPCODE_MAX_SIZE*4)
 
 #define ISS_MAX_DECODE_RANGES 8
 #define ISS_MAX_DECODE_ARGS 5
-#define ISS_MAX_IMMEDIATES 4
+#define ISS_MAX_IMMEDIATES 3
 #define ISS_MAX_NB_OUT_REGS 3
 #define ISS_MAX_NB_IN_REGS 3
 
 #define ISS_INSN_BLOCK_SIZE_LOG2 8
 #define ISS_INSN_BLOCK_SIZE (1<<ISS_INSN_BLOCK_SIZE_LOG2)
 #define ISS_INSN_PC_BITS 1
-#define ISS_INSN_BLOCK_ID_BITS 12
-#define ISS_INSN_NB_BLOCKS (1<<ISS_INSN_BLOCK_ID_BITS)
+#define ISS_INSN_BLOCK_OFFSET_BITS (ISS_INSN_BLOCK_SIZE_LOG2 + ISS_INSN_PC_BITS)
+
+// Blocks are found through a two-level table, first a directory of regions
+// indexed by the upper bits of the PC, then the blocks of the region. The
+// directory covers the whole 32 bits address space, upper bits of 64 bits
+// addresses are checked with the region tag.
+#define ISS_INSN_REGION_SIZE_LOG2 10
+#define ISS_INSN_REGION_SIZE (1<<ISS_INSN_REGION_SIZE_LOG2)
+#define ISS_INSN_NB_REGIONS_LOG2 (32 - ISS_INSN_BLOCK_OFFSET_BITS - ISS_INSN_REGION_SIZE_LOG2)
+#define ISS_INSN_NB_REGIONS (1<<ISS_INSN_NB_REGIONS_LOG2)
+
+// Number of blocks allocated at once
+#define ISS_INSN_ARENA_NB_BLOCKS 16
 
 #define ISS_EXCEPT_RESET    0
 #define ISS_EXCEPT_ILLEGAL  1
@@ -103,7 +121,11 @@ class iss;
 
 typedef struct iss_cpu_s iss_cpu_t;
 typedef struct iss_insn_s iss_insn_t;
+typedef struct iss_insn_cold_s iss_insn_cold_t;
+typedef struct iss_decoded_insn_s iss_decoded_insn_t;
 typedef struct iss_insn_block_s iss_insn_block_t;
+typedef struct iss_insn_region_s iss_insn_region_t;
+typedef struct iss_insn_arena_s iss_insn_arena_t;
 typedef struct iss_insn_cache_s iss_insn_cache_t;
 typedef struct iss_decoder_item_s iss_decoder_item_t;
 
@@ -248,6 +270,7 @@ typedef struct iss_decoder_item_s {
       iss_insn_t *(*handler)(iss_t *, iss_insn_t*);
       iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*);
       void (*decode)(iss_t *, iss_insn_t*);
+      void (*decode_args)(iss_decoded_insn_t *, iss_opcode_t);
       char *label;
       int size;
       int nb_args;
@@ -260,6 +283,9 @@ typedef struct iss_decoder_item_s {
       int width;
       int nb_groups;
       iss_decoder_item_t **groups;
+      // Sub-item for each value of the group opcode, NULL if the group is too
+      // wide, in which case the sub-items are searched
+      iss_decoder_item_t **table;
     } group;
   } u;
 
@@ -288,40 +314,105 @@ typedef struct {
   iss_addr_t addr;
 } iss_prefetcher_t;
 
-typedef struct iss_insn_s {
+// Result of the decoding of an opcode at a given address. As it only depends on
+// the code and on the ISA, it is shared, read-only, by all the cores using the
+// same ISS library, and each core only copies what its handlers need into its
+// own instructions.
+typedef struct iss_decoded_insn_s {
+  iss_decoded_insn_t *next;
   iss_addr_t addr;
-  iss_reg_t opcode;
-  iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*hwloop_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*stall_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*stall_fast_handler)(iss_t *, iss_insn_t*);
-  int size;
+  iss_opcode_t opcode;
+  iss_decoder_item_t *decoder_item;
   int nb_out_reg;
   int nb_in_reg;
-  int out_regs[ISS_MAX_NB_OUT_REGS];
-  int in_regs[ISS_MAX_NB_IN_REGS];
+  int8_t out_regs[ISS_MAX_NB_OUT_REGS];
+  int8_t in_regs[ISS_MAX_NB_IN_REGS];
   iss_uim_t uim[ISS_MAX_IMMEDIATES];
   iss_sim_t sim[ISS_MAX_IMMEDIATES];
   iss_insn_arg_t args[ISS_MAX_DECODE_ARGS];
-  iss_insn_t *next;
-  iss_decoder_item_t *decoder_item;
+} iss_decoded_insn_t;
 
-  iss_insn_t *(*saved_handler)(iss_t *, iss_insn_t*);
+// Instruction fields used when executing instructions with the fast handlers,
+// packed into one cache line on 32 bits cores. Everything else is in the cold
+// part of the instruction.
+typedef struct iss_insn_s {
+  iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *next;
   iss_insn_t *branch;
-
+  iss_addr_t addr;
+  iss_uim_t uim[ISS_MAX_IMMEDIATES];
+  iss_sim_t sim[ISS_MAX_IMMEDIATES];
+  int8_t out_regs[ISS_MAX_NB_OUT_REGS];
+  int8_t in_regs[ISS_MAX_NB_IN_REGS];
+  uint8_t size;
+
+  // Number of instructions of the superblock starting at this instruction,
+  // computed the first time it is executed, 0 if not yet known.
+  int16_t superblock_size;
+} __attribute__((aligned(64))) iss_insn_t;
+
+// Instruction fields only used for decoding, tracing, stalls, hardware loops
+// and when executing with the full handlers. They are stored in a side array
+// of the block, at the same index as the instruction. Only what a core can
+// patch is kept here, the rest is read from the shared decoding, which is NULL
+// if the instruction is not decoded or illegal.
+typedef struct iss_insn_cold_s {
+  iss_insn_t *(*handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*hwloop_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*stall_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*stall_fast_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*saved_handler)(iss_t *, iss_insn_t*);
+  iss_decoded_insn_t *decoded;
   int latency;
+} iss_insn_cold_t;
+
+static_assert((sizeof(iss_insn_t) & (sizeof(iss_insn_t) - 1)) == 0, "Instruction size must be a power of 2");
 
-} iss_insn_t;
+#define ISS_INSN_BLOCK_HOT_SIZE (sizeof(iss_insn_t) * ISS_INSN_BLOCK_SIZE)
 
+// Blocks are aligned on the size of their instructions array, so that the
+// block, and thus the cold part, can be found from the instruction address.
 typedef struct iss_insn_block_s {
-  iss_addr_t pc;
   iss_insn_t insns[ISS_INSN_BLOCK_SIZE];
-  iss_insn_block_t *next;
-} iss_insn_block_t;
+  iss_insn_cold_t cold[ISS_INSN_BLOCK_SIZE];
+} __attribute__((aligned(ISS_INSN_BLOCK_HOT_SIZE))) iss_insn_block_t;
+
+static inline iss_insn_cold_t *iss_insn_cold(iss_insn_t *insn)
+{
+  iss_insn_block_t *block = (iss_insn_block_t *)((uintptr_t)insn & ~(uintptr_t)(ISS_INSN_BLOCK_HOT_SIZE - 1));
+  return &block->cold[insn - block->insns];
+}
+
+static inline iss_opcode_t iss_insn_opcode(iss_insn_t *insn)
+{
+  iss_decoded_insn_t *decoded = iss_insn_cold(insn)->decoded;
+  return decoded ? decoded->opcode : 0;
+}
+
+typedef struct iss_insn_region_s {
+  iss_addr_t id;
+  iss_insn_region_t *next;
+  iss_insn_block_t *blocks[ISS_INSN_REGION_SIZE];
+} iss_insn_region_t;
+
+typedef struct iss_insn_arena_s {
+  iss_insn_arena_t *next;
+  iss_insn_block_t blocks[ISS_INSN_ARENA_NB_BLOCKS];
+} iss_insn_arena_t;
 
 typedef struct iss_insn_cache_s {
-  iss_insn_block_t *blocks[ISS_INSN_NB_BLOCKS];
+  iss_insn_region_t *regions[ISS_INSN_NB_REGIONS];
+
+  // Arenas are kept when the cache is flushed and blocks are allocated
+  // again from the first one.
+  iss_insn_arena_t *arenas;
+  iss_insn_arena_t *arena;
+  int arena_index;
+
+  // Statistics, dumped when the cache is flushed
+  uint64_t nb_lookups;
+  uint64_t nb_blocks;
+  uint64_t nb_region_steps;
 } iss_insn_cache_t;
 
 typedef struct iss_regfile_s {
@@ -370,6 +461,11 @@ typedef struct iss_cpu_state_s {
 
   iss_fcsr_t fcsr;
 
+  // Set while native float32 operations own the host floating-point
+  // environment, with the host rounding mode they last set
+  bool fp_host_owned;
+  unsigned int fp_host_round;
+
   iss_reg_t fprec;
 
   bool debug_mode;
@@ -24,6 +24,10 @@ instrLabelsList = []
 nb_insn = 0
 nb_decoder_tree = 0
 
+# Groups with wider opcodes are decoded by searching the sub-items, to keep the
+# tables small
+DECODER_TABLE_MAX_WIDTH = 12
+
 def append_insn_to_isa_tag(isa_tag, insn):
     global insn_isa_tags
     if insn_isa_tags.get(isa_tag) is None:
@@ -49,6 +53,9 @@ class Const(object):
     def gen_info(self, isaFile):
         dump(isaFile, '{ .type=ISS_DECODER_VALUE_TYPE_UIM, .u= { .uim= %d } }, ' % self.val)
 
+    def gen_value(self, is_signed=False):
+        return '%d' % self.val
+
     def gen(self, isaFile):
         pass
 
@@ -66,10 +73,37 @@ class Range(object):
         self.gen(isaFile)
         dump(isaFile, '} } } }, ')
 
+    def gen_field(self):
+        return '(((uint64_t)(opcode >> %d) & 0x%x) << %d)' % (self.first, (1 << self.width) - 1, self.shift)
+
+    def gen_value(self, is_signed=False):
+        return gen_ranges_value([self], is_signed)
+
 
     def len(self):
         return 1
 
+# Straight-line extraction of a value made of several opcode bit ranges, giving
+# the same result as decode_ranges in the decoder
+def gen_ranges_value(ranges, is_signed):
+    if len(ranges) == 0:
+        return '0'
+    value = ' | '.join([range.gen_field() for range in ranges])
+    if is_signed:
+        bits = max([range.width + range.shift for range in ranges])
+        return 'iss_get_signed_value(%s, %d)' % (value, bits)
+    return value
+
+# Register index extracted from the opcode, for an argument with the specified
+# decoder flags
+def gen_reg_index(info, flags):
+    value = info.gen_value()
+    if 'ISS_DECODER_ARG_FLAG_COMPRESSED' in flags:
+        value = '(%s) + 8' % value
+    if 'ISS_DECODER_ARG_FLAG_FREG' in flags:
+        value = '(%s) + ISS_FREG_OFFSET' % value
+    return value
+
 class Ranges(object):
     def __init__(self, fieldsList):
         self.ranges = []
@@ -84,6 +118,9 @@ class Ranges(object):
             range.gen(isaFile)
         dump(isaFile, '} } } }, ')
 
+    def gen_value(self, is_signed=False):
+        return gen_ranges_value(self.ranges, is_signed)
+
     def len(self):
         return len(self.ranges)
 
@@ -132,6 +169,30 @@ class Indirect(OpcodeField):
         else:
             dump(isaFile, level, '  %s(pc, %s, 0);\n' % (funcName, self.base.genTraceIndirect()))
 
+    def gen_decode(self, isaFile, index):
+        flags = ['ISS_DECODER_ARG_FLAG_NONE']
+        if self.postInc:
+            flags.append('ISS_DECODER_ARG_FLAG_POSTINC')
+        if self.preInc:
+            flags.append('ISS_DECODER_ARG_FLAG_PREINC')
+        arg = 'decoded->args[%d]' % index
+        base_flags = [flag for flag in self.base.flags if flag == 'ISS_DECODER_ARG_FLAG_COMPRESSED']
+        if self.offset.is_reg():
+            offset_flags = [flag for flag in self.offset.flags if flag == 'ISS_DECODER_ARG_FLAG_COMPRESSED']
+            dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_INDIRECT_REG;\n' % arg)
+            dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(flags)))
+            dump(isaFile, '  %s.u.indirect_reg.base_reg_index = %s;\n' % (arg, gen_reg_index(self.base.ranges, base_flags)))
+            dump(isaFile, '  decoded->in_regs[%d] = %s.u.indirect_reg.base_reg_index;\n' % (self.base.id, arg))
+            dump(isaFile, '  %s.u.indirect_reg.offset_reg_index = %s;\n' % (arg, gen_reg_index(self.offset.ranges, offset_flags)))
+            dump(isaFile, '  decoded->in_regs[%d] = %s.u.indirect_reg.offset_reg_index;\n' % (self.offset.id, arg))
+        else:
+            dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_INDIRECT_IMM;\n' % arg)
+            dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(flags)))
+            dump(isaFile, '  %s.u.indirect_imm.reg_index = %s;\n' % (arg, gen_reg_index(self.base.ranges, base_flags)))
+            dump(isaFile, '  decoded->in_regs[%d] = %s.u.indirect_imm.reg_index;\n' % (self.base.id, arg))
+            dump(isaFile, '  %s.u.indirect_imm.imm = %s;\n' % (arg, self.offset.ranges.gen_value(self.offset.isSigned)))
+            dump(isaFile, '  decoded->sim[%d] = %s.u.indirect_imm.imm;\n' % (self.offset.id, arg))
+
     def gen(self, isaFile, indent=0):
         if self.postInc:
             self.flags.append('ISS_DECODER_ARG_FLAG_POSTINC')
@@ -185,6 +246,13 @@ class SignedImm(OpcodeField):
         self.ranges.gen_info(isaFile)
         dump(isaFile, '}, ')
 
+    def gen_decode(self, isaFile, index):
+        arg = 'decoded->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_SIMM;\n' % arg)
+        dump(isaFile, '  %s.flags = ISS_DECODER_ARG_FLAG_NONE;\n' % arg)
+        dump(isaFile, '  %s.u.sim.value = %s;\n' % (arg, self.ranges.gen_value(self.isSigned)))
+        dump(isaFile, '  decoded->sim[%d] = %s.u.sim.value;\n' % (self.id, arg))
+
     def gen(self, isaFile, indent=0):
         dump(isaFile, '%s{\n' % (' '*indent))
         dump(isaFile, '%s  .type=ISS_DECODER_ARG_TYPE_SIMM,\n' % (' '*indent))
@@ -216,6 +284,13 @@ class UnsignedImm(OpcodeField):
         self.ranges.gen_info(isaFile)
         dump(isaFile, '}, ')
 
+    def gen_decode(self, isaFile, index):
+        arg = 'decoded->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_UIMM;\n' % arg)
+        dump(isaFile, '  %s.flags = ISS_DECODER_ARG_FLAG_NONE;\n' % arg)
+        dump(isaFile, '  %s.u.uim.value = %s;\n' % (arg, self.ranges.gen_value(self.isSigned)))
+        dump(isaFile, '  decoded->uim[%d] = %s.u.uim.value;\n' % (self.id, arg))
+
     def gen(self, isaFile, indent=0):
         dump(isaFile, '%s{\n' % (' '*indent))
         dump(isaFile, '%s  .type=ISS_DECODER_ARG_TYPE_UIMM,\n' % (' '*indent))
@@ -244,6 +319,13 @@ class OutReg(OpcodeField):
         self.ranges.gen_info(isaFile)
         dump(isaFile, '}, ')
 
+    def gen_decode(self, isaFile, index):
+        arg = 'decoded->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_OUT_REG;\n' % arg)
+        dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(self.flags)))
+        dump(isaFile, '  %s.u.reg.index = %s;\n' % (arg, gen_reg_index(self.ranges, self.flags)))
+        dump(isaFile, '  decoded->out_regs[%d] = %s.u.reg.index;\n' % (self.id, arg))
+
     def gen(self, isaFile, indent=0):
         dump(isaFile, '%s{\n' % (' '*indent))
         dump(isaFile, '%s  .type=ISS_DECODER_ARG_TYPE_OUT_REG,\n' % (' '*indent))
@@ -296,6 +378,13 @@ class InReg(OpcodeField):
         self.ranges.gen_info(isaFile)
         dump(isaFile, '}, ')
 
+    def gen_decode(self, isaFile, index):
+        arg = 'decoded->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_IN_REG;\n' % arg)
+        dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(self.flags)))
+        dump(isaFile, '  %s.u.reg.index = %s;\n' % (arg, gen_reg_index(self.ranges, self.flags)))
+        dump(isaFile, '  decoded->in_regs[%d] = %s.u.reg.index;\n' % (self.id, arg))
+
     def gen(self, isaFile, indent=0):
         dump(isaFile, '%s{\n' % (' '*indent))
         dump(isaFile, '%s  .type=ISS_DECODER_ARG_TYPE_IN_REG,\n' % (' '*indent))
@@ -529,6 +618,24 @@ class DecodeTree(object):
              
                 self.dump(' };\n')
 
+                # Flat table giving the sub-item for each value of the group
+                # opcode, so that the decoder does not have to search for it
+                has_table = self.opcode_width <= DECODER_TABLE_MAX_WIDTH
+                if has_table:
+                    table = [self.subtrees.get('OTHERS')] * (1 << self.opcode_width)
+                    matched = [False] * (1 << self.opcode_width)
+                    for opcode, subtree in self.subtrees.items():
+                        if opcode == 'OTHERS': continue
+                        value = int(opcode, 2) if len(opcode) != 0 else 0
+                        # As for the search, the first matching item wins
+                        if not matched[value]:
+                            matched[value] = True
+                            table[value] = subtree
+                    self.dump('static iss_decoder_item_t *%s_table[] = {\n' % self.get_name())
+                    for subtree in table:
+                        self.dump('  %s,\n' % ('NULL' if subtree is None else '&' + subtree.get_name()))
+                    self.dump('};\n')
+
                 self.dump('%siss_decoder_item_t %s = {\n' % ('' if is_top else 'static ', self.get_name()))
                 self.dump('  .is_insn=false,\n')
                 self.dump('  .is_active=false,\n')
@@ -539,7 +646,8 @@ class DecodeTree(object):
                 self.dump('      .bit=%d,\n' % self.firstBit)
                 self.dump('      .width=%d,\n' % self.opcode_width)
                 self.dump('      .nb_groups=%d,\n' % len(self.subtrees))
-                self.dump('      .groups=%s_groups\n' % self.get_name())
+                self.dump('      .groups=%s_groups,\n' % self.get_name())
+                self.dump('      .table=%s\n' % ('%s_table' % self.get_name() if has_table else 'NULL'))
                 self.dump('    }\n')
                 self.dump('  }\n')
                 self.dump('};\n')
@@ -980,10 +1088,31 @@ class Instr(object):
     def genCall(self, isaFile, level):
         self.dump(isaFile, '%s(cpu, pc);\n' % (self.decodeFunc), level)
 
+    # Decoding of the arguments of this instruction, with all the opcode
+    # fields extracted by straight-line code
+    def gen_decode_args(self, isaFile, name):
+        self.dump(isaFile, 'static void %s_decode_args(iss_decoded_insn_t *decoded, iss_opcode_t opcode)\n' % (name))
+        self.dump(isaFile, '{\n')
+        nb_out_reg = 0
+        nb_in_reg = 0
+        for index, arg in enumerate(self.args):
+            arg.gen_decode(isaFile, index)
+            if arg.is_reg():
+                if arg.is_out():
+                    nb_out_reg = max(nb_out_reg, arg.id + 1)
+                else:
+                    nb_in_reg = max(nb_in_reg, arg.id + 1)
+        self.dump(isaFile, '  decoded->nb_out_reg = %d;\n' % (nb_out_reg))
+        self.dump(isaFile, '  decoded->nb_in_reg = %d;\n' % (nb_in_reg))
+        self.dump(isaFile, '}\n')
+        self.dump(isaFile, '\n')
+
     def gen(self, isaFile, opcode, others=False):
 
         name = self.get_full_name()
 
+        self.gen_decode_args(isaFile, name)
+
         self.dump(isaFile, 'static iss_decoder_item_t %s = {\n' % (name))
         self.dump(isaFile, '  .is_insn=true,\n')
         self.dump(isaFile, '  .is_active=false,\n')
@@ -994,6 +1123,7 @@ class Instr(object):
         self.dump(isaFile, '      .handler=%s,\n' % self.execFunc)
         self.dump(isaFile, '      .fast_handler=%s,\n' % self.quick_execFunc)
         self.dump(isaFile, '      .decode=%s,\n' % ('NULL' if self.decode is None else self.decode))
+        self.dump(isaFile, '      .decode_args=%s_decode_args,\n' % (name))
         self.dump(isaFile, '      .label=(char *)"%s",\n' % (self.getLabel()))
         self.dump(isaFile, '      .size=%d,\n' % (self.len/8))
         self.dump(isaFile, '      .nb_args=%d,\n' % (len(self.args)))
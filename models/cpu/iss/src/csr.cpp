@@ -125,11 +125,13 @@ static bool uip_write(iss_t *iss, unsigned int value) {
 
 
 static bool fflags_read(iss_t *iss, iss_reg_t *value) {
+  lib_float_host_release(&iss->cpu.state);
   *value = iss->cpu.state.fcsr.fflags.raw;
   return false;
 }
 
 static bool fflags_write(iss_t *iss, unsigned int value) {
+  lib_float_host_release(&iss->cpu.state);
   iss->cpu.state.fcsr.fflags.raw = value;
   return false;
 }
@@ -149,11 +151,13 @@ static bool frm_write(iss_t *iss, unsigned int value) {
 
 
 static bool fcsr_read(iss_t *iss, iss_reg_t *value) {
+  lib_float_host_release(&iss->cpu.state);
   *value = iss->cpu.state.fcsr.raw;
   return false;
 }
 
 static bool fcsr_write(iss_t *iss, unsigned int value) {
+  lib_float_host_release(&iss->cpu.state);
   iss->cpu.state.fcsr.raw = value & 0xff;
   return false;
 }
@@ -20,11 +20,22 @@
 
 #include "iss.hpp"
 #include <string.h>
+#include <pthread.h>
 
 extern iss_isa_set_t __iss_isa_set;
 extern iss_isa_tag_t __iss_isa_tags[];
 
-static int decode_item(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item);
+// Decoded instructions shared by all the cores, hashed by address. The decoder
+// tables are global to the ISS library, so are the decoded instructions, which
+// are thus implicitly keyed by the ISA configuration. Cores from different
+// partitions can decode at the same time, hence the lock.
+#define ISS_DECODE_STORE_SIZE_LOG2 14
+#define ISS_DECODE_STORE_SIZE (1<<ISS_DECODE_STORE_SIZE_LOG2)
+
+static iss_decoded_insn_t *decode_store[ISS_DECODE_STORE_SIZE];
+static pthread_mutex_t decode_store_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int decode_item(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode, iss_decoder_item_t *item);
 
 static uint64_t decode_ranges(iss_t *iss, iss_opcode_t opcode, iss_decoder_range_set_t *range_set, bool is_signed)
 {
@@ -44,7 +55,7 @@ static uint64_t decode_ranges(iss_t *iss, iss_opcode_t opcode, iss_decoder_range
 }
 
 
-static int decode_info(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_arg_info_t *info, bool is_signed)
+static int decode_info(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode, iss_decoder_arg_info_t *info, bool is_signed)
 {
   if (info->type == ISS_DECODER_VALUE_TYPE_RANGE)
   {
@@ -62,31 +73,32 @@ static int decode_info(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
   return 0;
 }
 
-static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_insn(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
   if (!item->is_active) return -1;
 
-  insn->latency = 0;
-  insn->hwloop_handler = NULL;
-  insn->fast_handler = item->u.insn.fast_handler;
-  insn->handler = item->u.insn.handler;
+  decoded->decoder_item = item;
+  decoded->nb_out_reg = 0;
+  decoded->nb_in_reg = 0;
 
-  insn->decoder_item = item;
-  insn->size = item->u.insn.size;
-  insn->nb_out_reg = 0;
-  insn->nb_in_reg = 0;
-  insn->latency = item->u.insn.latency;
+  for (int i=0; i<ISS_MAX_NB_OUT_REGS; i++)
+    decoded->out_regs[i] = -1;
 
-  for (int i=0; i<item->u.insn.nb_args; i++)
+  for (int i=0; i<ISS_MAX_NB_IN_REGS; i++)
+    decoded->in_regs[i] = -1;
+
+  // Generated decoders extract the arguments with straight-line code, the
+  // generic decoding below is only used for older ISA descriptions
+  if (item->u.insn.decode_args)
   {
-    insn->out_regs[i] = -1;
-    insn->in_regs[i] = -1;
+    item->u.insn.decode_args(decoded, opcode);
+    return 0;
   }
 
   for (int i=0; i<item->u.insn.nb_args; i++)
   {
     iss_decoder_arg_t *darg = &item->u.insn.args[i];
-    iss_insn_arg_t *arg = &insn->args[i];
+    iss_insn_arg_t *arg = &decoded->args[i];
     arg->type = darg->type;
     arg->flags = darg->flags;
 
@@ -94,7 +106,7 @@ static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
     {
       case ISS_DECODER_ARG_TYPE_IN_REG:
       case ISS_DECODER_ARG_TYPE_OUT_REG:
-        arg->u.reg.index = decode_info(iss, insn, opcode, &darg->u.reg.info, false);
+        arg->u.reg.index = decode_info(iss, decoded, opcode, &darg->u.reg.info, false);
         
         if (darg->flags & ISS_DECODER_ARG_FLAG_COMPRESSED)
           arg->u.reg.index += 8;
@@ -105,128 +117,89 @@ static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
 #endif
 
         if (darg->type == ISS_DECODER_ARG_TYPE_IN_REG) {
-          if (darg->u.reg.id >= insn->nb_in_reg)
-            insn->nb_in_reg = darg->u.reg.id + 1;
+          if (darg->u.reg.id >= decoded->nb_in_reg)
+            decoded->nb_in_reg = darg->u.reg.id + 1;
 
-          insn->in_regs[darg->u.reg.id] = arg->u.reg.index;
+          decoded->in_regs[darg->u.reg.id] = arg->u.reg.index;
         }
         else {
-          if (darg->u.reg.id >= insn->nb_out_reg)
-            insn->nb_out_reg = darg->u.reg.id + 1;
-
-          insn->out_regs[darg->u.reg.id] = arg->u.reg.index;
-        }
+          if (darg->u.reg.id >= decoded->nb_out_reg)
+            decoded->nb_out_reg = darg->u.reg.id + 1;
 
-        if (darg->type == ISS_DECODER_ARG_TYPE_OUT_REG && darg->u.reg.latency != 0)
-        {
-          iss_insn_t *next = insn_cache_get_decoded(iss, insn->addr + insn->size);
-
-          // We can stall the next instruction either if latency is superior
-          // to 2 (due to number of pipeline stages) or if there is a data
-          // dependency
-
-          // Go through the registers and set the handler to the stall handler
-          // in case we find a register dependency so that we can properly
-          // handle the stall
-          bool set_pipe_latency = true;
-          for (int j=0; j<next->nb_in_reg; j++)
-          {
-            if (next->in_regs[j] == arg->u.reg.index)
-            {
-              insn->latency += darg->u.reg.latency;
-              set_pipe_latency = false;
-              break;
-            }
-          }
-
-          // If no dependency was found, apply the one for the pipeline stages
-          if (set_pipe_latency && darg->u.reg.latency > PIPELINE_STAGES)
-          {
-            insn->latency += darg->u.reg.latency - PIPELINE_STAGES + 1;
-          }
+          decoded->out_regs[darg->u.reg.id] = arg->u.reg.index;
         }
 
-
         break;
 
       case ISS_DECODER_ARG_TYPE_UIMM:
         arg->u.uim.value = decode_ranges(iss, opcode, &darg->u.uimm.info.u.range_set, darg->u.uimm.is_signed);
-        insn->uim[darg->u.uimm.id] = arg->u.uim.value;
+        decoded->uim[darg->u.uimm.id] = arg->u.uim.value;
         break;
 
       case ISS_DECODER_ARG_TYPE_SIMM:
         arg->u.sim.value = decode_ranges(iss, opcode, &darg->u.simm.info.u.range_set, darg->u.simm.is_signed);
-        insn->sim[darg->u.simm.id] = arg->u.sim.value;
+        decoded->sim[darg->u.simm.id] = arg->u.sim.value;
         break;
 
       case ISS_DECODER_ARG_TYPE_INDIRECT_IMM:
-        arg->u.indirect_imm.reg_index = decode_info(iss, insn, opcode, &darg->u.indirect_imm.reg.info, false);
+        arg->u.indirect_imm.reg_index = decode_info(iss, decoded, opcode, &darg->u.indirect_imm.reg.info, false);
         if (darg->u.indirect_imm.reg.flags & ISS_DECODER_ARG_FLAG_COMPRESSED) arg->u.indirect_imm.reg_index += 8;
-        insn->in_regs[darg->u.indirect_imm.reg.id] = arg->u.indirect_imm.reg_index;
-        arg->u.indirect_imm.imm = decode_info(iss, insn, opcode, &darg->u.indirect_imm.imm.info, darg->u.indirect_imm.imm.is_signed);
-        insn->sim[darg->u.indirect_imm.imm.id] = arg->u.indirect_imm.imm;
+        decoded->in_regs[darg->u.indirect_imm.reg.id] = arg->u.indirect_imm.reg_index;
+        arg->u.indirect_imm.imm = decode_info(iss, decoded, opcode, &darg->u.indirect_imm.imm.info, darg->u.indirect_imm.imm.is_signed);
+        decoded->sim[darg->u.indirect_imm.imm.id] = arg->u.indirect_imm.imm;
         break;
 
       case ISS_DECODER_ARG_TYPE_INDIRECT_REG:
-        arg->u.indirect_reg.base_reg_index = decode_info(iss, insn, opcode, &darg->u.indirect_reg.base_reg.info, false);
+        arg->u.indirect_reg.base_reg_index = decode_info(iss, decoded, opcode, &darg->u.indirect_reg.base_reg.info, false);
         if (darg->u.indirect_reg.base_reg.flags & ISS_DECODER_ARG_FLAG_COMPRESSED) arg->u.indirect_reg.base_reg_index += 8;
-        insn->in_regs[darg->u.indirect_reg.base_reg.id] = arg->u.indirect_reg.base_reg_index;
+        decoded->in_regs[darg->u.indirect_reg.base_reg.id] = arg->u.indirect_reg.base_reg_index;
 
-        arg->u.indirect_reg.offset_reg_index = decode_info(iss, insn, opcode, &darg->u.indirect_reg.offset_reg.info, false);
+        arg->u.indirect_reg.offset_reg_index = decode_info(iss, decoded, opcode, &darg->u.indirect_reg.offset_reg.info, false);
         if (darg->u.indirect_reg.offset_reg.flags & ISS_DECODER_ARG_FLAG_COMPRESSED) arg->u.indirect_reg.offset_reg_index += 8;
-        insn->in_regs[darg->u.indirect_reg.offset_reg.id] = arg->u.indirect_reg.offset_reg_index;
+        decoded->in_regs[darg->u.indirect_reg.offset_reg.id] = arg->u.indirect_reg.offset_reg_index;
 
         break;
     }
   }
 
-  insn->next = insn_cache_get(iss, insn->addr + insn->size);
-
-  if (item->u.insn.decode != NULL)
-  {
-    item->u.insn.decode(iss, insn);
-  }
-
-  if (insn->latency)
-  {
-    insn->stall_handler = insn->handler;
-    insn->stall_fast_handler = insn->fast_handler;
-    insn->handler = iss_exec_stalled_insn;
-    insn->fast_handler = iss_exec_stalled_insn_fast;
-  }
-
   return 0;
 }
 
-static int decode_opcode_group(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_opcode_group(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
   iss_opcode_t group_opcode = (opcode >> item->u.group.bit) & ((1ULL << item->u.group.width) - 1);
   iss_decoder_item_t *group_item_other = NULL;
 
+  if (likely(item->u.group.table != NULL))
+  {
+    iss_decoder_item_t *group_item = item->u.group.table[group_opcode];
+    return group_item ? decode_item(iss, decoded, opcode, group_item) : -1;
+  }
+
   for (int i=0; i<item->u.group.nb_groups; i++)
   {
     iss_decoder_item_t *group_item = item->u.group.groups[i];
-    if (group_opcode == group_item->opcode && !group_item->opcode_others) return decode_item(iss, insn, opcode, group_item);
+    if (group_opcode == group_item->opcode && !group_item->opcode_others) return decode_item(iss, decoded, opcode, group_item);
     if (group_item->opcode_others) group_item_other = group_item;
   }
 
-  if (group_item_other) return decode_item(iss, insn, opcode, group_item_other);
+  if (group_item_other) return decode_item(iss, decoded, opcode, group_item_other);
 
   return -1;
 }
 
-static int decode_item(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_item(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
-  if (item->is_insn) return decode_insn(iss, insn, opcode, item);
-  else return decode_opcode_group(iss, insn, opcode, item);
+  if (item->is_insn) return decode_insn(iss, decoded, opcode, item);
+  else return decode_opcode_group(iss, decoded, opcode, item);
 }
 
-static int decode_opcode(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode)
+static int decode_opcode(iss_t *iss, iss_decoded_insn_t *decoded, iss_opcode_t opcode)
 {
   for (int i=0; i<__iss_isa_set.nb_isa; i++)
   {
     iss_isa_t *isa = &__iss_isa_set.isa_set[i];
-    if (decode_item(iss, insn, opcode, isa->tree) == 0) return 0;
+    if (decode_item(iss, decoded, opcode, isa->tree) == 0) return 0;
   }
 
   iss_decoder_msg(iss, "Unknown instruction\n");
@@ -234,6 +207,115 @@ static int decode_opcode(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode)
   return -1;
 }
 
+// Return the shared decoding of the specified opcode, decoding it if no core
+// did it yet, or NULL if the opcode is unknown
+static iss_decoded_insn_t *decode_store_get(iss_t *iss, iss_addr_t addr, iss_opcode_t opcode)
+{
+  iss_decoded_insn_t **head = &decode_store[(addr >> 1) & (ISS_DECODE_STORE_SIZE - 1)];
+  iss_decoded_insn_t *decoded;
+
+  pthread_mutex_lock(&decode_store_mutex);
+
+  // The code may have been modified since the first decoding, in which case
+  // several opcodes are kept for the same address
+  decoded = *head;
+  while (decoded && (decoded->addr != addr || decoded->opcode != opcode))
+    decoded = decoded->next;
+
+  if (decoded == NULL)
+  {
+    decoded = (iss_decoded_insn_t *)calloc(1, sizeof(iss_decoded_insn_t));
+    decoded->addr = addr;
+    decoded->opcode = opcode;
+
+    if (decode_opcode(iss, decoded, opcode) == -1)
+    {
+      free(decoded);
+      decoded = NULL;
+    }
+    else
+    {
+      decoded->next = *head;
+      *head = decoded;
+    }
+  }
+
+  pthread_mutex_unlock(&decode_store_mutex);
+
+  return decoded;
+}
+
+// Fill the core instruction from the shared decoding. This is where everything
+// depending on the core is done, like pointers to its other instructions.
+static void decode_insn_init(iss_t *iss, iss_insn_t *insn, iss_decoded_insn_t *decoded)
+{
+  iss_decoder_item_t *item = decoded->decoder_item;
+  iss_insn_cold_t *cold = iss_insn_cold(insn);
+
+  cold->decoded = decoded;
+  cold->hwloop_handler = NULL;
+  insn->fast_handler = item->u.insn.fast_handler;
+  cold->handler = item->u.insn.handler;
+  insn->size = item->u.insn.size;
+  memcpy(insn->out_regs, decoded->out_regs, sizeof(insn->out_regs));
+  memcpy(insn->in_regs, decoded->in_regs, sizeof(insn->in_regs));
+  memcpy(insn->uim, decoded->uim, sizeof(insn->uim));
+  memcpy(insn->sim, decoded->sim, sizeof(insn->sim));
+  cold->latency = item->u.insn.latency;
+
+  for (int i=0; i<item->u.insn.nb_args; i++)
+  {
+    iss_decoder_arg_t *darg = &item->u.insn.args[i];
+    iss_insn_arg_t *arg = &decoded->args[i];
+
+    if (darg->type == ISS_DECODER_ARG_TYPE_OUT_REG && darg->u.reg.latency != 0)
+    {
+      iss_insn_t *next = insn_cache_get_decoded(iss, insn->addr + insn->size);
+
+      // We can stall the next instruction either if latency is superior
+      // to 2 (due to number of pipeline stages) or if there is a data
+      // dependency
+
+      // Go through the registers and set the handler to the stall handler
+      // in case we find a register dependency so that we can properly
+      // handle the stall
+      bool set_pipe_latency = true;
+      iss_decoded_insn_t *next_decoded = iss_insn_cold(next)->decoded;
+      int next_nb_in_reg = next_decoded ? next_decoded->nb_in_reg : 0;
+      for (int j=0; j<next_nb_in_reg; j++)
+      {
+        if (next->in_regs[j] == arg->u.reg.index)
+        {
+          cold->latency += darg->u.reg.latency;
+          set_pipe_latency = false;
+          break;
+        }
+      }
+
+      // If no dependency was found, apply the one for the pipeline stages
+      if (set_pipe_latency && darg->u.reg.latency > PIPELINE_STAGES)
+      {
+        cold->latency += darg->u.reg.latency - PIPELINE_STAGES + 1;
+      }
+    }
+  }
+
+  insn->next = insn_cache_get(iss, insn->addr + insn->size);
+
+  if (item->u.insn.decode != NULL)
+  {
+    item->u.insn.decode(iss, insn);
+  }
+
+  if (cold->latency)
+  {
+    cold->stall_handler = cold->handler;
+    cold->stall_fast_handler = insn->fast_handler;
+    cold->handler = iss_exec_stalled_insn;
+    insn->fast_handler = iss_exec_stalled_insn_fast;
+  }
+}
+
 
 void iss_decode_activate_isa(iss_t *cpu, char *name)
 {
@@ -269,19 +351,22 @@ iss_insn_t *iss_decode_pc_noexec(iss_t *iss, iss_insn_t *insn)
 
   iss_decoder_msg(iss, "Got opcode (opcode: 0x%lx)\n", opcode);
 
-  if (decode_opcode(iss, insn, opcode) == -1)
+  iss_decoded_insn_t *decoded = decode_store_get(iss, insn->addr, opcode);
+  iss_insn_cold_t *cold = iss_insn_cold(insn);
+  if (decoded == NULL)
   {
-    insn->handler = iss_exec_insn_illegal;
+    cold->decoded = NULL;
+    cold->handler = iss_exec_insn_illegal;
     insn->fast_handler = iss_exec_insn_illegal;
     return insn;
   }
 
-  insn->opcode = opcode;
+  decode_insn_init(iss, insn, decoded);
 
   if (iss_insn_trace_active(iss) || iss_insn_event_active(iss))
   {
-    insn->saved_handler = insn->handler;
-    insn->handler = iss_exec_insn_with_trace;
+    cold->saved_handler = cold->handler;
+    cold->handler = iss_exec_insn_with_trace;
     insn->fast_handler = iss_exec_insn_with_trace;
   }
 
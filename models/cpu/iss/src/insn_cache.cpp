@@ -28,33 +28,48 @@ static void flush_cache(iss_t *iss, iss_insn_cache_t *cache)
 {
   prefetcher_flush(iss);
 
-  for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
+  iss_msg(iss, "Flushing instruction cache (lookups: %ld, blocks: %ld, region chain steps: %ld)\n",
+    cache->nb_lookups, cache->nb_blocks, cache->nb_region_steps);
+
+  for (int i=0; i<ISS_INSN_NB_REGIONS; i++)
   {
-    iss_insn_block_t *b = cache->blocks[i];
-    while(b)
+    iss_insn_region_t *region = cache->regions[i];
+    while(region)
     {
-      iss_insn_block_t *next = b->next;
-      free((void *)b);
-      b = next;
+      iss_insn_region_t *next = region->next;
+      free((void *)region);
+      region = next;
     }
-    cache->blocks[i] = NULL;
- }
+    cache->regions[i] = NULL;
+  }
+
+  cache->arena = NULL;
+  cache->arena_index = 0;
 }
 
 
 int insn_cache_init(iss_t *iss)
 {
   iss_insn_cache_t *cache = &iss->cpu.insn_cache;
-  memset(cache->blocks, 0, sizeof(iss_insn_block_t *)*ISS_INSN_NB_BLOCKS);
+  memset(cache->regions, 0, sizeof(iss_insn_region_t *)*ISS_INSN_NB_REGIONS);
+  cache->arenas = NULL;
+  cache->arena = NULL;
+  cache->arena_index = 0;
+  cache->nb_lookups = 0;
+  cache->nb_blocks = 0;
+  cache->nb_region_steps = 0;
   return 0;
 }
 
 void insn_init(iss_insn_t *insn, iss_addr_t addr) {
-  insn->handler = iss_decode_pc;
+  iss_insn_cold_t *cold = iss_insn_cold(insn);
+  cold->handler = iss_decode_pc;
   insn->fast_handler = iss_decode_pc;
   insn->addr = addr;
   insn->next = NULL;
-  insn->hwloop_handler = NULL;
+  cold->hwloop_handler = NULL;
+  cold->decoded = NULL;
+  insn->superblock_size = 0;
 }
 
 static void insn_block_init(iss_insn_block_t *b, iss_addr_t pc)
@@ -82,34 +97,121 @@ void iss_cache_flush(iss_t *iss)
 
 
 
+static iss_insn_block_t *insn_block_alloc(iss_t *iss, iss_insn_cache_t *cache)
+{
+  if (cache->arena == NULL || cache->arena_index == ISS_INSN_ARENA_NB_BLOCKS)
+  {
+    iss_insn_arena_t *next = cache->arena ? cache->arena->next : cache->arenas;
+    if (next == NULL)
+    {
+      // Blocks must be aligned so that the cold part of the instructions can be
+      // found from their address
+      if (posix_memalign((void **)&next, alignof(iss_insn_arena_t), sizeof(iss_insn_arena_t)))
+      {
+        iss_fatal(iss, "Failed to allocate instruction block arena (size: %ld)\n", sizeof(iss_insn_arena_t));
+        abort();
+      }
+      next->next = NULL;
+      if (cache->arena)
+        cache->arena->next = next;
+      else
+        cache->arenas = next;
+    }
+
+    cache->arena = next;
+    cache->arena_index = 0;
+  }
+
+  return &cache->arena->blocks[cache->arena_index++];
+}
+
+
+
+static iss_insn_region_t *insn_region_new(iss_t *iss, iss_insn_cache_t *cache, iss_addr_t region_id)
+{
+  iss_insn_region_t *region = (iss_insn_region_t *)malloc(sizeof(iss_insn_region_t));
+  unsigned int index = region_id & (ISS_INSN_NB_REGIONS - 1);
+
+  if (region == NULL)
+  {
+    iss_fatal(iss, "Failed to allocate instruction region (size: %ld)\n", sizeof(iss_insn_region_t));
+    abort();
+  }
+
+  region->id = region_id;
+  memset(region->blocks, 0, sizeof(iss_insn_block_t *)*ISS_INSN_REGION_SIZE);
+
+  region->next = cache->regions[index];
+  cache->regions[index] = region;
+
+  return region;
+}
+
+
+
 iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc)
 {
-  iss_addr_t pc_base = pc & ~((1 << (ISS_INSN_BLOCK_SIZE_LOG2 + ISS_INSN_PC_BITS)) - 1);
+  iss_addr_t block_id = pc >> ISS_INSN_BLOCK_OFFSET_BITS;
+  iss_addr_t region_id = block_id >> ISS_INSN_REGION_SIZE_LOG2;
   unsigned insn_id = (pc >> ISS_INSN_PC_BITS) & (ISS_INSN_BLOCK_SIZE - 1);
-  unsigned int block_id = pc_base & (ISS_INSN_NB_BLOCKS - 1);
   iss_insn_cache_t *cache = &iss->cpu.insn_cache;
-  iss_insn_block_t *block = cache->blocks[block_id];
 
-  while (block)
+  cache->nb_lookups++;
+
+  // Regions only need to be chained for 64 bits addresses
+  iss_insn_region_t *region = cache->regions[region_id & (ISS_INSN_NB_REGIONS - 1)];
+  while (region && region->id != region_id)
   {
-    if (block->pc == pc_base) return &block->insns[insn_id];
-    block = block->next;
+    cache->nb_region_steps++;
+    region = region->next;
   }
 
-  iss_insn_block_t *b = (iss_insn_block_t *)malloc(sizeof(iss_insn_block_t));
-  b->pc = pc_base;
-  
-  b->next = cache->blocks[block_id];
-  cache->blocks[block_id] = b;
+  if (unlikely(region == NULL))
+    region = insn_region_new(iss, cache, region_id);
 
-  insn_block_init(b, pc_base);
+  iss_insn_block_t **block = &region->blocks[block_id & (ISS_INSN_REGION_SIZE - 1)];
+  if (unlikely(*block == NULL))
+  {
+    iss_addr_t pc_base = block_id << ISS_INSN_BLOCK_OFFSET_BITS;
+    iss_insn_block_t *b = insn_block_alloc(iss, cache);
+    insn_block_init(b, pc_base);
+    cache->nb_blocks++;
+    *block = b;
+  }
 
-  return &b->insns[insn_id];
+  return &(*block)->insns[insn_id];
 }
 
 iss_insn_t *insn_cache_get_decoded(iss_t *iss, iss_addr_t pc)
 {
   iss_insn_t *insn = insn_cache_get(iss, pc);
-  if (insn->handler != iss_decode_pc) return insn;
+  if (iss_insn_cold(insn)->handler != iss_decode_pc) return insn;
   return iss_decode_pc_noexec(iss, insn);
 }
+
+int insn_cache_superblock(iss_t *iss, iss_insn_t *insn, int max_size)
+{
+  // Follow the sequential path through decoded instructions until something
+  // which can change the control flow or stall the core. The run still
+  // includes the ending instruction, which is what is executed before
+  // having to decide where to continue.
+  iss_insn_t *current = insn;
+  int size = 0;
+
+  while (size < max_size)
+  {
+    size++;
+
+    iss_insn_cold_t *cold = iss_insn_cold(current);
+    if (current->branch || cold->hwloop_handler || cold->latency)
+      break;
+
+    current = current->next;
+    if (current == NULL || current->fast_handler == iss_decode_pc)
+      break;
+  }
+
+  insn->superblock_size = size;
+
+  return size;
+}
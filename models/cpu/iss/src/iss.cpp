@@ -131,6 +131,10 @@ static int iss_parse_isa(iss_t *iss)
     }
   }
 
+  // Small floating-point formats are mostly computed through tables
+  if (has_f16 || has_f8)
+    lib_sf_init(has_f16, has_f8);
+
   //
   // Activate inter-dependent ISA extension subsets
   //
@@ -285,6 +289,8 @@ int iss_open(iss_t *iss)
   iss->cpu.regfile.regs[0] = 0;
   iss->cpu.current_insn = NULL;
   iss->cpu.state.fetch_cycles = 0;
+  iss->cpu.state.fp_host_owned = false;
+  iss->cpu.state.fp_host_round = 0;
 
   iss_irq_build(iss);
 
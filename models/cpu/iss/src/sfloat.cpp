@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include "iss.hpp"
+
+float lib_sf_f8_values[1<<8];
+float lib_sf_f16_values[1<<16];
+uint16_t lib_sf_f8_ops[SF_NB_OPS][4][1<<16];
+
+static bool f16_built = false;
+static bool f8_built = false;
+
+
+unsigned int lib_sf_to_float32_bits(unsigned int a, int e, int m)
+{
+  unsigned int exp_mask = (1 << e) - 1;
+  int bias = (1 << (e - 1)) - 1;
+  unsigned int sign = (a >> (e + m)) & 1;
+  unsigned int exp = (a >> m) & exp_mask;
+  unsigned int frac = a & ((1 << m) - 1);
+
+  // NaNs keep their payload, and thus their quiet bit
+  if (exp == exp_mask)
+    return (sign << 31) | 0x7f800000 | (frac << (23 - m));
+
+  float value;
+  if (exp == 0)
+    value = ldexpf(frac, 1 - bias - m);
+  else
+    value = ldexpf((1 << m) | frac, exp - bias - m);
+
+  union { float f; unsigned int i; } u = { value };
+  return (sign << 31) | u.i;
+}
+
+
+static void sf_build_values(float *values, int e, int m)
+{
+  for (unsigned int i=0; i<(1U << (1 + e + m)); i++)
+  {
+    union { unsigned int i; float f; } u = { lib_sf_to_float32_bits(i, e, m) };
+    values[i] = u.f;
+  }
+}
+
+
+static void sf_build_f8_ops()
+{
+  static const int host_modes[] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD };
+  int old = fegetround();
+  fexcept_t old_flags;
+  fegetexceptflag(&old_flags, FE_ALL_EXCEPT);
+
+  for (int mode=0; mode<4; mode++)
+  {
+    fesetround(host_modes[mode]);
+
+    for (unsigned int a=0; a<256; a++)
+    {
+      for (unsigned int b=0; b<256; b++)
+      {
+        for (int op=0; op<SF_NB_OPS; op++)
+        {
+          feclearexcept(FE_ALL_EXCEPT);
+
+          // Volatile so that the operation is done after the flags are cleared
+          volatile double da = lib_sf_f8_values[a];
+          volatile double db = lib_sf_f8_values[b];
+          double result;
+
+          switch (op)
+          {
+            case SF_OP_ADD: result = da + db; break;
+            case SF_OP_SUB: result = da - db; break;
+            case SF_OP_MUL: result = da * db; break;
+            default:        result = da / db; break;
+          }
+
+          int ex = fetestexcept(FE_DIVBYZERO | FE_INVALID);
+          unsigned int flags = (ex & FE_DIVBYZERO ? SF_FLAG_DZ : 0) | (ex & FE_INVALID ? SF_FLAG_NV : 0);
+          unsigned int bits = lib_sf_encode(result, 5, 2, mode, &flags, false);
+
+          lib_sf_f8_ops[op][mode][(a << 8) | b] = bits | (flags << 8);
+        }
+      }
+    }
+  }
+
+  fesetround(old);
+  fesetexceptflag(&old_flags, FE_ALL_EXCEPT);
+}
+
+
+void lib_sf_init(bool f16, bool f8)
+{
+  if (f16 && !f16_built)
+  {
+    sf_build_values(lib_sf_f16_values, 5, 10);
+    f16_built = true;
+  }
+
+  if (f8 && !f8_built)
+  {
+    sf_build_values(lib_sf_f8_values, 5, 2);
+    sf_build_f8_ops();
+    f8_built = true;
+  }
+}
@@ -311,7 +311,7 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
 
   char *start_buff = buff;
 
-  buff += sprintf(buff,  "%s ", insn->decoder_item->u.insn.label);
+  buff += sprintf(buff,  "%s ", iss_insn_cold(insn)->decoded->decoder_item->u.insn.label);
 
   if (is_long) {
     len = buff - start_buff;
@@ -326,9 +326,9 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
 
   iss_decoder_arg_t *prev_arg = NULL;
   start_buff = buff;
-  int nb_args = insn->decoder_item->u.insn.nb_args;
+  int nb_args = iss_insn_cold(insn)->decoded->decoder_item->u.insn.nb_args;
   for (int i=0; i<nb_args; i++) {
-    buff = iss_trace_dump_arg(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &prev_arg, is_long);
+    buff = iss_trace_dump_arg(iss, insn, buff, &iss_insn_cold(insn)->decoded->args[i], &iss_insn_cold(insn)->decoded->decoder_item->u.insn.args[i], &prev_arg, is_long);
   }
   if (nb_args != 0) buff += sprintf(buff,  " ");
 
@@ -347,10 +347,10 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
   {
     prev_arg = NULL;
     for (int i=0; i<nb_args; i++) {
-      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 1, is_long);
+      buff = iss_trace_dump_arg_value(iss, insn, buff, &iss_insn_cold(insn)->decoded->args[i], &iss_insn_cold(insn)->decoded->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 1, is_long);
     }
     for (int i=0; i<nb_args; i++) {
-      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 0, is_long);
+      buff = iss_trace_dump_arg_value(iss, insn, buff, &iss_insn_cold(insn)->decoded->args[i], &iss_insn_cold(insn)->decoded->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 0, is_long);
     }
 
     buff += sprintf(buff,  "\n");
@@ -392,9 +392,9 @@ static void iss_trace_save_arg(iss_t *iss, iss_insn_t *insn, iss_insn_arg_t *ins
 
 static void iss_trace_save_args(iss_t *iss, iss_insn_t *insn, iss_insn_arg_t saved_args[], bool save_out)
 {
-  for (int i=0; i<insn->decoder_item->u.insn.nb_args; i++) {
-    iss_decoder_arg_t *arg = &insn->decoder_item->u.insn.args[i];
-    iss_trace_save_arg(iss, insn, &insn->args[i], arg, &saved_args[i], save_out);
+  for (int i=0; i<iss_insn_cold(insn)->decoded->decoder_item->u.insn.nb_args; i++) {
+    iss_decoder_arg_t *arg = &iss_insn_cold(insn)->decoded->decoder_item->u.insn.args[i];
+    iss_trace_save_arg(iss, insn, &iss_insn_cold(insn)->decoded->args[i], arg, &saved_args[i], save_out);
   }
 }
 
@@ -440,14 +440,14 @@ iss_insn_t *iss_exec_insn_with_trace(iss_t *iss, iss_insn_t *insn)
   {
     iss_trace_save_args(iss, insn, iss->cpu.state.saved_args, false);
     
-    next_insn = iss_exec_insn_handler(iss, insn, insn->saved_handler);
+    next_insn = iss_exec_insn_handler(iss, insn, iss_insn_cold(insn)->saved_handler);
 
     if (!iss_exec_is_stalled(iss))
       iss_trace_dump(iss, insn);
   }
   else
   {
-    next_insn = iss_exec_insn_handler(iss, insn, insn->saved_handler);
+    next_insn = iss_exec_insn_handler(iss, insn, iss_insn_cold(insn)->saved_handler);
   }
 
 
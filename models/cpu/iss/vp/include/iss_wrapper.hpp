@@ -30,6 +30,15 @@
 #include "trace_debugger.h"
 #endif
 
+// Features requiring per-instruction work. The instruction handler is
+// instantiated for each combination so that none of them is checked when it
+// is disabled. Performance counters and step mode are handled by the
+// check_all handler.
+#define ISS_EXEC_FEATURE_TRACE      (1<<0)
+#define ISS_EXEC_FEATURE_IPC_STAT   (1<<1)
+#define ISS_EXEC_FEATURE_POWER      (1<<2)
+#define ISS_EXEC_NB_FEATURE_MASKS   (1<<3)
+
 class iss_wrapper : public vp::component
 {
 
@@ -48,11 +57,15 @@ public:
   static void fetch_grant(void *_this, vp::io_req *req);
   static void fetch_response(void *_this, vp::io_req *req);
 
-  static void exec_instr(void *__this, vp::clock_event *event);
+  static void data_dmi_inval(void *_this);
+  static void fetch_dmi_inval(void *_this);
+
+  template<int features> static void exec_instr(void *__this, vp::clock_event *event);
   static void exec_first_instr(void *__this, vp::clock_event *event);
   void exec_first_instr(vp::clock_event *event);
   static void exec_instr_check_all(void *__this, vp::clock_event *event);
   static inline void exec_misaligned(void *__this, vp::clock_event *event);
+  static void exec_sync_access(void *__this, vp::clock_event *event);
 
   static void irq_req_sync(void *__this, int irq);
   void debug_req();
@@ -79,6 +92,10 @@ public:
 
   inline void trigger_check_all() { current_event = check_all_event; }
 
+  // Select the instruction handler instantiation matching the features which
+  // are currently enabled. Must be called whenever one of them changes.
+  void update_exec_features();
+
   vp::io_master data;
   vp::io_master fetch;
   vp::io_slave  dbg_unit;
@@ -91,6 +108,16 @@ public:
   vp::io_req     io_req;
   vp::io_req     fetch_req;
 
+  // Direct accesses granted on data and fetch ports, or areas where they are
+  // denied, so that they are only asked again when going out of them.
+  vp::io_dmi     data_dmi;
+  vp::io_dmi     fetch_dmi;
+
+  // Set by anything done by an instruction which may have changed the state of
+  // other components, like accesses not going through direct accesses, so that
+  // the superblock being executed is stopped after this instruction.
+  bool superblock_exit = false;
+
   iss_cpu_t cpu;
 
   vp::trace     trace;
@@ -144,13 +171,24 @@ private:
 
   vp::clock_event *current_event;
   vp::clock_event *instr_event;
+  vp::clock_event *instr_events[ISS_EXEC_NB_FEATURE_MASKS];
+  int exec_features = 0;
   vp::clock_event *check_all_event;
   vp::clock_event *misaligned_event;
+  vp::clock_event *sync_access_event;
 
   int irq_req;
 
   int halt_cause;
   int64_t wakeup_latency;
+  int64_t batch_cycles;
+  int superblock_size;
+
+  // Temporal decoupling. The core can run ahead of its clock domain, by at
+  // most the quantum, when other events are pending. The number of cycles
+  // it is ahead is then accounted when the next instruction is enqueued.
+  int64_t quantum;
+  int64_t local_cycles = 0;
   int bootaddr_offset;
   iss_reg_t hit_reg = 0;
   bool riscv_dbg_unit;
@@ -163,6 +201,11 @@ private:
   iss_addr_t misaligned_addr;
   bool       misaligned_is_write;
   int64_t    misaligned_latency;
+  // First access, when it is delayed until the clock domain has caught up
+  // with the local time of the core
+  int        misaligned_first_size = 0;
+  uint8_t   *misaligned_first_data;
+  iss_addr_t misaligned_first_addr;
 
   vp::wire_slave<uint32_t> bootaddr_itf;
   vp::wire_slave<bool>     clock_itf;
@@ -177,22 +220,82 @@ private:
   static void fetchen_sync(void *_this, bool active);
   static void halt_sync(void *_this, bool active);
   inline void enqueue_next_instr(int64_t cycles);
+  inline bool batch_next_instr(vp::clock_event *event, int64_t cycles, int64_t *budget, int64_t quantum_cycles);
+  inline bool exec_superblocks(vp::clock_event *event, int64_t *budget, int *cycles);
   void halt_core();
 };
 \
+
+// Defined in isa_lib/int.h, must be called before calling other components, so
+// that they don't run with the floating-point environment of the core
+static inline void lib_float_host_release(iss_cpu_state_t *s);
+
 inline void iss_wrapper::enqueue_next_instr(int64_t cycles)
 {
   if (is_active_reg.get())
   {
+    // Let the clock domain reach the local time of the core
+    cycles += this->local_cycles;
+    this->local_cycles = 0;
+
     trace.msg("Enqueue next instruction (cycles: %ld)\n", cycles);
     event_enqueue(current_event, cycles);
   }
 }
 
+// Tells if the next instruction can be executed directly from the current
+// event callback. This is the case if the core state did not change and if no
+// other event would be executed before, in which case the clock engine is
+// moved forward so that the timing is the same as with one event per
+// instruction. With temporal decoupling, the core can also continue while
+// other events are pending, in which case it moves its local time instead.
+inline bool iss_wrapper::batch_next_instr(vp::clock_event *event, int64_t cycles, int64_t *budget, int64_t quantum_cycles)
+{
+  *budget -= cycles;
+
+  if (*budget <= 0 || current_event != event || !is_active_reg.get())
+    return false;
+
+  vp::clock_engine *clock = this->get_clock();
+  if (!clock->can_skip_cycles(cycles))
+  {
+    if (this->local_cycles + cycles >= quantum_cycles)
+      return false;
+
+    trace.msg("Decoupled next instruction (cycles: %ld, local_cycles: %ld)\n", cycles, this->local_cycles + cycles);
+    this->local_cycles += cycles;
+    return true;
+  }
+
+  trace.msg("Batch next instruction (cycles: %ld)\n", cycles);
+  clock->skip_cycles(cycles);
+
+  return true;
+}
+
 void iss_wrapper::exec_misaligned(void *__this, vp::clock_event *event)
 {
   iss_wrapper *_this = (iss_wrapper *)__this;
 
+  if (_this->misaligned_first_size)
+  {
+    // The clock domain is now at the time of the access, do the first one
+    // and the second one during the next cycle
+    int size = _this->misaligned_first_size;
+    _this->misaligned_first_size = 0;
+
+    if (_this->data_req_aligned(_this->misaligned_first_addr, _this->misaligned_first_data,
+      size, _this->misaligned_is_write) == vp::IO_REQ_OK)
+    {
+      _this->event_enqueue(_this->misaligned_event, _this->io_req.get_latency() + 1);
+    }
+    else
+    {
+      _this->trace.warning("UNIMPLEMENTED AT %s %d\n", __FILE__, __LINE__);
+    }
+    return;
+  }
+
   iss_exec_insn_resume(_this);
 
   // As the 2 load accesses for misaligned access are generated by the
@@ -216,15 +319,49 @@ void iss_wrapper::exec_misaligned(void *__this, vp::clock_event *event)
 inline int iss_wrapper::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, int size, bool is_write)
 {
   decode_trace.msg("Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n", addr, size, is_write);
+
+  if (unlikely(!data_dmi.is_inside(addr, size)))
+  {
+    data.dmi_req(addr, &data_dmi);
+  }
+
+  if (likely(data_dmi.is_granted(addr, size, is_write)))
+  {
+    if (is_write)
+      memcpy(data_dmi.get_mem(addr), data_ptr, size);
+    else
+      memcpy(data_ptr, data_dmi.get_mem(addr), size);
+
+    this->cpu.state.insn_cycles += data_dmi.latency;
+    return vp::IO_REQ_OK;
+  }
+
   vp::io_req *req = &io_req;
   req->init();
   req->set_addr(addr);
   req->set_size(size);
   req->set_is_write(is_write);
   req->set_data(data_ptr);
+  if (this->local_cycles)
+    req->set_decoupled();
+  this->superblock_exit = true;
+  lib_float_host_release(&this->cpu.state);
   int err = data.req(req);
   if (err == vp::IO_REQ_OK) 
   {
+    if (unlikely(req->is_sync_required()))
+    {
+      // The target must see the core at its local time, stall the
+      // instruction and send the request again once the clock domain has
+      // caught up.
+      trace.msg("Synchronizing before access (local_cycles: %ld)\n", this->local_cycles);
+      // The components on the path may have translated the address
+      req->set_addr(addr);
+      this->event_enqueue(this->sync_access_event, this->local_cycles);
+      this->local_cycles = 0;
+      return vp::IO_REQ_PENDING;
+    }
+
     this->cpu.state.insn_cycles += req->get_latency();
   }
   else if (err == vp::IO_REQ_INVALID) 
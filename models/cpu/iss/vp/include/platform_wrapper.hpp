@@ -143,17 +143,42 @@ static inline void iss_trigger_irq_check(iss_t *iss)
 
 static inline int iss_io_req(iss_t *_this, uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
 {
+  _this->superblock_exit = true;
+  lib_float_host_release(&_this->cpu.state);
   return _this->data.req(&_this->io_req);
 }
 
 static inline int iss_fetch_req_common(iss_t *_this, uint64_t addr, uint8_t *data, uint64_t size, bool is_write, bool timed)
 {
+  vp::io_dmi *dmi = &_this->fetch_dmi;
+
+  if (unlikely(!dmi->is_inside(addr, size)))
+  {
+    _this->fetch.dmi_req(addr, dmi);
+  }
+
+  if (likely(dmi->is_granted(addr, size, is_write)))
+  {
+    if (data)
+      memcpy(data, dmi->get_mem(addr), size);
+
+    if (dmi->latency)
+    {
+      _this->cpu.state.fetch_cycles += dmi->latency;
+      iss_pccr_account_event(_this, CSR_PCER_IMISS, dmi->latency);
+    }
+
+    return 0;
+  }
+
   vp::io_req *req = &_this->fetch_req;
   req->init();
   req->set_addr(addr);
   req->set_size(size);
   req->set_is_write(is_write);
   req->set_data(data);
+  _this->superblock_exit = true;
+  lib_float_host_release(&_this->cpu.state);
   vp::io_req_status_e err = _this->fetch.req(req);
   if (err != vp::IO_REQ_OK)
   {
@@ -187,6 +212,7 @@ static inline int iss_fetch_req_timed(iss_t *_this, uint64_t addr, uint8_t *data
 static inline int iss_irq_ack(iss_t *iss, int irq)
 {
   iss->decode_trace.msg("Acknowledging interrupt (irq: %d)\n", irq);
+  lib_float_host_release(&iss->cpu.state);
   iss->irq_ack_itf.sync(irq);
   return 0;
 }
@@ -205,6 +231,8 @@ static inline void iss_csr_ext_counter_set(iss_t *iss, int id, unsigned int valu
   }
   else
   {
+    iss->superblock_exit = true;
+    lib_float_host_release(&iss->cpu.state);
     iss->ext_counter[id].sync(value);
   }
 }
@@ -217,6 +245,8 @@ static inline void iss_csr_ext_counter_get(iss_t *iss, int id, unsigned int *val
   }
   else
   {
+    iss->superblock_exit = true;
+    lib_float_host_release(&iss->cpu.state);
     iss->ext_counter[id].sync_back(value);
   }
 }
@@ -48,7 +48,7 @@ static inline void trdb_record_instruction(iss_wrapper *_this, iss_insn_t *insn)
   instr.valid = true;
   instr.exception = false;
   instr.iaddr = insn->addr;
-  instr.instr = insn->opcode;
+  instr.instr = iss_insn_opcode(insn);
   instr.compressed = insn->size == 2;
   
   if (trdb_compress_trace_step(_this->trdb, &_this->trdb_packet_list, &instr))
@@ -70,30 +70,46 @@ static inline void trdb_record_instruction(iss_wrapper *_this, iss_insn_t *insn)
 #endif
 
 
-#define EXEC_INSTR_COMMON(_this, event, func) \
+// Features which are not part of the specified mask are not checked at all,
+// the mask is a constant except for the check_all handler.
+#define EXEC_INSTR_STEP(_this, func, cycles, features) \
 do { \
   \
-  _this->trace.msg("Executing instruction\n"); \
-  if (_this->pc_trace_event.get_event_active()) \
-  { \
-    _this->pc_trace_event.event((uint8_t *)&_this->cpu.current_insn->addr); \
-  } \
-  if (_this->func_trace_event.get_event_active() || _this->inline_trace_event.get_event_active() || _this->file_trace_event.get_event_active() || _this->line_trace_event.get_event_active()) \
+  if ((features) & ISS_EXEC_FEATURE_TRACE) \
   { \
-    _this->dump_debug_traces(); \
+    _this->trace.msg("Executing instruction\n"); \
+    if (_this->pc_trace_event.get_event_active()) \
+    { \
+      _this->pc_trace_event.event((uint8_t *)&_this->cpu.current_insn->addr); \
+    } \
+    if (_this->func_trace_event.get_event_active() || _this->inline_trace_event.get_event_active() || _this->file_trace_event.get_event_active() || _this->line_trace_event.get_event_active()) \
+    { \
+      _this->dump_debug_traces(); \
+    } \
   } \
-  if (_this->ipc_stat_event.get_event_active()) \
+  if (((features) & ISS_EXEC_FEATURE_IPC_STAT) && _this->ipc_stat_event.get_event_active()) \
   { \
     _this->ipc_stat_nb_insn++; \
   } \
-  if (_this->power_trace.get_active()) \
+  if (((features) & ISS_EXEC_FEATURE_POWER) && _this->power_trace.get_active()) \
   { \
-  _this->insn_power.account_event(); \
- } \
- \
+    lib_float_host_release(&_this->cpu.state); \
+    _this->insn_power.account_event(); \
+  } \
+  \
   iss_insn_t *insn = _this->cpu.current_insn; \
-  int cycles = func(_this); \
+  cycles = func(_this); \
+  /* Stalls and latencies are not modeled in functional mode */ \
+  if (vp::no_timing && cycles > 0) \
+  { \
+    cycles = 1; \
+  } \
   trdb_record_instruction(_this, insn); \
+} while(0)
+
+#define EXEC_INSTR_END(_this, cycles) \
+do { \
+  lib_float_host_release(&_this->cpu.state); \
   if (cycles >= 0) \
   { \
     _this->enqueue_next_instr(cycles); \
@@ -112,6 +128,13 @@ do { \
   } \
 } while(0)
 
+#define EXEC_INSTR_COMMON(_this, event, func) \
+do { \
+  int cycles; \
+  EXEC_INSTR_STEP(_this, func, cycles, ISS_EXEC_NB_FEATURE_MASKS - 1); \
+  EXEC_INSTR_END(_this, cycles); \
+} while(0)
+
 void iss_wrapper::dump_debug_traces()
 {
   const char *func, *inline_func, *file;
@@ -126,11 +149,136 @@ void iss_wrapper::dump_debug_traces()
   }
 }
 
+// Execute instructions by superblocks, for which the clock engine is checked
+// only once when entering the block, for its whole size, and then chain the
+// instruction handlers until the end of the block, and the blocks until one
+// cannot be entered. The clock is still moved after each instruction so that
+// the timing is the same as for the batch mode.
+// Any instruction which did not take exactly one cycle or may have changed the
+// core or platform state stops the execution and is returned in cycles, so that
+// the caller takes care of it. False is returned if no such instruction is
+// pending.
+inline bool iss_wrapper::exec_superblocks(vp::clock_event *event, int64_t *budget, int *cycles)
+{
+  vp::clock_engine *clock = this->get_clock();
+
+  while (1)
+  {
+    iss_insn_t *insn = this->cpu.current_insn;
+
+    // Instructions are first executed normally, so that they get decoded
+    if (insn->fast_handler == iss_decode_pc)
+      return false;
+
+    int size = insn->superblock_size;
+    if (unlikely(size == 0))
+      size = insn_cache_superblock(this, insn, this->superblock_size);
+
+    if (size < 2 || *budget <= size || !clock->can_skip_cycles(size))
+      return false;
+
+    this->superblock_exit = false;
+
+    for (int i=0; i<size; i++)
+    {
+      iss_insn_t *next = this->cpu.current_insn->next;
+
+      int insn_cycles = iss_exec_step_nofetch(this);
+      if (vp::no_timing && insn_cycles > 0)
+        insn_cycles = 1;
+
+      if (insn_cycles != 1 || this->superblock_exit || this->current_event != event || !this->is_active_reg.get())
+      {
+        *cycles = insn_cycles;
+        return true;
+      }
+
+      *budget -= 1;
+      clock->skip_cycles(1);
+
+      // Control flow changed without any cycle penalty, like at the end of a
+      // hardware loop, continue with the block at the target
+      if (this->cpu.current_insn != next)
+        break;
+    }
+  }
+}
+
+template<int features>
 void iss_wrapper::exec_instr(void *__this, vp::clock_event *event)
 {
   iss_t *_this = (iss_t *)__this;
+  int64_t budget = _this->batch_cycles;
+  int64_t quantum_cycles = 0;
+  int cycles;
+
+  // Execute as many instructions as possible from this event, as long as
+  // nothing else has to be executed in-between, to save the cost of going
+  // through the clock engine for each instruction.
+  if (budget > 0)
+  {
+    vp::clock_engine *clock = _this->get_clock();
+    clock->init_skip_cycles();
+
+    if (_this->quantum > 0)
+    {
+      quantum_cycles = _this->quantum / clock->get_period();
+      if (quantum_cycles > budget)
+        budget = quantum_cycles;
+    }
+  }
+
+  // Superblocks skip the per-instruction checks, they are only used when
+  // nothing has to be traced for each instruction.
+#ifdef USE_TRDB
+  bool superblocks = false;
+#else
+  bool superblocks = features == 0 && budget > 0 && _this->superblock_size > 1;
+#endif
 
-  EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch);
+  do
+  {
+    if (!superblocks || !_this->exec_superblocks(event, &budget, &cycles))
+    {
+      EXEC_INSTR_STEP(_this, iss_exec_step_nofetch, cycles, features);
+    }
+  }
+  while (cycles >= 0 && budget > 0 && _this->batch_next_instr(event, cycles, &budget, quantum_cycles));
+
+  EXEC_INSTR_END(_this, cycles);
+}
+
+static vp::clock_event_meth_t *exec_instr_meths[ISS_EXEC_NB_FEATURE_MASKS] = {
+  &iss_wrapper::exec_instr<0>, &iss_wrapper::exec_instr<1>,
+  &iss_wrapper::exec_instr<2>, &iss_wrapper::exec_instr<3>,
+  &iss_wrapper::exec_instr<4>, &iss_wrapper::exec_instr<5>,
+  &iss_wrapper::exec_instr<6>, &iss_wrapper::exec_instr<7>,
+};
+
+void iss_wrapper::update_exec_features()
+{
+  int features = 0;
+
+  if (this->trace.get_active() || this->pc_trace_event.get_event_active() ||
+    this->func_trace_event.get_event_active() || this->inline_trace_event.get_event_active() ||
+    this->file_trace_event.get_event_active() || this->line_trace_event.get_event_active())
+  {
+    features |= ISS_EXEC_FEATURE_TRACE;
+  }
+
+  if (this->ipc_stat_event.get_event_active())
+    features |= ISS_EXEC_FEATURE_IPC_STAT;
+
+  if (this->power_trace.get_active())
+    features |= ISS_EXEC_FEATURE_POWER;
+
+  vp::clock_event *previous = this->instr_event;
+  this->exec_features = features;
+  this->instr_event = this->instr_events[features];
+
+  // Otherwise the check_all handler switches to the new one when it is done
+  if (this->current_event == previous)
+    this->current_event = this->instr_event;
 }
 
 void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
@@ -156,9 +304,9 @@ void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
 
 void iss_wrapper::exec_first_instr(vp::clock_event *event)
 {
-  current_event = event_new(iss_wrapper::exec_instr);
+  current_event = instr_event;
   iss_start(this);
-  exec_instr((void *)this, event);
+  exec_instr_meths[this->exec_features]((void *)this, event);
 }
 
 void iss_wrapper::exec_first_instr(void *__this, vp::clock_event *event)
@@ -167,6 +315,24 @@ void iss_wrapper::exec_first_instr(void *__this, vp::clock_event *event)
   _this->exec_first_instr(event);
 }
 
+void iss_wrapper::exec_sync_access(void *__this, vp::clock_event *event)
+{
+  iss_t *_this = (iss_t *)__this;
+  vp::io_req *req = &_this->io_req;
+
+  // The clock domain has now reached the time at which the core did the
+  // access, send it again, this time without the decoupled flag.
+  req->prepare();
+  int err = _this->data.req(req);
+  if (err == vp::IO_REQ_OK || err == vp::IO_REQ_INVALID)
+  {
+    if (err == vp::IO_REQ_INVALID)
+      vp_warning_always(&_this->warning, "Invalid access (offset: 0x%lx, size: 0x%lx, is_write: %d)\n", req->get_addr(), req->get_size(), req->get_is_write());
+
+    data_response(_this, req);
+  }
+}
+
 void iss_wrapper::data_grant(void *__this, vp::io_req *req)
 {
 }
@@ -200,6 +366,20 @@ void iss_wrapper::fetch_response(void *_this, vp::io_req *req)
 
 }
 
+void iss_wrapper::data_dmi_inval(void *__this)
+{
+  iss_t *_this = (iss_t *)__this;
+  _this->trace.msg("Invalidating data direct access\n");
+  _this->data_dmi.init();
+}
+
+void iss_wrapper::fetch_dmi_inval(void *__this)
+{
+  iss_t *_this = (iss_t *)__this;
+  _this->trace.msg("Invalidating fetch direct access\n");
+  _this->fetch_dmi.init();
+}
+
 void iss_wrapper::bootaddr_sync(void *__this, uint32_t value)
 {
   iss_t *_this = (iss_t *)__this;
@@ -322,7 +502,10 @@ void iss_wrapper::set_halt_mode(bool halted, int cause)
     this->halted.set(halted);
 
     if (this->halt_status_itf.is_bound()) 
+    {
+      lib_float_host_release(&this->cpu.state);
       this->halt_status_itf.sync(this->halted.get());
+    }
   }
 }
 
@@ -355,6 +538,9 @@ void iss_wrapper::check_state()
 {
   vp::clock_event *event = current_event;
 
+  // This can be called from an instruction and notifies other components
+  lib_float_host_release(&this->cpu.state);
+
   current_event = check_all_event;
 
   if (!is_active_reg.get())
@@ -439,6 +625,20 @@ int iss_wrapper::data_misaligned_req(iss_addr_t addr, uint8_t *data_ptr, int siz
   misaligned_addr = addr1;
   misaligned_is_write = is_write;
 
+  // A core running ahead of its clock domain would have to synchronize in the
+  // middle of the access, so let the clock domain catch up first, and do both
+  // accesses from the misaligned event.
+  if (this->local_cycles)
+  {
+    trace.msg("Synchronizing before misaligned access (local_cycles: %ld)\n", this->local_cycles);
+    misaligned_first_size = size0;
+    misaligned_first_data = data_ptr;
+    misaligned_first_addr = addr;
+    misaligned_latency = this->local_cycles;
+    this->local_cycles = 0;
+    return vp::IO_REQ_PENDING;
+  }
+
   // And do the first one now
   int err = data_req_aligned(addr, data_ptr, size0, is_write);
   if (err == vp::IO_REQ_OK)
@@ -496,6 +696,7 @@ bool iss_wrapper::user_access(iss_addr_t addr, uint8_t *buffer, iss_addr_t size,
   req->set_size(size);
   req->set_is_write(is_write);
   req->set_data(buffer);
+  lib_float_host_release(&this->cpu.state);
   int err = data.req(req);
   if (err != vp::IO_REQ_OK) 
   {
@@ -522,6 +723,7 @@ std::string iss_wrapper::read_user_string(iss_addr_t addr, int size)
     req->set_size(1);
     req->set_is_write(false);
     req->set_data(&buffer);
+    lib_float_host_release(&this->cpu.state);
     int err = data.req(req);
     if (err != vp::IO_REQ_OK) 
     {
@@ -955,10 +1157,12 @@ int iss_wrapper::build()
 
   data.set_resp_meth(&iss_wrapper::data_response);
   data.set_grant_meth(&iss_wrapper::data_grant);
+  data.set_dmi_inval_meth(&iss_wrapper::data_dmi_inval);
   new_master_port("data", &data);
 
   fetch.set_resp_meth(&iss_wrapper::fetch_response);
   fetch.set_grant_meth(&iss_wrapper::fetch_grant);
+  fetch.set_dmi_inval_meth(&iss_wrapper::fetch_dmi_inval);
   new_master_port("fetch", &fetch);
 
   dbg_unit.set_req_meth(&iss_wrapper::dbg_unit_req);
@@ -988,9 +1192,25 @@ int iss_wrapper::build()
   }
 
   current_event = event_new(iss_wrapper::exec_first_instr);
-  instr_event = event_new(iss_wrapper::exec_instr);
+  for (int i=0; i<ISS_EXEC_NB_FEATURE_MASKS; i++)
+  {
+    instr_events[i] = event_new(exec_instr_meths[i]);
+  }
+  instr_event = instr_events[0];
   check_all_event = event_new(iss_wrapper::exec_instr_check_all);
   misaligned_event = event_new(iss_wrapper::exec_misaligned);
+  sync_access_event = event_new(iss_wrapper::exec_sync_access);
+
+  // Maximum number of cycles executed from a single instruction event,
+  // 0 executes one instruction per event
+  js::config *batch_conf = this->get_js_config()->get("batch_cycles");
+  this->batch_cycles = batch_conf ? batch_conf->get_int() : 64;
+
+  // Maximum number of instructions of a superblock, 0 or 1 disables them
+  js::config *superblock_conf = this->get_js_config()->get("superblock_size");
+  this->superblock_size = superblock_conf ? superblock_conf->get_int() : 32;
+  if (this->superblock_size > INT16_MAX)
+    this->superblock_size = INT16_MAX;
 
   this->riscv_dbg_unit = this->get_js_config()->get_child_bool("riscv_dbg_unit");
   this->bootaddr_offset = get_config_int("bootaddr_offset");
@@ -1002,6 +1222,16 @@ int iss_wrapper::build()
 
   ipc_clock_event = this->event_new(iss_wrapper::ipc_stat_handler);
 
+  // Traces can be enabled after this point, re-select the instruction handler
+  // each time one of them changes
+  vp::trace *exec_traces[] = { &trace, &pc_trace_event, &func_trace_event, &inline_trace_event,
+    &file_trace_event, &line_trace_event, &ipc_stat_event, &power_trace.trace };
+  for (vp::trace *exec_trace: exec_traces)
+  {
+    exec_trace->set_active_callback([this]() { this->update_exec_features(); });
+  }
+  this->update_exec_features();
+
   return 0;
 }
 
@@ -1018,6 +1248,11 @@ void iss_wrapper::start()
 
   if (iss_open(this)) throw logic_error("Error while instantiating the ISS");
 
+  // Maximum time in ps the core can run ahead of its clock domain,
+  // 0 disables temporal decoupling
+  js::config *quantum_conf = this->get_time_engine()->get_js_config()->get("**/gvsoc/quantum");
+  this->quantum = quantum_conf ? quantum_conf->get_int() : 0;
+
   for (auto x:this->get_js_config()->get("**/debug_binaries")->get_elems())
   {
     iss_register_debug_info(this, x->get_str().c_str());
@@ -19,15 +19,10 @@
  */
 
 #include <vp/vp.hpp>
+#include <vp/mem_backing.hpp>
 #include <stdio.h>
 #include <string.h>
 
-#include <sys/mman.h>
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-
 #include "vp/itf/hyper.hpp"
 #include "vp/itf/wire.hpp"
 #include "archi/utils.h"
@@ -89,8 +84,8 @@ protected:
   vp::wire_slave<bool> cs_itf;
 
   int size;
+  vp::mem_backing backing;
   uint8_t *data;
-  bool data_is_mmapped;
   uint8_t *reg_data;
 
   hyperflash_state_e state;
@@ -134,6 +129,7 @@ void Hyperflash::erase_sector(unsigned int addr)
     return;
   }
 
+  this->backing.populate(addr, FLASH_SECTOR_SIZE);
   memset(&this->data[addr], 0xff, FLASH_SECTOR_SIZE);
 }
 
@@ -171,6 +167,7 @@ void Hyperflash::handle_access(int reg_access, int address, int read, uint8_t da
       }
       else
       {
+        this->backing.populate(address, 1);
         data = this->data[address];
       }
       this->trace.msg(vp::trace::LEVEL_TRACE, "Sending data byte (value: 0x%x)\n", data);
@@ -182,6 +179,7 @@ void Hyperflash::handle_access(int reg_access, int address, int read, uint8_t da
       {
         this->trace.msg(vp::trace::LEVEL_TRACE, "Writing to flash (address: 0x%x, value: 0x%x)\n", address, data);
 
+        this->backing.populate(address, 1);
         if (this->data[address] != 0xff)
         {
           this->warning.force_warning("Trying to program flash without erasing sector (addr: 0x%x)\n", address);
@@ -278,56 +276,38 @@ void Hyperflash::handle_access(int reg_access, int address, int read, uint8_t da
 int Hyperflash::preload_file(char *path)
 {
   this->get_trace()->msg(vp::trace::LEVEL_INFO, "Preloading memory with stimuli file (path: %s)\n", path);
-  FILE *file = fopen(path, "r");
-  if (file == NULL) {
-    printf("Unable to open stimulus file (path: %s, error: %s)\n", path, strerror(errno));
-    return -1;
-  }
 
-  if (fread(this->data, 1, this->size, file) == 0)
+  // The file is mapped copy-on-write, so that only the parts which are
+  // accessed are read
+  if (this->backing.preload_file(path))
+  {
+    printf("Unable to preload stimulus file (path: %s, error: %s)\n", path, strerror(errno));
     return -1;
+  }
 
   return 0;
 }
 
 /*
- * Bback the data memory to a mmap file to provide access to the hyperflash content
+ * Back the data memory to a mmap file to provide access to the hyperflash content
  * at the end of the execution.
  */
 int Hyperflash::setup_writeback_file(const char *path)
 {
   this->get_trace()->msg("writeback memory to an output file (path: %s)\n", path);
-  int fd = open(path, O_RDWR | O_CREAT, 0600);
-  if (fd < 0) {
-	  printf("Unable to open writeback file (path: %s, error: %s)\n", path, strerror(errno));
-	  return 0;
-  }
-
-  if (ftruncate(fd, this->size) < 0) {
-	  printf("Unable to truncate writeback file (path: %s, error: %s)\n", path, strerror(errno));
-	  close(fd);
-	  return -1;
-  }
-  uint8_t *mmapped_data = (uint8_t *) mmap(NULL, this->size, PROT_READ | PROT_WRITE, MAP_SHARED , fd, 0);
-  if (!mmapped_data) {
-	  printf("Unable to mmap writeback file (path: %s, error: %s)\n", path, strerror(errno));
-	  close(fd);
-	  return -1;
-  }
-
-  /* copy the current data content into the mmap area and replace data pointer with the mmap pointer */
-  memcpy(mmapped_data, this->data, this->size);
-  free(this->data);
-  this->data = mmapped_data;
-  this->data_is_mmapped = true;
 
   /*
-   * fd is even not useful anymore and can be closed.
-   * Data are automatically write back to the file
+   * Data are automatically written back to the file
    * at random time during execution (depending of the kernel cache behavior)
    * and, anyway, at the termination of the application.
    */
-  close(fd);
+  if (this->backing.setup_writeback_file(path))
+  {
+    printf("Unable to setup writeback file (path: %s, error: %s)\n", path, strerror(errno));
+    return -1;
+  }
+
+  this->data = this->backing.get_data();
   return 0;
 }
 
@@ -408,9 +388,14 @@ int Hyperflash::build()
 
   this->size = conf->get("size")->get_int();
 
-  this->data = new uint8_t[this->size];
-  memset(this->data, 0x57, this->size);
-  this->data_is_mmapped = false;
+  // Large flashes are only populated when they are touched
+  if (this->backing.init(this->size, 0x57, false, vp::mem_backing::get_huge_pages(conf),
+    vp::mem_backing::get_chunk_size(conf)))
+  {
+    this->trace.fatal("Failed to allocate flash (size: 0x%x)\n", this->size);
+    return -1;
+  }
+  this->data = this->backing.get_data();
 
   this->reg_data = new uint8_t[REGS_AREA_SIZE];
   memset(this->reg_data, 0x57, REGS_AREA_SIZE);
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <vp/itf/qspim.hpp>
+#include <vp/mem_backing.hpp>
 
 #define CMD_READ_ID       0x9f
 #define CMD_RDCR          0x35
@@ -127,6 +128,7 @@ private:
   int size;
 
   command_t *commands[256];
+  vp::mem_backing backing;
   uint8_t *mem_data;
   unsigned int pending_word;
   unsigned int pending_addr;
@@ -195,6 +197,7 @@ void spiflash::page_program(void *__this, int data_0, int data_1, int data_2, in
 
       _this->trace.msg("Writing byte (address: 0x%x, value: 0x%x)\n", _this->current_addr, (uint8_t)_this->pending_word);
 
+      _this->backing.populate(_this->current_addr, 1);
       _this->mem_data[_this->current_addr++] = _this->pending_word;
     }
   }
@@ -276,6 +279,7 @@ void spiflash::quad_read(void *__this, int data_0, int data_1, int data_2, int d
         return;
       }
 
+      _this->backing.populate(_this->current_addr, 1);
       _this->pending_word = _this->mem_data[_this->current_addr++];
     }
   }
@@ -306,6 +310,7 @@ void spiflash::single_read(void *__this, int data_0, int data_1, int data_2, int
         return;
       }
 
+      _this->backing.populate(_this->current_addr, 1);
       _this->pending_word = _this->mem_data[_this->current_addr++];
     }
   }
@@ -470,9 +475,14 @@ int spiflash::build()
 
   this->size = this->get_config_int("size");
 
-  this->mem_data = new uint8_t[this->size];
-
-  memset(this->mem_data, 0x57, this->size);
+  // Large flashes are only populated when they are touched
+  if (this->backing.init(this->size, 0x57, false, vp::mem_backing::get_huge_pages(this->get_js_config()),
+    vp::mem_backing::get_chunk_size(this->get_js_config())))
+  {
+    this->trace.fatal("Failed to allocate flash (size: 0x%x)\n", this->size);
+    return -1;
+  }
+  this->mem_data = this->backing.get_data();
 
   this->cr1.raw = 0;
   this->quad = false;
@@ -496,13 +506,7 @@ void spiflash::start()
     string path = stim_file_conf->get_str();
     this->get_trace()->msg("Preloading memory with stimuli file (path: %s)\n", path.c_str());
 
-    FILE *file = fopen(path.c_str(), "rb");
-    if (file == NULL)
-    {
-      this->get_trace()->fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
-      return;
-    }
-    if (fread(this->mem_data, 1, size, file) == 0)
+    if (this->backing.preload_file(path.c_str()))
     {
       this->get_trace()->fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
       return;
@@ -531,7 +535,11 @@ void spiflash::start()
         this->get_trace()->fatal("Incorrect stimuli file (path: %s)\n", path.c_str());
         return;
       }
-      if (addr < size) this->mem_data[addr] = value;
+      if (addr < size)
+      {
+        this->backing.populate(addr, 1);
+        this->mem_data[addr] = value;
+      }
     }
   }
 }
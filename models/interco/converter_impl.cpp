@@ -40,11 +40,15 @@ private:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi);
+
 
   static void grant(void *_this, vp::io_req *req);
 
   static void response(void *_this, vp::io_req *req);
 
+  static void dmi_inval(void *_this);
+
   static void event_handler(void *__this, vp::clock_event *event);
 
   vp::io_req_status_e process_req(vp::io_req *req);
@@ -140,6 +144,11 @@ vp::io_req_status_e converter::process_pending_req(vp::io_req *req)
 
   int mask = output_align - 1;
 
+  // Direct accesses would bypass the stalling of the requests arriving while
+  // this one is being split
+  if (ongoing_req == NULL)
+    in.dmi_invalidate();
+
   ongoing_req = req;
   ongoing_size = size;
 
@@ -213,6 +222,30 @@ vp::io_req_status_e converter::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_PENDING;
 }
 
+bool converter::dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi)
+{
+  converter *_this = (converter *)__this;
+
+  if (_this->ongoing_req)
+  {
+    uint64_t chunk_base = addr & ~((uint64_t)_this->output_align - 1);
+    dmi->deny(chunk_base, _this->output_align);
+    return false;
+  }
+
+  // Direct accesses are only equivalent to requests which are not split
+  bool granted = _this->out.dmi_req(addr, dmi);
+  dmi->set_align(_this->output_align);
+
+  return granted;
+}
+
+void converter::dmi_inval(void *__this)
+{
+  converter *_this = (converter *)__this;
+  _this->in.dmi_invalidate();
+}
+
 void converter::grant(void *_this, vp::io_req *req)
 {
 }
@@ -226,10 +259,12 @@ int converter::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&converter::req);
+  in.set_dmi_meth(&converter::dmi_req);
   new_slave_port("input", &in);
 
   out.set_resp_meth(&converter::response);
   out.set_grant_meth(&converter::grant);
+  out.set_dmi_inval_meth(&converter::dmi_inval);
   new_master_port("out", &out);
 
   output_width = get_config_int("output_width");
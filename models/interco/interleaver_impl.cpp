@@ -23,6 +23,10 @@
 #include <stdio.h>
 #include <math.h>
 
+// Interleaved memory is only contiguous on the host inside a stripe, so direct
+// accesses are only forwarded when stripes are large enough to be worth it.
+#define INTERLEAVER_DMI_MIN_STRIPE_BITS 12
+
 class interleaver : public vp::component
 {
 
@@ -34,11 +38,15 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi);
+
 
   static void grant(void *_this, vp::io_req *req);
 
   static void response(void *_this, vp::io_req *req);
 
+  static void dmi_inval(void *_this);
+
 private:
   vp::trace     trace;
 
@@ -116,6 +124,46 @@ vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_OK;
 }
 
+bool interleaver::dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  if (_this->interleaving_bits < INTERLEAVER_DMI_MIN_STRIPE_BITS)
+  {
+    dmi->deny(0, -1);
+    return false;
+  }
+
+  uint64_t offset = addr - _this->remove_offset;
+  int output_id = (offset >> _this->interleaving_bits) & ((1 << _this->stage_bits) - 1);
+  uint64_t new_offset = ((offset & _this->offset_mask) >> _this->stage_bits) + (offset & ((1<<_this->interleaving_bits)-1));
+
+  if (!_this->out[output_id])
+  {
+    dmi->deny(0, -1);
+    return false;
+  }
+
+  bool granted = _this->out[output_id]->dmi_req(new_offset, dmi);
+
+  uint64_t stripe_size = 1ULL << _this->interleaving_bits;
+  dmi->translate(new_offset, addr);
+  dmi->restrict(addr & ~(stripe_size - 1), stripe_size);
+
+  return granted;
+}
+
+void interleaver::dmi_inval(void *__this)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  _this->in.dmi_invalidate();
+  for (int i=0; i<_this->nb_masters; i++)
+  {
+    _this->masters_in[i]->dmi_invalidate();
+  }
+}
+
 void interleaver::grant(void *_this, vp::io_req *req)
 {
 
@@ -130,6 +178,7 @@ int interleaver::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&interleaver::req);
+  in.set_dmi_meth(&interleaver::dmi_req);
   new_slave_port("input", &in);
 
   nb_slaves = get_config_int("nb_slaves");
@@ -147,6 +196,7 @@ int interleaver::build()
     out[i] = new vp::io_master();
     out[i]->set_resp_meth(&interleaver::response);
     out[i]->set_grant_meth(&interleaver::grant);
+    out[i]->set_dmi_inval_meth(&interleaver::dmi_inval);
     new_master_port("out_" + std::to_string(i), out[i]);
   }
 
@@ -155,6 +205,7 @@ int interleaver::build()
   {
     masters_in[i] = new vp::io_slave();
     masters_in[i]->set_req_meth(&interleaver::req);
+    masters_in[i]->set_dmi_meth(&interleaver::dmi_req);
     new_slave_port("in_" + std::to_string(i), masters_in[i]);
   }
   return 0;
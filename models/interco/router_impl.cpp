@@ -23,6 +23,8 @@
 #include <vp/itf/wire.hpp>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
+#include <algorithm>
 
 class router;
 
@@ -54,7 +56,6 @@ public:
 class MapEntry {
 public:
   MapEntry() {}
-  MapEntry(unsigned long long base, MapEntry *left, MapEntry *right);
 
   void insert(router *router);
 
@@ -62,16 +63,19 @@ public:
   MapEntry *next = NULL;
   int id = -1;
   unsigned long long base = 0;
-  unsigned long long lowestBase = 0;
   unsigned long long size = 0;
   unsigned long long remove_offset = 0;
   unsigned long long add_offset = 0;
   uint32_t latency = 0;
+  // Bandwidth in bytes per cycle of the path to the target, 0 if not modeled.
+  // Mappings without bandwidth keep the fixed latency and can be accessed
+  // through DMI.
+  int bandwidth = 0;
+  // Cycle at which the path to the target is free again
   int64_t nextPacketTime = 0;
-  MapEntry *left = NULL;
-  MapEntry *right = NULL;
   vp::io_slave *port = NULL;
   vp::io_master *itf = NULL;
+  Perf_counter *counter = NULL;
 };
 
 class io_master_map : public vp::io_master
@@ -91,17 +95,28 @@ public:
   router(const char *config);
 
   int build();
+  void start();
+  void stop();
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi);
+
 
   static void grant(void *_this, vp::io_req *req);
 
   static void response(void *_this, vp::io_req *req);
 
+  static void dmi_inval(void *_this);
+
 private:
   vp::trace     trace;
 
+  inline MapEntry *get_entry(uint64_t offset, uint64_t size);
+  inline void account_bandwidth(MapEntry *entry, vp::io_req *req);
+  MapEntry *lookup_entry(uint64_t offset, uint64_t size);
+  void get_default_area(uint64_t offset, uint64_t *base, uint64_t *size);
+
   io_master_map out;
   vp::io_slave in;
   bool init = false;
@@ -110,13 +125,30 @@ private:
   MapEntry *firstMapEntry = NULL;
   MapEntry *defaultMapEntry = NULL;
   MapEntry *errorMapEntry = NULL;
-  MapEntry *topMapEntry = NULL;
   MapEntry *externalBindingMapEntry = NULL;
 
+  // Routing table, sorted by base address. Bases are kept apart so that the
+  // binary search only touches them.
+  std::vector<uint64_t> entries_base;
+  std::vector<MapEntry *> entries;
+
+  // Area and entry of the last lookup, most accesses hit the same target than
+  // the previous one. The area is empty until the first lookup.
+  uint64_t last_base = 1;
+  uint64_t last_end = 0;
+  MapEntry *last_entry = NULL;
+  int64_t nb_hits = 0;
+  int64_t nb_misses = 0;
+
   std::map<int, Perf_counter *> counters;
 
+  // Bandwidth of the input port, only modeled for the requests going to
+  // mappings which have their own bandwidth
   int bandwidth = 0;
   int latency = 0;
+
+  // Cycle at which the input port is free again
+  int64_t input_next_packet_time = 0;
 };
 
 router::router(const char *config)
@@ -125,13 +157,8 @@ router::router(const char *config)
 
 }
 
-MapEntry::MapEntry(unsigned long long base, MapEntry *left, MapEntry *right) : next(NULL), base(base), lowestBase(left->lowestBase), left(left), right(right) {
-}
-
 void MapEntry::insert(router *router)
 {
-  lowestBase = base;
-
   if (size != 0) {
     if (port != NULL || itf != NULL) {    
       MapEntry *current = router->firstMapEntry;
@@ -157,42 +184,121 @@ void MapEntry::insert(router *router)
   }
 }
 
-vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+inline MapEntry *router::get_entry(uint64_t offset, uint64_t size)
 {
-  router *_this = (router *)__this;
-  
-  if (!_this->init)
+  if (offset >= this->last_base && offset <= this->last_end)
   {
-    _this->init = true;
-    _this->init_entries();
+    this->nb_hits++;
+    return this->last_entry;
   }
 
-  MapEntry *entry = _this->topMapEntry;
-  uint64_t offset = req->get_addr();
-  bool isRead = !req->get_is_write();
-  uint64_t size = req->get_size();  
-
-  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+  this->nb_misses++;
+  return this->lookup_entry(offset, size);
+}
 
-  if (entry)
+MapEntry *router::lookup_entry(uint64_t offset, uint64_t size)
+{
+  // Only needed if an access is done before the router is started
+  if (unlikely(!this->init))
   {
-    while(1) {
-    // The entry does not have any child, this means we are at a final entry
-      if (entry->left == NULL) break;
+    this->init_entries();
+  }
 
-      if (offset >= entry->base) entry = entry->right;
-      else entry = entry->left;
-    }
+  MapEntry *entry = NULL;
 
-    if (entry && (offset < entry->base || offset > entry->base + entry->size - 1)) {
-      entry = NULL;
+  // Last entry whose base is lower or equal to the offset
+  auto it = std::upper_bound(this->entries_base.begin(), this->entries_base.end(), offset);
+  if (it != this->entries_base.begin())
+  {
+    MapEntry *candidate = this->entries[it - this->entries_base.begin() - 1];
+    if (offset <= candidate->base + candidate->size - 1)
+    {
+      entry = candidate;
+      this->last_base = entry->base;
+      this->last_end = entry->base + entry->size - 1;
+      this->last_entry = entry;
     }
   }
 
   if (!entry) {
-    if (_this->errorMapEntry && offset >= _this->errorMapEntry->base && offset + size - 1 <= _this->errorMapEntry->base + _this->errorMapEntry->size - 1) {
+    if (this->errorMapEntry && offset >= this->errorMapEntry->base && offset + size - 1 <= this->errorMapEntry->base + this->errorMapEntry->size - 1) {
     } else {
-      entry = _this->defaultMapEntry;
+      entry = this->defaultMapEntry;
+
+      // An access starting inside the error area can also go to the default
+      // entry if it goes beyond it, this is not cached as the area is
+      // ambiguous. Otherwise the default area does not include the error one,
+      // so any access starting inside it is routed to the default entry.
+      bool in_error = this->errorMapEntry && offset >= this->errorMapEntry->base && offset <= this->errorMapEntry->base + this->errorMapEntry->size - 1;
+      if (entry && !in_error)
+      {
+        uint64_t base, size;
+        this->get_default_area(offset, &base, &size);
+        this->last_base = base;
+        this->last_end = base + size - 1;
+        this->last_entry = entry;
+      }
+    }
+  }
+
+  return entry;
+}
+
+// Bandwidth and contention are modeled analytically, without any event. The
+// input port and the path to each target are resources which are busy for the
+// size of the packet divided by their bandwidth. A packet which finds one of
+// them still busy with a previous packet is delayed until it is free.
+inline void router::account_bandwidth(MapEntry *entry, vp::io_req *req)
+{
+  uint64_t size = req->get_size();
+
+  // Cycle at which the packet reaches the router, including the latency of
+  // the components on the path
+  int64_t arrival = this->get_cycles() + req->get_latency();
+
+  int64_t input_start = arrival;
+  int64_t input_duration = 0;
+  if (this->bandwidth != 0)
+  {
+    input_duration = (size + this->bandwidth - 1) / this->bandwidth;
+    input_start = std::max(arrival, this->input_next_packet_time);
+    this->input_next_packet_time = input_start + input_duration;
+  }
+
+  int64_t output_duration = (size + entry->bandwidth - 1) / entry->bandwidth;
+  int64_t output_start = std::max(input_start, entry->nextPacketTime);
+  entry->nextPacketTime = output_start + output_duration;
+
+  if (output_start > arrival)
+  {
+    this->trace.msg("Delaying packet (target: %s, stall_cycles: %ld)\n", entry->target_name.c_str(), output_start - arrival);
+  }
+
+  // Don't forget to compare to the already computed duration, as there might
+  // be a slower router on the path, this is done by set_duration
+  req->set_duration(std::max(input_duration, output_duration));
+  req->inc_latency(output_start - arrival + entry->latency + this->latency);
+}
+
+vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+{
+  router *_this = (router *)__this;
+
+  uint64_t offset = req->get_addr();
+  bool isRead = !req->get_is_write();
+  uint64_t size = req->get_size();  
+
+  MapEntry *entry = _this->get_entry(offset, size);
+
+  if (unlikely(_this->trace.get_active()))
+  {
+    _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+
+    if (entry == NULL) {
+    } else if (entry == _this->defaultMapEntry) {
+      _this->trace.msg("Routing to default entry (target: %s)\n", entry->target_name.c_str());
+    } else {
+      _this->trace.msg("Routing to entry (target: %s)\n", entry->target_name.c_str());
     }
   }
 
@@ -200,39 +306,18 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
     //_this->trace.msg(&warning, "Invalid access (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
     return vp::IO_REQ_INVALID;
   }
+  
+  // Keep the state of the bandwidth model, in case the request is given back
+  // for synchronization, since it will be sent again
+  int64_t input_next_packet_time = _this->input_next_packet_time;
+  int64_t next_packet_time = entry->nextPacketTime;
 
-  if (entry == _this->defaultMapEntry) {
-    _this->trace.msg("Routing to default entry (target: %s)\n", entry->target_name.c_str());
-  } else {
-    _this->trace.msg("Routing to entry (target: %s)\n", entry->target_name.c_str());
+  if (entry->bandwidth != 0 && !vp::no_timing && !req->is_debug())
+  {
+    _this->account_bandwidth(entry, req);
   }
-  
-  if (0) { //_this->bandwidth != 0 and !req->is_debug()) {
-    
-#if 0
-  // Compute the duration from the specified bandwidth
-  // Don't forget to compare to the already computed duration, as there might be a slower router
-  // on the path
-    req->set_duration((float)size / _this->bandwidth);
-
-    // This is the time when the router is available
-    int64_t routerTime = max(getCycles(), entry->nextPacketTime);
-
-    // This is the time when the packet is available for the next module
-    // It is either delayed by the router in case of bandwidth overflow, and in this case
-    // we only apply the router latency, or it is delayed by the latency of the components 
-    // on the path plus the router latency.
-    // Just select the maximum
-    int64_t packetTime = max(routerTime + entry->latency, getCycles() + req->getLatency() + entry->latency);
-
-    // Compute the latency to be reported from the estimated packet time at the output
-    req->setLatency(packetTime - getCycles());
-
-    // Update the bandwidth information
-    entry->nextPacketTime = routerTime + req->getLength();
-
-#endif
-  } else {
+  else
+  {
     req->inc_latency(entry->latency + _this->latency);
   }
 
@@ -260,14 +345,22 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
       req->arg_pop();
   }
 
-  if (entry->id != -1) 
+  // The request did not reach the target, it will be sent again once the
+  // master has synchronized, so it must not be accounted twice
+  if (unlikely(req->is_sync_required()))
+  {
+    _this->input_next_packet_time = input_next_packet_time;
+    entry->nextPacketTime = next_packet_time;
+    return result;
+  }
+
+  Perf_counter *counter = entry->counter;
+  if (counter) 
   {
     int64_t latency = req->get_latency();
     int64_t duration = req->get_duration();
     if (duration > 1) latency += duration - 1;
 
-    Perf_counter *counter = _this->counters[entry->id];
-
     if (isRead)
       counter->read_stalls += latency;
     else
@@ -283,6 +376,84 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
   return result;
 }
 
+// Get the area around the specified offset which is routed to the default entry
+void router::get_default_area(uint64_t offset, uint64_t *base, uint64_t *size)
+{
+  uint64_t first = 0;
+  uint64_t last = -1;
+
+  for (MapEntry *current = this->firstMapEntry; current; current = current->next)
+  {
+    if (current->base > offset)
+    {
+      last = current->base - 1;
+      break;
+    }
+    first = current->base + current->size;
+  }
+
+  if (this->errorMapEntry)
+  {
+    uint64_t error_last = this->errorMapEntry->base + this->errorMapEntry->size - 1;
+    if (offset < this->errorMapEntry->base && this->errorMapEntry->base - 1 < last)
+      last = this->errorMapEntry->base - 1;
+    else if (offset > error_last && error_last + 1 > first)
+      first = error_last + 1;
+  }
+
+  *base = first;
+  *size = last - first + 1;
+}
+
+bool router::dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi)
+{
+  router *_this = (router *)__this;
+
+  MapEntry *entry = _this->lookup_entry(addr, 1);
+
+  if (!entry)
+  {
+    dmi->deny(addr, 1);
+    return false;
+  }
+
+  // The answer from the target is only valid inside the area of the entry
+  uint64_t base = entry->base, size = entry->size;
+  if (entry == _this->defaultMapEntry)
+    _this->get_default_area(addr, &base, &size);
+
+  // Accesses must go through normal requests when they are accounted into
+  // performance counters or into the bandwidth model
+  if (entry->id != -1 || entry->bandwidth != 0 || !entry->itf || !entry->itf->is_bound())
+  {
+    dmi->deny(base, size);
+    return false;
+  }
+
+  uint64_t slave_addr = addr;
+  if (entry->remove_offset) slave_addr = addr - entry->remove_offset;
+  if (entry->add_offset) slave_addr = addr + entry->add_offset;
+
+  bool granted = entry->itf->dmi_req(slave_addr, dmi);
+
+  dmi->translate(slave_addr, addr);
+  dmi->restrict(base, size);
+
+  if (granted)
+  {
+    _this->trace.msg("Granted direct access (base: 0x%llx, size: 0x%llx, target: %s)\n", dmi->base, dmi->size, entry->target_name.c_str());
+    dmi->inc_latency(entry->latency + _this->latency);
+  }
+
+  return granted;
+}
+
+void router::dmi_inval(void *__this)
+{
+  router *_this = (router *)__this;
+  _this->in.dmi_invalidate();
+}
+
 void router::grant(void *__this, vp::io_req *req)
 {
   router *_this = (router *)__this;
@@ -308,10 +479,12 @@ int router::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&router::req);
+  in.set_dmi_meth(&router::dmi_req);
   new_slave_port("input", &in);
 
   out.set_resp_meth(&router::response);
   out.set_grant_meth(&router::grant);
+  out.set_dmi_inval_meth(&router::dmi_inval);
   new_master_port("out", &out);
 
   bandwidth = get_config_int("bandwidth");
@@ -332,6 +505,7 @@ int router::build()
 
       itf->set_resp_meth(&router::response);
       itf->set_grant_meth(&router::grant);
+      itf->set_dmi_inval_meth(&router::dmi_inval);
       new_master_port(mapping.first, itf);
 
       if (mapping.first == "error")
@@ -350,6 +524,8 @@ int router::build()
       if (conf) entry->add_offset = conf->get_int();
       conf = config->get("latency");
       if (conf) entry->latency = conf->get_int();
+      conf = config->get("bandwidth");
+      if (conf) entry->bandwidth = conf->get_int();
       conf = config->get("id");
       if (conf) entry->id = conf->get_int();
 
@@ -379,12 +555,28 @@ int router::build()
         new_slave_port((void *)counter, "stalls[" + std::to_string(entry->id) + "]", &counter->stalls_itf);
       }  
 
+      if (entry->id != -1)
+        entry->counter = this->counters[entry->id];
+
       entry->insert(this);
     }
   }
   return 0;
 }
 
+void router::start()
+{
+  if (!this->init)
+  {
+    this->init_entries();
+  }
+}
+
+void router::stop()
+{
+  this->trace.msg("Routing cache statistics (hits: %ld, misses: %ld)\n", this->nb_hits, this->nb_misses);
+}
+
 extern "C" void *vp_constructor(const char *config)
 {
   return (void *)new router(config);
@@ -410,52 +602,19 @@ void router::init_entries() {
     trace.msg("       -     :      -     -> %s\n", defaultMapEntry->target_name.c_str());
   }
 
-  MapEntry *firstInLevel = firstMapEntry;
-
-  // Loop until we merged everything into a single entry
-  // Start with the routing table entries
-  current = firstMapEntry;
-
-  // The first loop is here to loop until we have merged everything to a single entry
-  while(1) {
-
-    // Gives the map entry that should be on the left side of the next created entry
-    MapEntry *left = NULL;
+  this->entries_base.clear();
+  this->entries.clear();
 
-    // Gives the last allocated entry where the entry should be inserted
-    MapEntry *currentInLevel=NULL;
-
-    // The second loop is iterating on a single level to merge entries 2 by 2
-    while(current) {
-      if (left == NULL) left = current;
-      else {
-
-        MapEntry *entry = new MapEntry(current->lowestBase, left, current);
-
-        left = NULL;
-        if (currentInLevel) {
-          currentInLevel->next = entry;
-        } else {
-          firstInLevel = entry;
-        }
-        currentInLevel = entry;
-      }
-
-      current = current->next;
-    }
-
-    current = firstInLevel;
-
-    // Stop in case we got a single entry
-    if (currentInLevel == NULL) break;
-
-    // In case an entry is alone, insert it at the end, it will be merged with an upper entry
-    if (left != NULL) {
-      currentInLevel->next = left;
-    }
+  for (current = firstMapEntry; current; current = current->next)
+  {
+    this->entries_base.push_back(current->base);
+    this->entries.push_back(current);
   }
 
-  topMapEntry = firstInLevel;
+  this->last_base = 1;
+  this->last_end = 0;
+  this->last_entry = NULL;
+  this->init = true;
 }
 
 inline void io_master_map::bind_to(vp::port *_port, vp::config *config)
@@ -475,6 +634,8 @@ inline void io_master_map::bind_to(vp::port *_port, vp::config *config)
     if (conf) entry->add_offset = conf->get_int();
     conf = config->get("latency");
     if (conf) entry->latency = conf->get_int();
+    conf = config->get("bandwidth");
+    if (conf) entry->bandwidth = conf->get_int();
   }
   entry->insert((router *)get_comp());
 }
@@ -20,6 +20,7 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vp/mem_backing.hpp>
 #include <stdio.h>
 #include <string.h>
 
@@ -36,6 +37,8 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi);
+
 private:
 
   static void power_callback(void *__this, vp::clock_event *event);
@@ -47,8 +50,8 @@ private:
   bool check = false;
   int width_bits = 0;
 
+  vp::mem_backing backing;
   uint8_t *mem_data;
-  uint8_t *check_mem;
 
   int64_t next_packet_start;
 
@@ -157,22 +160,19 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 #endif
 
 
+  _this->backing.populate(offset, size);
+
   if (req->get_is_write()) {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        _this->check_mem[(offset + i) / 8] |= 1 << ((offset + i) % 8);
-      }
+    if (_this->check) {
+      _this->backing.check_set(offset, size);
     }
     if (data)
       memcpy((void *)&_this->mem_data[offset], (void *)data, size);
   } else {
-    if (_this->check_mem) {
-      for (unsigned int i=0; i<size; i++) {
-        int access = (_this->check_mem[(offset + i) / 8] >> ((offset + i) % 8)) & 1;
-        if (!access) {
-          //trace.msg("Unitialized access (offset: 0x%x, size: 0x%x, isRead: %d)\n", offset, size, isRead);
-          return vp::IO_REQ_INVALID;
-        }
+    if (_this->check) {
+      if (!_this->backing.check_is_set(offset, size)) {
+        //trace.msg("Unitialized access (offset: 0x%x, size: 0x%x, isRead: %d)\n", offset, size, isRead);
+        return vp::IO_REQ_INVALID;
       }
     }
     if (data)
@@ -182,11 +182,41 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_OK;
 }
 
+bool memory::dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi)
+{
+  memory *_this = (memory *)__this;
+
+  // Direct accesses are only possible when the accesses do not have any other
+  // effect than reading or writing the memory, otherwise they must go through
+  // the normal requests.
+  if (_this->width_bits != 0 || _this->check || _this->power_trigger ||
+    _this->power_trace.get_active() || _this->trace.get_active() || addr >= _this->size)
+  {
+    dmi->deny(0, -1);
+    return false;
+  }
+
+  // Large memories are populated lazily, only the populated part can be
+  // accessed directly
+  uint64_t base, size;
+  _this->backing.populate_area(addr, &base, &size);
+
+  _this->trace.msg("Granting direct access (offset: 0x%x, size: 0x%x)\n", base, size);
+
+  dmi->grant(base, size, _this->mem_data + base);
+
+  return true;
+}
+
 void memory::reset(bool active)
 {
   if (active)
   {
     this->next_packet_start = 0;
+
+    // Masters may have cached accesses which are not valid anymore in case the
+    // configuration changed
+    this->in.dmi_invalidate();
   }
 }
 
@@ -194,6 +224,7 @@ int memory::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
   in.set_req_meth(&memory::req);
+  in.set_dmi_meth(&memory::dmi_req);
   new_slave_port("input", &in);
 
   js::config *config = get_js_config()->get("power_trigger");
@@ -212,6 +243,11 @@ int memory::build()
 
   power_event = this->event_new(memory::power_callback);
 
+  // Direct accesses are only granted while the accesses are neither traced
+  // nor accounted for power, masters must drop them when this changes
+  this->trace.set_active_callback([this]() { this->in.dmi_invalidate(); });
+  this->power_trace.trace.set_active_callback([this]() { this->in.dmi_invalidate(); });
+
   return 0;
 }
 
@@ -219,27 +255,22 @@ void memory::start()
 {
   size = get_config_int("size");
   check = get_config_bool("check");
-  width_bits = get_config_int("width_bits");
+  // The bandwidth is not modeled in functional mode, which also allows
+  // direct accesses
+  width_bits = vp::no_timing ? 0 : get_config_int("width_bits");
 
   trace.msg("Building memory (size: 0x%x, check: %d)\n", size, check);
 
-  mem_data = new uint8_t[size];
-
-
-  // Special option to check for uninitialized accesses
-  if (check)
-  {
-    check_mem = new uint8_t[(size + 7)/8];
-  }
-  else
+  // Initialize the memory with a special value to detect uninitialized
+  // variables. Large memories are only populated when they are touched.
+  // There is also a special option to check for uninitialized accesses.
+  if (this->backing.init(size, 0x57, check, vp::mem_backing::get_huge_pages(this->get_js_config()),
+    vp::mem_backing::get_chunk_size(this->get_js_config())))
   {
-    check_mem = NULL;
+    this->trace.fatal("Failed to allocate memory (size: 0x%lx)\n", size);
+    return;
   }
-
-
-  // Initialize the memory with a special value to detect uninitialized
-  // variables
-  memset(mem_data, 0x57, size);
+  mem_data = this->backing.get_data();
 
 
   // Preload the memory
@@ -249,13 +280,7 @@ void memory::start()
     string path = stim_file_conf->get_str();
     trace.msg("Preloading memory with stimuli file (path: %s)\n", path.c_str());
 
-    FILE *file = fopen(path.c_str(), "rb");
-    if (file == NULL)
-    {
-      this->trace.fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
-      return;
-    }
-    if (fread(this->mem_data, 1, size, file) == 0)
+    if (this->backing.preload_file(path.c_str()))
     {
       this->trace.fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
       return;
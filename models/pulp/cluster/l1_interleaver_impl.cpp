@@ -20,9 +20,24 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vp/itf/wire.hpp>
 #include <stdio.h>
 #include <math.h>
 
+class Bank_counter {
+public:
+  int64_t nb_conflicts = 0;
+  int64_t stalls = 0;
+
+  vp::wire_slave<uint32_t> nb_conflicts_itf;
+  vp::wire_slave<uint32_t> stalls_itf;
+
+  static void nb_conflicts_sync_back(void *__this, uint32_t *value);
+  static void nb_conflicts_sync(void *__this, uint32_t value);
+  static void stalls_sync_back(void *__this, uint32_t *value);
+  static void stalls_sync(void *__this, uint32_t value);
+};
+
 class interleaver : public vp::component
 {
 
@@ -37,6 +52,8 @@ public:
 
 
 private:
+  inline void account_bank(vp::io_req *req, int bank_id);
+
   vp::trace     trace;
 
   vp::io_master **out;
@@ -50,6 +67,13 @@ private:
   int stage_bits;
   uint64_t bank_mask;
   vp::io_req ts_req;
+
+  // Bank conflicts are modeled analytically. Each bank serves one access per
+  // cycle and only the last cycle it is busy is kept, so that the cost of an
+  // access does not depend on the number of banks.
+  bool model_conflicts;
+  int64_t *bank_busy_until;
+  Bank_counter *bank_counters;
 };
 
 interleaver::interleaver(const char *config)
@@ -58,6 +82,37 @@ interleaver::interleaver(const char *config)
 
 }
 
+// Delays the request until its bank is free, so that accesses to the same
+// bank are served one per cycle in arrival order.
+// Masters running ahead with temporal decoupling send their requests at the
+// current cycle of the interleaver whatever their local time, and could then
+// queue more accesses than they can really have in flight. The wait is thus
+// bounded by one access of each master, which is the most a bank can have
+// pending in a cycle.
+inline void interleaver::account_bank(vp::io_req *req, int bank_id)
+{
+  if (!this->model_conflicts || vp::no_timing || req->is_debug())
+    return;
+
+  int64_t arrival = this->get_cycles() + req->get_latency();
+  int64_t served = std::max(arrival, this->bank_busy_until[bank_id] + 1);
+  served = std::min(served, arrival + this->nb_masters);
+
+  this->bank_busy_until[bank_id] = served;
+
+  if (served > arrival)
+  {
+    Bank_counter *counter = &this->bank_counters[bank_id];
+    int64_t stalls = served - arrival;
+
+    this->trace.msg("Bank conflict (bank: %d, stalls: %ld)\n", bank_id, stalls);
+
+    counter->nb_conflicts++;
+    counter->stalls += stalls;
+    req->inc_latency(stalls);
+  }
+}
+
 vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
 {
   interleaver *_this = (interleaver *)__this;
@@ -71,6 +126,8 @@ vp::io_req_status_e interleaver::req(void *__this, vp::io_req *req)
   int bank_id = (offset >> 2) & _this->bank_mask;
   uint64_t bank_offset = ((offset >> (_this->stage_bits + 2)) << 2) + (offset & 0x3);
 
+  _this->account_bank(req, bank_id);
+
   req->set_addr(bank_offset);
   return _this->out[bank_id]->req_forward(req);
 }
@@ -90,6 +147,8 @@ vp::io_req_status_e interleaver::req_ts(void *__this, vp::io_req *req)
 
   bank_offset &= ~(1<<(20 - _this->stage_bits));
 
+  _this->account_bank(req, bank_id);
+
   if (!is_write)
   {
     req->set_addr(bank_offset);
@@ -122,6 +181,26 @@ int interleaver::build()
 
   bank_mask = (1<<stage_bits) - 1;
 
+  js::config *conf = get_js_config()->get("bank_conflicts");
+  model_conflicts = conf != NULL && conf->get_bool();
+
+  bank_busy_until = new int64_t[nb_slaves];
+  bank_counters = new Bank_counter[nb_slaves];
+  for (int i=0; i<nb_slaves; i++)
+  {
+    Bank_counter *counter = &bank_counters[i];
+
+    bank_busy_until[i] = -1;
+
+    counter->nb_conflicts_itf.set_sync_back_meth(&Bank_counter::nb_conflicts_sync_back);
+    counter->nb_conflicts_itf.set_sync_meth(&Bank_counter::nb_conflicts_sync);
+    new_slave_port((void *)counter, "nb_conflicts[" + std::to_string(i) + "]", &counter->nb_conflicts_itf);
+
+    counter->stalls_itf.set_sync_back_meth(&Bank_counter::stalls_sync_back);
+    counter->stalls_itf.set_sync_meth(&Bank_counter::stalls_sync);
+    new_slave_port((void *)counter, "stalls[" + std::to_string(i) + "]", &counter->stalls_itf);
+  }
+
   out = new vp::io_master *[nb_slaves];
   for (int i=0; i<nb_slaves; i++)
   {
@@ -150,4 +229,26 @@ extern "C" void *vp_constructor(const char *config)
   return (void *)new interleaver(config);
 }
 
+void Bank_counter::nb_conflicts_sync_back(void *__this, uint32_t *value)
+{
+  Bank_counter *_this = (Bank_counter *)__this;
+  *value = _this->nb_conflicts;
+}
+
+void Bank_counter::nb_conflicts_sync(void *__this, uint32_t value)
+{
+  Bank_counter *_this = (Bank_counter *)__this;
+  _this->nb_conflicts = value;
+}
 
+void Bank_counter::stalls_sync_back(void *__this, uint32_t *value)
+{
+  Bank_counter *_this = (Bank_counter *)__this;
+  *value = _this->stalls;
+}
+
+void Bank_counter::stalls_sync(void *__this, uint32_t value)
+{
+  Bank_counter *_this = (Bank_counter *)__this;
+  _this->stalls = value;
+}
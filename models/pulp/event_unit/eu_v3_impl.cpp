@@ -439,6 +439,7 @@ void Core_event_unit::build(Event_unit *top, int core_id)
   this->top->new_reg("core_" + std::to_string(core_id) + "/active", &this->is_active, 1);
 
   demux_in.set_req_meth_muxed(&Event_unit::demux_req, core_id);
+  demux_in.set_sync_on_access(true);
   top->new_slave_port("demux_in_" + std::to_string(core_id), &demux_in);
 
   wakeup_event = top->event_new((void *)this, Core_event_unit::wakeup_handler);
@@ -645,6 +646,7 @@ int Event_unit::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&Event_unit::req);
+  in.set_sync_on_access(true);
   new_slave_port("input", &in);
 
   core_eu = (Core_event_unit *)new Core_event_unit[nb_core];
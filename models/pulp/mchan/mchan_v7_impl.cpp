@@ -479,6 +479,7 @@ Mchan_channel::Mchan_channel(int id, mchan *top)
 : id(id), top(top)
 {
   in.set_req_meth_muxed(&mchan::req, id);
+  in.set_sync_on_access(true);
   top->new_slave_port("in_" + std::to_string(id), &in);
   pending_cmds = new Mchan_queue<Mchan_cmd>(top->core_queue_depth);
 
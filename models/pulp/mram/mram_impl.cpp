@@ -21,6 +21,7 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vp/mem_backing.hpp>
 #include <stdio.h>
 #include <string.h>
 #include <pulp/mram/mram.hpp>
@@ -38,6 +39,8 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi);
+
 private:
 
   vp::trace     trace;
@@ -45,6 +48,7 @@ private:
 
   uint64_t size = 0;
 
+  vp::mem_backing backing;
   uint8_t *mem_data;
 };
 
@@ -71,6 +75,8 @@ vp::io_req_status_e mram::req(void *__this, vp::io_req *req)
       return vp::IO_REQ_INVALID;
     }
 
+    _this->backing.populate(offset, size);
+
     if (req->get_is_write())
     {
       memcpy((void *)&_this->mem_data[offset], (void *)data, size);
@@ -85,6 +91,26 @@ vp::io_req_status_e mram::req(void *__this, vp::io_req *req)
 }
 
 
+bool mram::dmi_req(void *__this, uint64_t addr, vp::io_dmi *dmi)
+{
+  mram *_this = (mram *)__this;
+
+  // Traced accesses must go through the normal requests
+  if (_this->trace.get_active() || addr >= _this->size)
+  {
+    dmi->deny(0, -1);
+    return false;
+  }
+
+  // Writes depend on the current command, so only reads can be done directly.
+  // Large MRAMs are populated lazily, only the populated part is granted.
+  uint64_t base, size;
+  _this->backing.populate_area(addr, &base, &size);
+  dmi->grant(base, size, _this->mem_data + base, true);
+
+  return true;
+}
+
 void mram::reset(bool active)
 {
 }
@@ -94,10 +120,14 @@ int mram::build()
   traces.new_trace("trace", &trace, vp::DEBUG);
 
   in.set_req_meth(&mram::req);
+  in.set_dmi_meth(&mram::dmi_req);
   new_slave_port("input", &in);
 
   in.set_itf(static_cast<Mram_itf *>(this));
 
+  // Masters must drop their direct accesses when the trace is enabled
+  this->trace.set_active_callback([this]() { this->in.dmi_invalidate(); });
+
   return 0;
 }
 
@@ -107,11 +137,16 @@ void mram::start()
 
   trace.msg("Building MRAM (size: 0x%x)\n", this->size);
 
-  this->mem_data = new uint8_t[this->size];
-
   // Initialize the mram with a special value to detect uninitialized
-  // variables
-  memset(mem_data, 0x57, size);
+  // variables, large ones are only populated when they are touched
+  if (this->backing.init(this->size, 0x57, false, vp::mem_backing::get_huge_pages(this->get_js_config()),
+    vp::mem_backing::get_chunk_size(this->get_js_config())))
+  {
+    this->trace.fatal("Failed to allocate MRAM (size: 0x%lx)\n", this->size);
+    return;
+  }
+  this->mem_data = this->backing.get_data();
+
   // Preload the mram
   js::config *stim_file_conf = this->get_js_config()->get("stim_file");
   if (stim_file_conf != NULL)
@@ -119,13 +154,7 @@ void mram::start()
     string path = stim_file_conf->get_str();
     trace.msg("Preloading mram with stimuli file (path: %s)\n", path.c_str());
 
-    FILE *file = fopen(path.c_str(), "rb");
-    if (file == NULL)
-    {
-      this->trace.fatal("Unable to open stim file: %s, %s\n", path.c_str(), strerror(errno));
-      return;
-    }
-    if (fread(this->mem_data, 1, size, file) == 0)
+    if (this->backing.preload_file(path.c_str()))
     {
       this->trace.fatal("Failed to read stim file: %s, %s\n", path.c_str(), strerror(errno));
       return;
@@ -199,6 +199,7 @@ int soc_eu::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
   in.set_req_meth(&soc_eu::req);
+  in.set_sync_on_access(true);
   new_slave_port("input", &in);
 
   this->ref_clock_event = this->get_config_int("ref_clock_event");
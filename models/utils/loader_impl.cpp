@@ -45,6 +45,7 @@ public:
 private:
 
   void do_io_req(uint64_t addr, uint64_t size, bool is_write, uint8_t *data);
+  void req_free(vp::io_req *req);
   std::list<vp::io_req *> pending_reqs;
   vp::trace     trace;
   vp::io_master out;
@@ -59,24 +60,33 @@ void loader::grant(void *_this, vp::io_req *req)
 {
 }
 
+void loader::req_free(vp::io_req *req)
+{
+  delete[] req->get_data();
+  this->out.req_del(req);
+}
+
+// Returns true if the request is pending, otherwise it is freed
 bool loader::send_req(vp::io_req *req)
 {  
   vp::io_req_status_e err = out.req(req);
-  if (err == vp::IO_REQ_OK) return false;
-  else if (err == vp::IO_REQ_INVALID)
+  if (err != vp::IO_REQ_OK && err != vp::IO_REQ_INVALID) return true;
+
+  if (err == vp::IO_REQ_INVALID)
   {
     warning.warning("Invalid access while loading binary (addr: 0x%x, size: 0x%x, is_write: %d)\n", req->get_addr(), req->get_size(), true);
-    return false;
   }
-  return true;
+
+  this->req_free(req);
+
+  return false;
 }
 
 void loader::response(void *__this, vp::io_req *req)
 {
   loader *_this = (loader *)__this;
   _this->pending_reqs.pop_front();
-  delete req->get_data();
-  _this->out.req_del(req);
+  _this->req_free(req);
 
   while(1)
   {
@@ -20,11 +20,21 @@
 
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
+#include <vp/itf/wire.hpp>
 #include <stdio.h>
 #include <time.h>
+#include <inttypes.h>
 
 #define ENQUEUE_ITER 100000000
 #define CALL_ITER 100000000
+#define DOMAINS_ITER 1000000
+#define DYN_EVENTS 16
+
+// With the default wheel levels, the far event goes to the second level while
+// the near one, enqueued later, goes to the first level
+#define WHEEL_FAR_DELAY 2048
+#define WHEEL_NEAR_ENQUEUE 100
+#define WHEEL_NEAR_DELAY 2100
 
 class master : public vp::component
 {
@@ -40,11 +50,16 @@ public:
   static void test_enqueue_1(void *_this, vp::clock_event *event);
   static void test_enqueue_1_dyn(void *_this, vp::clock_event *event);
   static void test_enqueue_1_multiple(void *_this, vp::clock_event *event);
+  static void test_enqueue_dyn_multiple(void *_this, vp::clock_event *event);
   static void test_enqueue_10(void *_this, vp::clock_event *event);
   static void test_enqueue_100(void *_this, vp::clock_event *event);
   static void test_enqueue_var(void *_this, vp::clock_event *event);
   static void test_call(void *_this, vp::clock_event *event);
   static void test_call_sync(void *_this, vp::clock_event *event);
+  static void test_domains(void *_this, vp::clock_event *event);
+  static void test_wheel_far(void *_this, vp::clock_event *event);
+  static void test_wheel_near(void *_this, vp::clock_event *event);
+  static void test_wheel_enqueue_near(void *_this, vp::clock_event *event);
 
   static void test(void *_this, vp::clock_event *event);
 
@@ -56,8 +71,13 @@ private:
 
   vp::trace trace;
   vp::io_master out;
+  vp::wire_master<int> tickers_itf;
   int step;
   int delay;
+  int nb_tickers;
+  int nb_active_tickers;
+  int64_t wheel_start;
+  bool wheel_far_done;
 };
 
 void master::test_enqueue_1(void *__this, vp::clock_event *event)
@@ -143,6 +163,38 @@ void master::test_enqueue_1_multiple(void *__this, vp::clock_event *event)
   }
 }
 
+void master::test_enqueue_dyn_multiple(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  // Each event is reallocated with the same delay, stored in its arguments
+  int64_t delay = (int64_t)event->get_args()[0];
+
+  _this->event_del(event);
+
+  static int count = 0;
+  static clock_t start;
+
+  if (count == 0)
+  {
+    start = ::clock();
+  }
+
+  count++;
+
+  if (count == ENQUEUE_ITER)
+  {
+     clock_t end = ::clock();
+     double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
+     printf("%f\n", ENQUEUE_ITER / time_elapsed_in_seconds / 1000000);
+    _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+  }
+  else if (count <= ENQUEUE_ITER - DYN_EVENTS)
+  {
+    _this->event_enqueue(_this->event_new(master::test_enqueue_dyn_multiple, (void *)delay), delay);
+  }
+}
+
 void master::test_enqueue_10(void *__this, vp::clock_event *event)
 {
   master *_this = (master *)__this;
@@ -262,6 +314,78 @@ void master::test_call_sync(void *__this, vp::clock_event *event)
   _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
 }
 
+void master::test_domains(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  static int count = 0;
+  static clock_t start;
+
+  if (count == 0)
+  {
+    start = ::clock();
+  }
+
+  count++;
+
+  if (count == DOMAINS_ITER)
+  {
+    clock_t end = ::clock();
+    double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
+    // Report the number of clock domains executed per second, including ours
+    printf("%f\n", (double)DOMAINS_ITER * (_this->nb_active_tickers + 1) / time_elapsed_in_seconds / 1000000);
+    count = 0;
+    _this->tickers_itf.sync(0);
+    _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+  }
+  else
+  {
+    _this->event_enqueue(event, 1);
+  }
+}
+
+// The far event is enqueued first, in an upper level of the wheel, and the near
+// one is enqueued later, into a lower level, while it is still after the far
+// one, which must still be executed first and at the right cycle.
+void master::test_wheel_far(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  _this->event_del(event);
+
+  if (_this->get_cycles() != _this->wheel_start + WHEEL_FAR_DELAY)
+  {
+    printf("Far event executed at cycle %" PRId64 " instead of %" PRId64 "\n", _this->get_cycles(), _this->wheel_start + WHEEL_FAR_DELAY);
+    exit(1);
+  }
+
+  _this->wheel_far_done = true;
+}
+
+void master::test_wheel_near(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  _this->event_del(event);
+
+  if (!_this->wheel_far_done || _this->get_cycles() != _this->wheel_start + WHEEL_NEAR_DELAY)
+  {
+    printf("Near event executed at cycle %" PRId64 " instead of %" PRId64 " after the far one\n", _this->get_cycles(), _this->wheel_start + WHEEL_NEAR_DELAY);
+    exit(1);
+  }
+
+  printf("OK\n");
+  _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+}
+
+void master::test_wheel_enqueue_near(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  _this->event_del(event);
+  _this->event_enqueue(_this->event_new(master::test_wheel_near), WHEEL_NEAR_DELAY - WHEEL_NEAR_ENQUEUE);
+}
+
 void master::test(void *__this, vp::clock_event *event)
 {
   master *_this = (master *)__this;
@@ -313,6 +437,36 @@ void master::test(void *__this, vp::clock_event *event)
       _this->event = _this->event_new(master::test_call_sync);
       _this->event_enqueue(_this->event, 1);
       break;
+    case 8:
+      printf("Benchmarking event enqueue with %d events with allocation and arguments\n", DYN_EVENTS);
+      for (int64_t i=1; i<=DYN_EVENTS; i++)
+      {
+        _this->event_enqueue(_this->event_new(master::test_enqueue_dyn_multiple, (void *)i), i);
+      }
+      break;
+    case 9:
+      printf("Checking order of far events enqueued before nearer ones\n");
+      _this->wheel_start = _this->get_cycles();
+      _this->wheel_far_done = false;
+      _this->event_enqueue(_this->event_new(master::test_wheel_far), WHEEL_FAR_DELAY);
+      _this->event_enqueue(_this->event_new(master::test_wheel_enqueue_near), WHEEL_NEAR_ENQUEUE);
+      break;
+    case 10:
+    case 11:
+    case 12:
+    case 13:
+    {
+      // Each step multiplies the number of active clock domains by 4
+      int nb_active_tickers = 1 << ((_this->step - 10) * 2);
+      if (nb_active_tickers > _this->nb_tickers)
+        exit(0);
+      _this->nb_active_tickers = nb_active_tickers;
+      printf("Benchmarking event enqueue with %d other clock domains\n", nb_active_tickers);
+      _this->tickers_itf.sync(nb_active_tickers);
+      _this->event = _this->event_new(master::test_domains);
+      _this->event_enqueue(_this->event, 1);
+      break;
+    }
     default:
       exit(0);
   }
@@ -333,12 +487,15 @@ int master::build()
 
   new_master_port("out", &out);
 
+  new_master_port("tickers", &tickers_itf);
+
   return 0;
 }
 
 void master::start()
 {
   step = 0;
+  nb_tickers = get_config_int("nb_tickers");
   event_enqueue(event_new(master::test), 1);
 }
 
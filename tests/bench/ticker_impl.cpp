@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <vp/itf/wire.hpp>
+#include <stdio.h>
+
+
+class ticker : public vp::component
+{
+
+public:
+
+  ticker(const char *config);
+
+  int build();
+
+  static void tick(void *__this, vp::clock_event *event);
+
+  static void enable_sync(void *__this, int nb_tickers);
+
+private:
+
+  vp::wire_slave<int> enable_itf;
+  vp::wire_master<int> next_itf;
+
+  vp::clock_event *event;
+  bool enabled = false;
+};
+
+void ticker::tick(void *__this, vp::clock_event *event)
+{
+  ticker *_this = (ticker *)__this;
+
+  if (_this->enabled)
+  {
+    _this->event_enqueue(event, 1);
+  }
+}
+
+// The master gives the number of tickers to be activated, we take one and
+// forward the rest to the next one.
+void ticker::enable_sync(void *__this, int nb_tickers)
+{
+  ticker *_this = (ticker *)__this;
+
+  _this->enabled = nb_tickers > 0;
+
+  if (_this->enabled)
+  {
+    if (!_this->event->is_enqueued())
+      _this->event_enqueue_ext(_this->event, 1);
+  }
+  else
+  {
+    _this->event_cancel(_this->event);
+  }
+
+  if (_this->next_itf.is_bound())
+  {
+    _this->next_itf.sync(nb_tickers > 0 ? nb_tickers - 1 : 0);
+  }
+}
+
+int ticker::build()
+{
+  enable_itf.set_sync_meth(&ticker::enable_sync);
+  new_slave_port("enable", &enable_itf);
+
+  new_master_port("next", &next_itf);
+
+  event = event_new(ticker::tick);
+
+  return 0;
+}
+
+ticker::ticker(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new ticker(config);
+}
@@ -31,3 +31,19 @@ class component(vp.component):
         master.get_port('out').bind_to(slave.get_port('in'))
 
         clock.get_port('out').bind_to(master.get_port('clock'))
+
+        # Additional clock domains, each one with a component executing one
+        # event per cycle, to measure the cost of switching between domains.
+        # They are chained so that the master can tell how many are active.
+        tickers_port = master.get_port('tickers')
+
+        for i in range(0, self.get_config().get_config('nb_tickers').get_int()):
+
+            ticker_clock = self.new('ticker_clock_%d' % i, component='vp/clock_domain', config=self.get_config().get_config('clock_domain'))
+
+            ticker = self.new('ticker_%d' % i, component='ticker', config=self.get_config())
+
+            ticker_clock.get_port('out').bind_to(ticker.get_port('clock'))
+
+            tickers_port.bind_to(ticker.get_port('enable'))
+            tickers_port = ticker.get_port('next')
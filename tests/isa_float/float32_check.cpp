@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks the native binary32 operations of isa_lib/int.h against a reference
+// computed in binary64, for every rounding mode, on special and random
+// operands. Results and fflags must match exactly, NaNs must be the canonical
+// one, and the host environment must be given back with the default rounding
+// mode by lib_float_host_release.
+//
+// Binary64 has more than twice the precision of binary32 plus 2 bits, so
+// rounding the binary64 result of an add, sub, mul, div or sqrt of binary32
+// operands again to binary32, in the same mode, gives the correctly rounded
+// result. The FMA sum is not exact in binary64, so it is rounded to odd
+// first, which keeps enough information for the second rounding.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <fenv.h>
+#include "iss.hpp"
+
+#define RANDOM_ITER 200000
+
+static const int host_modes[] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD };
+static const char *mode_names[] = { "rne", "rtz", "rdn", "rup" };
+
+static iss_cpu_state_t state;
+static int nb_errors = 0;
+static int nb_checks = 0;
+
+static uint32_t special_values[] = {
+  0x00000000, 0x80000000, // zeros
+  0x00000001, 0x80000001, 0x007fffff, 0x807fffff, // subnormals
+  0x00800000, 0x80800000, 0x00800001, // smallest normals
+  0x3f800000, 0xbf800000, 0x3f800001, 0x3fffffff, 0x40000000, 0x40400000,
+  0x3eaaaaab, 0x4b000000, 0x4b7fffff, 0x4effffff, 0x4f000000, 0xcf000000,
+  0xcf000001, 0x4f800000, 0x4f7fffff, 0x3f000000, 0xbf000000, 0x3fc00000,
+  0xbfc00000, 0x40200000, 0xc0200000, 0x3f7fffff, 0x7f7fffff, 0xff7fffff, // large
+  0x7f800000, 0xff800000, // infinities
+  0x7fc00000, 0xffc00000, 0x7fc00001, // quiet NaNs
+  0x7f800001, 0xffbfffff, 0x7fa00000, // signalling NaNs
+};
+
+#define NB_SPECIAL_VALUES (sizeof(special_values) / sizeof(special_values[0]))
+
+static inline float to_float(uint32_t a)
+{
+  union { uint32_t i; float f; } u = { a };
+  return u.f;
+}
+
+static inline uint32_t to_bits(float f)
+{
+  union { float f; uint32_t i; } u = { f };
+  return u.i;
+}
+
+static inline double to_double_odd(double d, bool inexact)
+{
+  // d has been rounded toward zero, setting the last bit when the exact
+  // value was not representable gives the value rounded to odd
+  union { double d; uint64_t i; } u = { d };
+  if (inexact && !isinf(d))
+    u.i |= 1;
+  return u.d;
+}
+
+static unsigned int host_fflags()
+{
+  int ex = fetestexcept(FE_ALL_EXCEPT);
+  return !!(ex & FE_INEXACT) | !!(ex & FE_UNDERFLOW) << 1 | !!(ex & FE_OVERFLOW) << 2 |
+    !!(ex & FE_DIVBYZERO) << 3 | !!(ex & FE_INVALID) << 4;
+}
+
+static uint32_t canonical(uint32_t a)
+{
+  return (a & 0x7fffffff) > 0x7f800000 ? 0x7fc00000 : a;
+}
+
+static bool is_snan(uint32_t a)
+{
+  return (a & 0x7fffffff) > 0x7f800000 && !(a & 0x00400000);
+}
+
+typedef enum {
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_SQRT,
+  OP_MADD, OP_MSUB, OP_NMADD, OP_NMSUB,
+  OP_TO_W, OP_TO_WU, OP_FROM_W, OP_FROM_WU,
+  OP_NB
+} op_e;
+
+static const char *op_names[] = {
+  "add", "sub", "mul", "div", "sqrt", "madd", "msub", "nmadd", "nmsub",
+  "to_w", "to_wu", "from_w", "from_wu"
+};
+
+static uint32_t native_exec(op_e op, uint32_t a, uint32_t b, uint32_t c, unsigned int round)
+{
+  switch (op)
+  {
+    case OP_ADD:     return lib_float32_add_round(&state, a, b, round);
+    case OP_SUB:     return lib_float32_sub_round(&state, a, b, round);
+    case OP_MUL:     return lib_float32_mul_round(&state, a, b, round);
+    case OP_DIV:     return lib_float32_div_round(&state, a, b, round);
+    case OP_SQRT:    return lib_float32_sqrt_round(&state, a, round);
+    case OP_MADD:    return lib_float32_madd_round(&state, a, b, c, round);
+    case OP_MSUB:    return lib_float32_msub_round(&state, a, b, c, round);
+    case OP_NMADD:   return lib_float32_nmadd_round(&state, a, b, c, round);
+    case OP_NMSUB:   return lib_float32_nmsub_round(&state, a, b, c, round);
+    case OP_TO_W:    return lib_float32_to_w_round(&state, a, round);
+    case OP_TO_WU:   return lib_float32_to_wu_round(&state, a, round);
+    case OP_FROM_W:  return lib_float32_from_w_round(&state, a, round);
+    case OP_FROM_WU: return lib_float32_from_wu_round(&state, a, round);
+    default:         return 0;
+  }
+}
+
+// Rounds x * y + z, exactly computed, to binary32 in the given mode
+static float ref_fma(float x, float y, float z, int mode, unsigned int *flags)
+{
+  // The product of 2 binary32 is exact in binary64, it can only be invalid
+  fesetround(FE_TOWARDZERO);
+  feclearexcept(FE_ALL_EXCEPT);
+  // Volatile so that the sum is computed again in the target mode
+  volatile double p = (double)x * (double)y;
+  double s = p + (double)z;
+  bool inexact = fetestexcept(FE_INEXACT);
+  bool invalid = fetestexcept(FE_INVALID);
+  fesetround(mode);
+  feclearexcept(FE_ALL_EXCEPT);
+  float result;
+  if (s == 0 && !inexact)
+    // Exact zero, the sign depends on the rounding mode
+    result = (float)(p + (double)z);
+  else
+    result = (float)to_double_odd(s, inexact);
+  *flags = host_fflags() | inexact | invalid << 4;
+  return result;
+}
+
+static uint32_t ref_exec(op_e op, uint32_t a, uint32_t b, uint32_t c, unsigned int round, unsigned int *flags)
+{
+  int mode = host_modes[round];
+  float fa = to_float(a), fb = to_float(b), fc = to_float(c);
+  uint32_t result = 0;
+
+  *flags = 0;
+
+  if (op <= OP_NMSUB && op != OP_SQRT)
+  {
+    // Invalid is raised by signalling NaNs, and the result of any NaN
+    // operand is the canonical NaN
+    bool has_nan = isnan(fa) || isnan(fb) || (op >= OP_MADD && isnan(fc));
+    bool has_snan = is_snan(a) || is_snan(b) || (op >= OP_MADD && is_snan(c));
+    if (has_nan)
+    {
+      *flags = has_snan ? 0x10 : 0;
+      // inf * 0 + qNaN is also invalid
+      if (op >= OP_MADD && !isnan(fa) && !isnan(fb) &&
+        ((isinf(fa) && fb == 0) || (isinf(fb) && fa == 0)))
+        *flags = 0x10;
+      return 0x7fc00000;
+    }
+  }
+
+  fesetround(mode);
+  feclearexcept(FE_ALL_EXCEPT);
+
+  switch (op)
+  {
+    case OP_ADD:  result = to_bits((float)((double)fa + (double)fb)); break;
+    case OP_SUB:  result = to_bits((float)((double)fa - (double)fb)); break;
+    case OP_MUL:  result = to_bits((float)((double)fa * (double)fb)); break;
+    case OP_DIV:  result = to_bits((float)((double)fa / (double)fb)); break;
+    case OP_SQRT:
+      if (isnan(fa))
+      {
+        fesetround(FE_TONEAREST);
+        *flags = is_snan(a) ? 0x10 : 0;
+        return 0x7fc00000;
+      }
+      result = to_bits((float)sqrt((double)fa));
+      break;
+    case OP_MADD:  result = to_bits(ref_fma(fa, fb, fc, mode, flags)); break;
+    case OP_MSUB:  result = to_bits(ref_fma(fa, fb, -fc, mode, flags)); break;
+    case OP_NMADD: result = to_bits(ref_fma(-fa, fb, -fc, mode, flags)); break;
+    case OP_NMSUB: result = to_bits(ref_fma(-fa, fb, fc, mode, flags)); break;
+
+    case OP_TO_W:
+    case OP_TO_WU:
+    {
+      double min = op == OP_TO_W ? -2147483648.0 : 0.0;
+      double max = op == OP_TO_W ? 2147483647.0 : 4294967295.0;
+      double r = nearbyint((double)fa);
+      if (isnan(fa) || r > max)
+      {
+        *flags = 0x10;
+        result = op == OP_TO_W ? INT32_MAX : UINT32_MAX;
+      }
+      else if (r < min)
+      {
+        *flags = 0x10;
+        result = op == OP_TO_W ? INT32_MIN : 0;
+      }
+      else
+      {
+        *flags = r != (double)fa;
+        result = op == OP_TO_W ? (uint32_t)(int32_t)r : (uint32_t)r;
+      }
+      fesetround(FE_TONEAREST);
+      return result;
+    }
+
+    case OP_FROM_W:  result = to_bits((float)(double)(int32_t)a); break;
+    case OP_FROM_WU: result = to_bits((float)(double)a); break;
+
+    default: break;
+  }
+
+  if (op < OP_MADD || op > OP_NMSUB)
+    *flags = host_fflags();
+
+  fesetround(FE_TONEAREST);
+
+  return canonical(result);
+}
+
+static void check(op_e op, uint32_t a, uint32_t b, uint32_t c, unsigned int round)
+{
+  unsigned int exp_flags, flags;
+  uint32_t expected = ref_exec(op, a, b, c, round, &exp_flags);
+
+  // Another component may have left flags in the host environment, they must
+  // not be seen by the core
+  feraiseexcept(FE_DIVBYZERO);
+
+  state.fcsr.fflags.raw = 0;
+  state.fcsr.frm = round;
+  // Use the dynamic rounding mode half of the time
+  uint32_t result = native_exec(op, a, b, c, (a ^ b) & 1 ? 7 : round);
+  lib_float_host_release(&state);
+  flags = state.fcsr.fflags.raw;
+
+  nb_checks++;
+
+  if (op == OP_TO_W || op == OP_TO_WU)
+    result = (uint32_t)(int64_t)result;
+
+  if (result != expected || flags != exp_flags || fegetround() != FE_TONEAREST)
+  {
+    if (nb_errors < 20)
+      printf("Error in %s.%s (a: 0x%8.8x, b: 0x%8.8x, c: 0x%8.8x, result: 0x%8.8x, expected: 0x%8.8x, fflags: 0x%x, expected: 0x%x, host_round: %d)\n",
+        op_names[op], mode_names[round], a, b, c, result, expected, flags, exp_flags, fegetround());
+    nb_errors++;
+    fesetround(FE_TONEAREST);
+  }
+}
+
+static uint32_t random_operand()
+{
+  uint32_t value = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+  switch (rand() & 7)
+  {
+    // Mostly random bits, with some special values and small exponents to
+    // cover subnormal results and overflows
+    case 0: return special_values[rand() % NB_SPECIAL_VALUES];
+    case 1: return (value & 0x807fffff) | ((rand() % 24) << 23);
+    case 2: return (value & 0x807fffff) | ((0xfe - rand() % 8) << 23);
+    default: return value;
+  }
+}
+
+static void check_lazy_flags()
+{
+  // Flags stay pending in the host environment until the core releases it,
+  // and several operations in a row accumulate them
+  state.fcsr.fflags.raw = 0;
+  lib_float32_div_round(&state, to_bits(1.0f), to_bits(3.0f), 3);
+  lib_float32_div_round(&state, to_bits(1.0f), to_bits(0.0f), 3);
+  nb_checks++;
+  if (!state.fp_host_owned || fegetround() != FE_UPWARD)
+  {
+    printf("Error, the host environment should be owned by the core\n");
+    nb_errors++;
+  }
+  lib_float_host_release(&state);
+  nb_checks++;
+  if (state.fcsr.fflags.raw != 0x9 || state.fp_host_owned || fegetround() != FE_TONEAREST)
+  {
+    printf("Error after release (fflags: 0x%x, expected: 0x9, round: %d)\n", state.fcsr.fflags.raw, fegetround());
+    nb_errors++;
+  }
+}
+
+int main()
+{
+  srand(1);
+
+  check_lazy_flags();
+
+  for (int round=0; round<4; round++)
+  {
+    for (int op=0; op<OP_NB; op++)
+    {
+      for (unsigned int i=0; i<NB_SPECIAL_VALUES; i++)
+      {
+        for (unsigned int j=0; j<NB_SPECIAL_VALUES; j++)
+        {
+          uint32_t a = special_values[i], b = special_values[j];
+          if (op >= OP_MADD && op <= OP_NMSUB)
+          {
+            for (unsigned int k=0; k<NB_SPECIAL_VALUES; k++)
+              check((op_e)op, a, b, special_values[k], round);
+          }
+          else
+          {
+            check((op_e)op, a, b, 0, round);
+          }
+        }
+      }
+
+      for (int i=0; i<RANDOM_ITER; i++)
+      {
+        check((op_e)op, random_operand(), random_operand(), random_operand(), round);
+      }
+    }
+  }
+
+  if (nb_errors)
+  {
+    printf("Got %d errors out of %d checks\n", nb_errors, nb_checks);
+    return -1;
+  }
+
+  printf("All %d checks passed\n", nb_checks);
+  return 0;
+}
@@ -0,0 +1,684 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks the small floating-point formats of isa_lib/sfloat.h, f8 (5,2), f16
+// (5,10) and f16alt (8,7), against a reference computing the exact result with
+// integers and rounding it once, for the 4 rounding modes. Results and fflags
+// must match exactly.
+//
+// The f8 tables are checked on all operand pairs. The other operations and
+// formats are checked on special and random operands, the FMA operands having
+// close exponents half of the time so that the sums cancel, which exercises
+// the rounding to odd.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "iss.hpp"
+
+#define RANDOM_ITER 300000
+
+typedef unsigned __int128 u128_t;
+
+#define FLAG_NX 0x01
+#define FLAG_UF 0x02
+#define FLAG_OF 0x04
+#define FLAG_DZ 0x08
+#define FLAG_NV 0x10
+
+// Operands and results further apart than this only contribute to the sticky
+// bit of the sum
+#define ALIGN_MAX_BITS 64
+
+typedef enum {
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_SQRT,
+  OP_MADD, OP_MSUB, OP_NMADD, OP_NMSUB, OP_CVT,
+  OP_NB
+} op_e;
+
+static const char *op_names[] = {
+  "add", "sub", "mul", "div", "sqrt", "madd", "msub", "nmadd", "nmsub", "cvt"
+};
+
+typedef struct {
+  int e;
+  int m;
+  const char *name;
+} format_t;
+
+static const format_t formats[] = {
+  { 5, 2, "f8" }, { 5, 10, "f16" }, { 8, 7, "f16alt" }, { 8, 23, "f32" }
+};
+
+#define NB_SMALL_FORMATS 3
+#define NB_FORMATS 4
+
+static iss_cpu_state_t state;
+static int nb_errors = 0;
+static long nb_checks = 0;
+
+typedef enum { VAL_NUM, VAL_INF, VAL_NAN } val_class_e;
+
+// Decoded operand, with the value mant * 2^exp for numbers
+typedef struct {
+  val_class_e cls;
+  int sign;
+  bool snan;
+  uint64_t mant;
+  int exp;
+} val_t;
+
+static val_t decode(uint32_t a, int e, int m)
+{
+  val_t v;
+  uint32_t exp_mask = (1 << e) - 1;
+  int bias = (1 << (e - 1)) - 1;
+  uint32_t exp = (a >> m) & exp_mask;
+  uint32_t frac = a & ((1 << m) - 1);
+
+  v.sign = (a >> (e + m)) & 1;
+  v.snan = false;
+  v.mant = 0;
+  v.exp = 0;
+
+  if (exp == exp_mask)
+  {
+    v.cls = frac ? VAL_NAN : VAL_INF;
+    v.snan = frac && !((frac >> (m - 1)) & 1);
+  }
+  else
+  {
+    v.cls = VAL_NUM;
+    v.mant = exp ? (1 << m) | frac : frac;
+    v.exp = (exp ? exp : 1) - bias - m;
+  }
+
+  return v;
+}
+
+static uint32_t canonical_nan(int e, int m)
+{
+  return (((1 << e) - 1) << m) | (1 << (m - 1));
+}
+
+static uint32_t infinity(int sign, int e, int m)
+{
+  return (sign << (e + m)) | (((1 << e) - 1) << m);
+}
+
+static int msb(u128_t x)
+{
+  int n = -1;
+  while (x)
+  {
+    x >>= 1;
+    n++;
+  }
+  return n;
+}
+
+// Returns 1 if mant, quantized at 2^shift, must be rounded up. cmp is the
+// comparison of the remainder with half a quantum.
+static int round_up(u128_t q, int cmp, bool inexact, int sign, int mode)
+{
+  switch (mode)
+  {
+    case 0:  return cmp > 0 || (cmp == 0 && (q & 1));
+    case 1:  return 0;
+    case 2:  return inexact && sign;
+    default: return inexact && !sign;
+  }
+}
+
+// Quantizes (mant + sticky) * 2^exp, sticky meaning that the exact value is
+// strictly between mant and mant + 1, at 2^quantum. mant must be below 2^120.
+static u128_t quantize(u128_t mant, int exp, bool sticky, int quantum, int sign, int mode, bool *inexact)
+{
+  int shift = quantum - exp;
+  u128_t q;
+  int cmp;
+
+  if (shift <= 0)
+  {
+    q = mant << -shift;
+    cmp = sticky ? -1 : -2;
+  }
+  else if (shift > 121)
+  {
+    q = 0;
+    cmp = mant || sticky ? -1 : -2;
+  }
+  else
+  {
+    u128_t rem = mant & (((u128_t)1 << shift) - 1);
+    u128_t half = (u128_t)1 << (shift - 1);
+    q = mant >> shift;
+    if (rem == 0 && !sticky)
+      cmp = -2;
+    else if (rem == half)
+      cmp = sticky ? 1 : 0;
+    else
+      cmp = rem > half ? 1 : -1;
+  }
+
+  // -2 means exact
+  *inexact = cmp != -2;
+  if (cmp == -2)
+    cmp = -1;
+
+  return q + round_up(q, cmp, *inexact, sign, mode);
+}
+
+// Rounds the exact value (mant + sticky) * 2^exp, which is not zero, to the
+// format, with tininess detected after rounding as RISC-V does
+static uint32_t round_exact(int sign, u128_t mant, int exp, bool sticky, int e, int m, int mode, unsigned int *flags)
+{
+  int bias = (1 << (e - 1)) - 1;
+  int emin = 1 - bias;
+  int emax = bias;
+
+  // Keep enough bits for the rounding when the value is only given by the
+  // sticky bit
+  if (mant == 0)
+  {
+    mant = 1;
+    exp -= 200;
+    sticky = false;
+  }
+
+  // Exponent of the value, which is in [2^value_exp, 2^(value_exp+1)[
+  int value_exp = msb(mant) + exp;
+  int quantum = (value_exp < emin ? emin : value_exp) - m;
+  bool inexact;
+  u128_t q = quantize(mant, exp, sticky, quantum, sign, mode, &inexact);
+
+  if (q == ((u128_t)1 << (m + 1)))
+  {
+    q >>= 1;
+    quantum++;
+  }
+
+  if (inexact)
+  {
+    *flags |= FLAG_NX;
+
+    if (value_exp < emin)
+    {
+      // Tiny if the value rounded with an unbounded exponent is below 2^emin
+      bool unbounded_inexact;
+      u128_t qu = quantize(mant, exp, sticky, value_exp - m, sign, mode, &unbounded_inexact);
+      if (!(qu == ((u128_t)1 << (m + 1)) && value_exp + 1 == emin))
+        *flags |= FLAG_UF;
+    }
+  }
+
+  if (q >= ((u128_t)1 << m) && quantum + m > emax)
+  {
+    *flags |= FLAG_OF | FLAG_NX;
+    bool to_inf = mode == 0 || (mode == 2 && sign) || (mode == 3 && !sign);
+    if (to_inf)
+      return infinity(sign, e, m);
+    return (sign << (e + m)) | ((((1 << e) - 2) << m) | ((1 << m) - 1));
+  }
+
+  if (q < ((u128_t)1 << m))
+    return (sign << (e + m)) | (uint32_t)q;
+
+  return (sign << (e + m)) | ((quantum + m + bias) << m) | ((uint32_t)q & ((1 << m) - 1));
+}
+
+// Exact sum of 2 signed values, each one being mant * 2^exp, with mantissas
+// below 2^32, returned as a magnitude, a sign and a sticky bit
+static void add_exact(int s1, uint64_t m1, int e1, int s2, uint64_t m2, int e2,
+  int *sign, u128_t *mant, int *exp, bool *sticky)
+{
+  *sticky = false;
+
+  if (m1 == 0 || (m2 != 0 && e2 > e1))
+  {
+    std::swap(s1, s2);
+    std::swap(m1, m2);
+    std::swap(e1, e2);
+  }
+
+  if (m2 == 0)
+  {
+    *sign = s1;
+    *mant = m1;
+    *exp = e1;
+    return;
+  }
+
+  if (e1 - e2 > ALIGN_MAX_BITS)
+  {
+    // The smaller one is below the last bit of the bigger one, shifted enough
+    // to leave room for the rounding
+    *sign = s1;
+    *mant = (u128_t)m1 << ALIGN_MAX_BITS;
+    *exp = e1 - ALIGN_MAX_BITS;
+    *sticky = true;
+    if (s1 != s2)
+      *mant -= 1;
+    return;
+  }
+
+  u128_t a = (u128_t)m1 << (e1 - e2);
+  u128_t b = m2;
+  *exp = e2;
+  if (s1 == s2)
+  {
+    *sign = s1;
+    *mant = a + b;
+  }
+  else if (a >= b)
+  {
+    *sign = s1;
+    *mant = a - b;
+  }
+  else
+  {
+    *sign = s2;
+    *mant = b - a;
+  }
+}
+
+static u128_t isqrt(u128_t x)
+{
+  u128_t result = 0;
+  u128_t bit = (u128_t)1 << 126;
+
+  while (bit > x)
+    bit >>= 2;
+
+  while (bit)
+  {
+    if (x >= result + bit)
+    {
+      x -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return result;
+}
+
+static uint32_t ref_exec(op_e op, uint32_t a, uint32_t b, uint32_t c, int e, int m, int ed, int md, int mode, unsigned int *flags)
+{
+  val_t va = decode(a, e, m), vb = decode(b, e, m), vc = decode(c, e, m);
+  uint32_t nan = canonical_nan(e, m);
+
+  *flags = 0;
+
+  if (op == OP_SUB || op == OP_MSUB || op == OP_NMADD)
+    (op == OP_SUB ? vb : vc).sign ^= 1;
+  if (op == OP_NMADD || op == OP_NMSUB)
+    va.sign ^= 1;
+
+  switch (op)
+  {
+    case OP_ADD:
+    case OP_SUB:
+    {
+      if (va.cls == VAL_NAN || vb.cls == VAL_NAN)
+      {
+        *flags = va.snan || vb.snan ? FLAG_NV : 0;
+        return nan;
+      }
+      if (va.cls == VAL_INF && vb.cls == VAL_INF && va.sign != vb.sign)
+      {
+        *flags = FLAG_NV;
+        return nan;
+      }
+      if (va.cls == VAL_INF || vb.cls == VAL_INF)
+        return infinity(va.cls == VAL_INF ? va.sign : vb.sign, e, m);
+
+      int sign, exp;
+      u128_t mant;
+      bool sticky;
+      add_exact(va.sign, va.mant, va.exp, vb.sign, vb.mant, vb.exp, &sign, &mant, &exp, &sticky);
+      if (mant == 0)
+      {
+        if (va.mant == 0 && vb.mant == 0 && va.sign == vb.sign)
+          return va.sign << (e + m);
+        return (mode == 2) << (e + m);
+      }
+      return round_exact(sign, mant, exp, sticky, e, m, mode, flags);
+    }
+
+    case OP_MUL:
+    {
+      int sign = va.sign ^ vb.sign;
+      if (va.cls == VAL_NAN || vb.cls == VAL_NAN)
+      {
+        *flags = va.snan || vb.snan ? FLAG_NV : 0;
+        return nan;
+      }
+      if (va.cls == VAL_INF || vb.cls == VAL_INF)
+      {
+        if ((va.cls == VAL_NUM && va.mant == 0) || (vb.cls == VAL_NUM && vb.mant == 0))
+        {
+          *flags = FLAG_NV;
+          return nan;
+        }
+        return infinity(sign, e, m);
+      }
+      if (va.mant == 0 || vb.mant == 0)
+        return sign << (e + m);
+      return round_exact(sign, (u128_t)va.mant * vb.mant, va.exp + vb.exp, false, e, m, mode, flags);
+    }
+
+    case OP_DIV:
+    {
+      int sign = va.sign ^ vb.sign;
+      if (va.cls == VAL_NAN || vb.cls == VAL_NAN)
+      {
+        *flags = va.snan || vb.snan ? FLAG_NV : 0;
+        return nan;
+      }
+      if (va.cls == VAL_INF)
+      {
+        if (vb.cls == VAL_INF)
+        {
+          *flags = FLAG_NV;
+          return nan;
+        }
+        return infinity(sign, e, m);
+      }
+      if (vb.cls == VAL_INF)
+        return sign << (e + m);
+      if (vb.mant == 0)
+      {
+        if (va.mant == 0)
+        {
+          *flags = FLAG_NV;
+          return nan;
+        }
+        *flags = FLAG_DZ;
+        return infinity(sign, e, m);
+      }
+      if (va.mant == 0)
+        return sign << (e + m);
+      u128_t num = (u128_t)va.mant << 64;
+      u128_t q = num / vb.mant;
+      return round_exact(sign, q, va.exp - vb.exp - 64, q * vb.mant != num, e, m, mode, flags);
+    }
+
+    case OP_SQRT:
+    {
+      if (va.cls == VAL_NAN)
+      {
+        *flags = va.snan ? FLAG_NV : 0;
+        return nan;
+      }
+      if (va.cls == VAL_NUM && va.mant == 0)
+        return a;
+      if (va.sign)
+      {
+        *flags = FLAG_NV;
+        return nan;
+      }
+      if (va.cls == VAL_INF)
+        return a;
+      u128_t mant = va.mant;
+      int exp = va.exp;
+      if (exp & 1)
+      {
+        mant <<= 1;
+        exp--;
+      }
+      mant <<= 100;
+      u128_t root = isqrt(mant);
+      return round_exact(0, root, exp / 2 - 50, root * root != mant, e, m, mode, flags);
+    }
+
+    case OP_MADD:
+    case OP_MSUB:
+    case OP_NMADD:
+    case OP_NMSUB:
+    {
+      int prod_sign = va.sign ^ vb.sign;
+      bool inf_zero = (va.cls == VAL_INF && vb.cls == VAL_NUM && vb.mant == 0) ||
+        (vb.cls == VAL_INF && va.cls == VAL_NUM && va.mant == 0);
+
+      if (inf_zero)
+      {
+        *flags = FLAG_NV;
+        return nan;
+      }
+      if (va.cls == VAL_NAN || vb.cls == VAL_NAN || vc.cls == VAL_NAN)
+      {
+        *flags = va.snan || vb.snan || vc.snan ? FLAG_NV : 0;
+        return nan;
+      }
+      if (va.cls == VAL_INF || vb.cls == VAL_INF)
+      {
+        if (vc.cls == VAL_INF && vc.sign != prod_sign)
+        {
+          *flags = FLAG_NV;
+          return nan;
+        }
+        return infinity(prod_sign, e, m);
+      }
+      if (vc.cls == VAL_INF)
+        return infinity(vc.sign, e, m);
+
+      uint64_t prod = va.mant * vb.mant;
+      int sign, exp;
+      u128_t mant;
+      bool sticky;
+      add_exact(prod_sign, prod, va.exp + vb.exp, vc.sign, vc.mant, vc.exp, &sign, &mant, &exp, &sticky);
+      if (mant == 0)
+      {
+        if (prod == 0 && vc.mant == 0 && prod_sign == vc.sign)
+          return prod_sign << (e + m);
+        return (mode == 2) << (e + m);
+      }
+      return round_exact(sign, mant, exp, sticky, e, m, mode, flags);
+    }
+
+    case OP_CVT:
+    {
+      if (va.cls == VAL_NAN)
+      {
+        *flags = va.snan ? FLAG_NV : 0;
+        return canonical_nan(ed, md);
+      }
+      if (va.cls == VAL_INF)
+        return infinity(va.sign, ed, md);
+      if (va.mant == 0)
+        return va.sign << (ed + md);
+      return round_exact(va.sign, va.mant, va.exp, false, ed, md, mode, flags);
+    }
+
+    default:
+      return 0;
+  }
+}
+
+static uint32_t sf_exec(op_e op, uint32_t a, uint32_t b, uint32_t c, int e, int m, int ed, int md, unsigned int round)
+{
+  switch (op)
+  {
+    case OP_ADD:   return lib_flexfloat_add_round(&state, a, b, e, m, round);
+    case OP_SUB:   return lib_flexfloat_sub_round(&state, a, b, e, m, round);
+    case OP_MUL:   return lib_flexfloat_mul_round(&state, a, b, e, m, round);
+    case OP_DIV:   return lib_flexfloat_div_round(&state, a, b, e, m, round);
+    case OP_SQRT:  return lib_flexfloat_sqrt_round(&state, a, e, m, round);
+    case OP_MADD:  return lib_flexfloat_madd_round(&state, a, b, c, e, m, round);
+    case OP_MSUB:  return lib_flexfloat_msub_round(&state, a, b, c, e, m, round);
+    case OP_NMADD: return lib_flexfloat_nmadd_round(&state, a, b, c, e, m, round);
+    case OP_NMSUB: return lib_flexfloat_nmsub_round(&state, a, b, c, e, m, round);
+    case OP_CVT:   return lib_flexfloat_cvt_ff_ff_round(&state, a, e, m, ed, md, round);
+    default:       return 0;
+  }
+}
+
+static void check(op_e op, uint32_t a, uint32_t b, uint32_t c, int e, int m, int ed, int md, int mode)
+{
+  unsigned int exp_flags;
+  uint32_t expected = ref_exec(op, a, b, c, e, m, ed, md, mode, &exp_flags);
+  uint32_t mask = ed + md == 31 ? 0xffffffff : (1 << (1 + ed + md)) - 1;
+
+  state.fcsr.fflags.raw = 0;
+  state.fcsr.frm = mode;
+  // Use the dynamic rounding mode half of the time
+  uint32_t result = sf_exec(op, a, b, c, e, m, ed, md, (a ^ b ^ c) & 1 ? 7 : mode) & mask;
+  lib_float_host_release(&state);
+  unsigned int flags = state.fcsr.fflags.raw;
+
+  nb_checks++;
+
+  if (result != expected || flags != exp_flags)
+  {
+    if (nb_errors < 20)
+      printf("Error in %s(%d,%d->%d,%d) mode %d (a: 0x%x, b: 0x%x, c: 0x%x, result: 0x%x, expected: 0x%x, fflags: 0x%x, expected: 0x%x)\n",
+        op_names[op], e, m, ed, md, mode, a, b, c, result, expected, flags, exp_flags);
+    nb_errors++;
+  }
+}
+
+static uint32_t random_bits(int e, int m)
+{
+  uint32_t value = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+  return e + m == 31 ? value : value & ((1 << (1 + e + m)) - 1);
+}
+
+// Returns b with its exponent replaced by the one of a, plus or minus a few
+static uint32_t close_exponent(uint32_t a, uint32_t b, int e, int m)
+{
+  int exp_mask = (1 << e) - 1;
+  int exp = ((a >> m) & exp_mask) + rand() % 5 - 2;
+  if (exp < 0)
+    exp = 0;
+  if (exp >= exp_mask)
+    exp = exp_mask - 1;
+  return (b & ~(exp_mask << m)) | (exp << m);
+}
+
+// Checks all the pairs of f8 operands, which is what the f8 tables contain
+static void check_f8_full()
+{
+  for (int mode=0; mode<4; mode++)
+  {
+    for (uint32_t a=0; a<256; a++)
+    {
+      for (uint32_t b=0; b<256; b++)
+      {
+        check(OP_ADD, a, b, 0, 5, 2, 5, 2, mode);
+        check(OP_SUB, a, b, 0, 5, 2, 5, 2, mode);
+        check(OP_MUL, a, b, 0, 5, 2, 5, 2, mode);
+        check(OP_DIV, a, b, 0, 5, 2, 5, 2, mode);
+        // The addend is random, with a close exponent half of the time
+        uint32_t c = random_bits(5, 2);
+        if (rand() & 1)
+          c = close_exponent(a, c, 5, 2);
+        check((op_e)(OP_MADD + (a + b) % 4), a, b, c, 5, 2, 5, 2, mode);
+      }
+    }
+  }
+}
+
+// Checks all the values of a format for the unary operations
+static void check_unary_full(int e, int m)
+{
+  for (int mode=0; mode<4; mode++)
+  {
+    for (uint32_t a=0; a<(1U << (1 + e + m)); a++)
+    {
+      check(OP_SQRT, a, 0, 0, e, m, e, m, mode);
+      for (int f=0; f<NB_FORMATS; f++)
+      {
+        const format_t *format = &formats[f];
+        if (format->e != e || format->m != m)
+          check(OP_CVT, a, 0, 0, e, m, format->e, format->m, mode);
+      }
+    }
+  }
+}
+
+static void check_random(int e, int m)
+{
+  for (int mode=0; mode<4; mode++)
+  {
+    for (int i=0; i<RANDOM_ITER; i++)
+    {
+      uint32_t a = random_bits(e, m), b = random_bits(e, m), c = random_bits(e, m);
+      if (i & 1)
+        b = close_exponent(a, b, e, m);
+      if (i & 2)
+        c = close_exponent(a, c, e, m);
+
+      for (int op=OP_ADD; op<=OP_NMSUB; op++)
+      {
+        if (op != OP_SQRT)
+          check((op_e)op, a, b, c, e, m, e, m, mode);
+      }
+    }
+  }
+}
+
+// Conversions from binary32 to the small formats
+static void check_from_float32()
+{
+  for (int mode=0; mode<4; mode++)
+  {
+    for (int i=0; i<RANDOM_ITER; i++)
+    {
+      uint32_t a = random_bits(8, 23);
+      // Keep exponents close to the ranges of the small formats most of the
+      // time
+      if (i & 3)
+        a = (a & 0x807fffff) | ((uint32_t)(127 - 40 + rand() % 80) << 23);
+      for (int f=0; f<NB_SMALL_FORMATS; f++)
+        check(OP_CVT, a, 0, 0, 8, 23, formats[f].e, formats[f].m, mode);
+    }
+  }
+}
+
+int main()
+{
+  srand(1);
+
+  lib_sf_init(true, true);
+
+  check_f8_full();
+
+  for (int f=0; f<NB_SMALL_FORMATS; f++)
+  {
+    check_unary_full(formats[f].e, formats[f].m);
+    check_random(formats[f].e, formats[f].m);
+  }
+
+  check_from_float32();
+
+  if (nb_errors)
+  {
+    printf("Got %d errors out of %ld checks\n", nb_errors, nb_checks);
+    return -1;
+  }
+
+  printf("All %ld checks passed\n", nb_checks);
+  return 0;
+}
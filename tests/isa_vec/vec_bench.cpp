@@ -0,0 +1,503 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Runs the handlers of the packed-SIMD instructions on random operands and
+// checks them against the implementations they had before isa_lib/vec.h, and
+// reports the number of operations per second of both.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "iss.hpp"
+
+#define CHECK_ITER 1000000
+#define BENCH_ITER 10000000
+
+#define REG_RS1 10
+#define REG_RS2 11
+#define REG_RD  12
+
+typedef iss_insn_t *(handler_t)(iss_t *iss, iss_insn_t *insn);
+typedef uint32_t (ref_t)(uint32_t a, uint32_t b, uint32_t c);
+
+typedef enum {
+  IMM_NONE,
+  IMM_SIGNED,
+  IMM_UNSIGNED
+} imm_e;
+
+typedef struct
+{
+  const char *name;
+  handler_t *handler;
+  ref_t *ref;
+  // For the instructions using an immediate instead of rs2
+  imm_e imm;
+} insn_bench_t;
+
+// Only the register file and the state of the core are used by the handlers,
+// so the core is not constructed
+alignas(iss_t) static char iss_storage[sizeof(iss_t)];
+static iss_t *iss = (iss_t *)iss_storage;
+static iss_insn_t insn;
+
+static uint64_t rand_state = 0x9e3779b97f4a7c15;
+
+static uint32_t rand_u32()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return (uint32_t)rand_state;
+}
+
+// Mix fully random operands with corner cases, like elements at their minimum
+// value or small ones used as shift amounts and indexes
+static uint32_t rand_operand()
+{
+  uint32_t value = rand_u32();
+  switch (rand_u32() & 3)
+  {
+    case 0: return value;
+    case 1: return value | 0x80808080;
+    case 2: return 0x80008000;
+    default: return value & 0x0f0f0f0f;
+  }
+}
+
+/*
+ * Implementations of the operations in isa_lib/int.h before they were moved to
+ * vec.h, used as reference so that the handlers are not checked against
+ * themselves
+ */
+
+#define REF_VEC_OP(operName, type, elemType, elemSize, num_elem, oper)                \
+static inline type ref_VEC_##operName##_##elemType##_to_##type(type a, type b) {  \
+  elemType *tmp_a = (elemType*)&a;                                                \
+  elemType *tmp_b = (elemType*)&b;                                                \
+  type out;                                                                       \
+  elemType *tmp_out = (elemType*)&out;                                            \
+  int i;                                                                          \
+  for (i = 0; i < num_elem; i++)                                                  \
+    tmp_out[i] = tmp_a[i] oper tmp_b[i];                                          \
+  return out;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline type ref_VEC_##operName##_SC_##elemType##_to_##type(type a, elemType b) { \
+  elemType *tmp_a = (elemType*)&a;                                                      \
+  type out;                                                                             \
+  elemType *tmp_out = (elemType*)&out;                                                  \
+  int i;                                                                                \
+  for (i = 0; i < num_elem; i++)                                                        \
+    tmp_out[i] = tmp_a[i] oper b;                                                       \
+  return out;                                                                           \
+}
+
+#define REF_VEC_OP_DIV2(operName, type, elemType, elemSize, num_elem, oper)                \
+static inline type ref_VEC_##operName##_##elemType##_to_##type##_div2(type a, type b) {  \
+  elemType *tmp_a = (elemType*)&a;                                                \
+  elemType *tmp_b = (elemType*)&b;                                                \
+  type out;                                                                       \
+  elemType *tmp_out = (elemType*)&out;                                            \
+  int i;                                                                          \
+  for (i = 0; i < num_elem; i++)                                                  \
+    tmp_out[i] = ((elemType)(tmp_a[i] oper tmp_b[i]))>>1;                         \
+  return out;                                                                     \
+}
+
+#define REF_VEC_OP_DIV4(operName, type, elemType, elemSize, num_elem, oper)                \
+static inline type ref_VEC_##operName##_##elemType##_to_##type##_div4(type a, type b) {  \
+  elemType *tmp_a = (elemType*)&a;                                                \
+  elemType *tmp_b = (elemType*)&b;                                                \
+  type out;                                                                       \
+  elemType *tmp_out = (elemType*)&out;                                            \
+  int i;                                                                          \
+  for (i = 0; i < num_elem; i++)                                                  \
+    tmp_out[i] = ((elemType)(tmp_a[i] oper tmp_b[i]))>>2;                         \
+  return out;                                                                     \
+}
+
+#define REF_VEC_EXPR(operName, type, elemType, elemSize, num_elem, expr)                \
+static inline type ref_VEC_##operName##_##elemType##_to_##type(type a, type b) {  \
+  elemType *tmp_a = (elemType*)&a;                                                \
+  elemType *tmp_b = (elemType*)&b;                                                \
+  type out;                                                                       \
+  elemType *tmp_out = (elemType*)&out;                                            \
+  int i;                                                                          \
+  for (i = 0; i < num_elem; i++)                                                  \
+    tmp_out[i] = expr;                                                            \
+  return out;                                                                     \
+}
+
+#define REF_VEC_EXPR_SC(operName, type, elemType, elemSize, num_elem, expr)                \
+static inline type ref_VEC_##operName##_SC_##elemType##_to_##type(type a, elemType b) { \
+  elemType *tmp_a = (elemType*)&a;                                                      \
+  type out;                                                                             \
+  elemType *tmp_out = (elemType*)&out;                                                  \
+  int i;                                                                                \
+  for (i = 0; i < num_elem; i++)                                                        \
+    tmp_out[i] = expr;                                                                  \
+  return out;                                                                           \
+}
+
+REF_VEC_OP(ADD, int32_t, int8_t, 1, 4, +)
+REF_VEC_OP_DIV2(ADD, int32_t, int8_t, 1, 4, +)
+REF_VEC_OP_DIV4(ADD, int32_t, int8_t, 1, 4, +)
+REF_VEC_OP(ADD, int32_t, int16_t, 2, 2, +)
+REF_VEC_OP_DIV2(ADD, int32_t, int16_t, 2, 2, +)
+REF_VEC_OP_DIV4(ADD, int32_t, int16_t, 2, 2, +)
+
+REF_VEC_OP(SUB, int32_t, int8_t, 1, 4, -)
+REF_VEC_OP_DIV2(SUB, int32_t, int8_t, 1, 4, -)
+REF_VEC_OP_DIV4(SUB, int32_t, int8_t, 1, 4, -)
+REF_VEC_OP(SUB, int32_t, int16_t, 2, 2, -)
+REF_VEC_OP_DIV2(SUB, int32_t, int16_t, 2, 2, -)
+REF_VEC_OP_DIV4(SUB, int32_t, int16_t, 2, 2, -)
+
+REF_VEC_EXPR(AVG, int32_t, int8_t, 1, 4, ((int8_t)(tmp_a[i] + tmp_b[i])>>(int8_t)1))
+REF_VEC_EXPR(AVG, int32_t, int16_t, 2, 2, ((int16_t)(tmp_a[i] + tmp_b[i])>>(int16_t)1))
+REF_VEC_EXPR_SC(AVG, int32_t, int8_t, 1, 4, ((int8_t)(tmp_a[i] + b)>>(int8_t)1))
+REF_VEC_EXPR_SC(AVG, int32_t, int16_t, 2, 2, ((int16_t)(tmp_a[i] + b)>>(int16_t)1))
+
+REF_VEC_EXPR(AVGU, uint32_t, uint8_t, 1, 4, ((uint8_t)(tmp_a[i] + tmp_b[i])>>(uint8_t)1))
+REF_VEC_EXPR(AVGU, uint32_t, uint16_t, 2, 2, ((uint16_t)(tmp_a[i] + tmp_b[i])>>(uint16_t)1))
+REF_VEC_EXPR_SC(AVGU, uint32_t, uint8_t, 1, 4, ((uint8_t)(tmp_a[i] + b)>>(uint8_t)1))
+REF_VEC_EXPR_SC(AVGU, uint32_t, uint16_t, 2, 2, ((uint16_t)(tmp_a[i] + b)>>(uint16_t)1))
+
+REF_VEC_EXPR(MIN, int32_t, int8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
+REF_VEC_EXPR(MIN, int32_t, int16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
+REF_VEC_EXPR_SC(MIN, int32_t, int8_t, 1, 4, (tmp_a[i]>b ? b : tmp_a[i]))
+REF_VEC_EXPR_SC(MIN, int32_t, int16_t, 2, 2, (tmp_a[i]>b ? b : tmp_a[i]))
+
+REF_VEC_EXPR(MINU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
+REF_VEC_EXPR(MINU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_b[i] : tmp_a[i]))
+REF_VEC_EXPR_SC(MINU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>b ? b : tmp_a[i]))
+REF_VEC_EXPR_SC(MINU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>b ? b : tmp_a[i]))
+
+REF_VEC_EXPR(MAX, int32_t, int8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
+REF_VEC_EXPR(MAX, int32_t, int16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
+REF_VEC_EXPR_SC(MAX, int32_t, int8_t, 1, 4, (tmp_a[i]>b ? tmp_a[i] : b))
+REF_VEC_EXPR_SC(MAX, int32_t, int16_t, 2, 2, (tmp_a[i]>b ? tmp_a[i] : b))
+
+REF_VEC_EXPR(MAXU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
+REF_VEC_EXPR(MAXU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>tmp_b[i] ? tmp_a[i] : tmp_b[i]))
+REF_VEC_EXPR_SC(MAXU, uint32_t, uint8_t, 1, 4, (tmp_a[i]>b ? tmp_a[i] : b))
+REF_VEC_EXPR_SC(MAXU, uint32_t, uint16_t, 2, 2, (tmp_a[i]>b ? tmp_a[i] : b))
+
+REF_VEC_EXPR(SRL, uint32_t, uint8_t, 1, 4, (tmp_a[i] >> (tmp_b[i] & 0x7)))
+REF_VEC_EXPR_SC(SRL, uint32_t, uint8_t, 1, 4, (tmp_a[i] >> (b & 0x7)))
+REF_VEC_EXPR(SRL, uint32_t, uint16_t, 1, 2, (tmp_a[i] >> (tmp_b[i] & 0xF)))
+REF_VEC_EXPR_SC(SRL, uint32_t, uint16_t, 1, 2, (tmp_a[i] >> (b & 0xF)))
+
+REF_VEC_EXPR(SRA, int32_t, int8_t, 1, 4, (tmp_a[i] >> (tmp_b[i] & 0x7)))
+REF_VEC_EXPR_SC(SRA, int32_t, int8_t, 1, 4, (tmp_a[i] >> (b & 0x7)))
+REF_VEC_EXPR(SRA, int32_t, int16_t, 1, 2, (tmp_a[i] >> (tmp_b[i] & 0xF)))
+REF_VEC_EXPR_SC(SRA, int32_t, int16_t, 1, 2, (tmp_a[i] >> (b & 0xF)))
+
+REF_VEC_EXPR(SLL, uint32_t, uint8_t, 1, 4, (tmp_a[i] << (tmp_b[i] & 0x7)))
+REF_VEC_EXPR_SC(SLL, uint32_t, uint8_t, 1, 4, (tmp_a[i] << (b & 0x7)))
+REF_VEC_EXPR(SLL, uint32_t, uint16_t, 1, 2, (tmp_a[i] << (tmp_b[i] & 0xF)))
+REF_VEC_EXPR_SC(SLL, uint32_t, uint16_t, 1, 2, (tmp_a[i] << (b & 0xF)))
+
+static inline unsigned int refShuffleHalf(unsigned int a, unsigned int b, unsigned int pos) {
+  unsigned int shift = ((b>>pos)&1) << 4;
+  return ((a >> shift) & 0xffff) << pos;
+}
+
+static inline unsigned int refShuffleByte(unsigned int a, unsigned int b, unsigned int pos) {
+  unsigned int shift = ((b>>pos)&0x3) << 3;
+  return ((a >> shift) & 0xff) << pos;
+}
+
+static inline unsigned int ref_VEC_SHUFFLE_16(unsigned int a, unsigned int b) {
+  return refShuffleHalf(a, b, 16) | refShuffleHalf(a, b, 0);
+}
+
+static inline unsigned int ref_VEC_SHUFFLE_8(unsigned int a, unsigned int b) {
+  return refShuffleByte(a, b, 24) | refShuffleByte(a, b, 16) | refShuffleByte(a, b, 8) | refShuffleByte(a, b, 0);
+}
+
+static inline unsigned int ref_VEC_SHUFFLE2_16(unsigned int a, unsigned int b, unsigned int c) {
+#ifdef RISCV
+  return refShuffleHalf(b&(1<<17)?a:c, b, 16) | refShuffleHalf(b&(1<<1)?a:c, b, 0);
+#else
+  return refShuffleHalf(b&(1<<17)?c:a, b, 16) | refShuffleHalf(b&(1<<1)?c:a, b, 0);
+#endif
+}
+
+static inline unsigned int ref_VEC_SHUFFLE2_8(unsigned int a, unsigned int b, unsigned int c) {
+#ifdef RISCV
+  return refShuffleByte(b&(1<<26)?a:c, b, 24) | refShuffleByte(b&(1<<18)?a:c, b, 16) | refShuffleByte(b&(1<<10)?a:c, b, 8) | refShuffleByte(b&(1<<2)?a:c, b, 0);
+#else
+  return refShuffleByte(b&(1<<26)?c:a, b, 24) | refShuffleByte(b&(1<<18)?c:a, b, 16) | refShuffleByte(b&(1<<10)?c:a, b, 8) | refShuffleByte(b&(1<<2)?c:a, b, 0);
+#endif
+}
+
+// The products are done on 32 bits unsigned values, as the old int arithmetic
+// wrapped around on the hosts the model runs on
+#define REF_VEC_DOTP(operName, typeOut, typeA, typeB, elemTypeA, elemTypeB, elemSize, num_elem, oper)                \
+static inline typeOut ref_VEC_##operName##_##elemSize(typeA a, typeB b) {  \
+  elemTypeA *tmp_a = (elemTypeA*)&a;                                                \
+  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
+  typeOut out = 0;                                                                       \
+  int i;                                                                          \
+  for (i = 0; i < num_elem; i++)                                                  \
+    out += (uint32_t)tmp_a[i] oper (uint32_t)tmp_b[i];                                          \
+  return out;                                                                     \
+}                                                                                 \
+                                                                                  \
+static inline typeOut ref_VEC_##operName##_SC_##elemSize(typeA a, typeB b) { \
+  elemTypeA *tmp_a = (elemTypeA*)&a;                                                      \
+  elemTypeB *tmp_b = (elemTypeB*)&b;                                                \
+  typeOut out = 0;                                                                             \
+  int i;                                                                                \
+  for (i = 0; i < num_elem; i++)                                                        \
+    out += (uint32_t)tmp_a[i] oper (uint32_t)tmp_b[0];                                                       \
+  return out;                                                                           \
+}
+
+REF_VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, int16_t, int16_t, 16, 2, *)
+REF_VEC_DOTP(DOTSP, int32_t, int32_t, int32_t, int8_t, int8_t, 8, 4, *)
+
+REF_VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t, 16, 2, *)
+REF_VEC_DOTP(DOTUP, uint32_t, uint32_t, uint32_t, uint8_t, uint8_t, 8, 4, *)
+
+REF_VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, uint16_t, int16_t, 16, 2, *)
+REF_VEC_DOTP(DOTUSP, int32_t, uint32_t, int32_t, uint8_t, int8_t, 8, 4, *)
+
+// Same on the signature of the bench, for the operation on both registers,
+// and on the first register and the second one or the immediate
+#define REF_OP(insn, operName, type8, elemType8, type16, elemType16)                                              \
+static uint32_t ref_##insn##_8(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_##elemType8##_to_##type8(a, b); } \
+static uint32_t ref_##insn##_8_sc(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_SC_##elemType8##_to_##type8(a, b); } \
+static uint32_t ref_##insn##_16(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_##elemType16##_to_##type16(a, b); } \
+static uint32_t ref_##insn##_16_sc(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_SC_##elemType16##_to_##type16(a, b); }
+
+#define REF_DOTP(insn, operName)                                                                             \
+static uint32_t ref_##insn##_8(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_8(a, b); }           \
+static uint32_t ref_##insn##_8_sc(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_SC_8(a, b); }     \
+static uint32_t ref_##insn##_16(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_16(a, b); }         \
+static uint32_t ref_##insn##_16_sc(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_SC_16(a, b); }
+
+// The dot products accumulating into rd
+#define REF_SDOTP(insn, operName)                                                                            \
+static uint32_t ref_##insn##_8(uint32_t a, uint32_t b, uint32_t c) { return c + ref_VEC_##operName##_8(a, b); }       \
+static uint32_t ref_##insn##_8_sc(uint32_t a, uint32_t b, uint32_t c) { return c + ref_VEC_##operName##_SC_8(a, b); } \
+static uint32_t ref_##insn##_16(uint32_t a, uint32_t b, uint32_t c) { return c + ref_VEC_##operName##_16(a, b); }     \
+static uint32_t ref_##insn##_16_sc(uint32_t a, uint32_t b, uint32_t c) { return c + ref_VEC_##operName##_SC_16(a, b); }
+
+#define REF_DIV(insn, operName, type, elemType, div)                                                        \
+static uint32_t ref_##insn(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_##operName##_##elemType##_to_##type##_div##div(a, b); }
+
+REF_OP(add, ADD, int32_t, int8_t, int32_t, int16_t)
+REF_OP(sub, SUB, int32_t, int8_t, int32_t, int16_t)
+REF_OP(avg, AVG, int32_t, int8_t, int32_t, int16_t)
+REF_OP(avgu, AVGU, uint32_t, uint8_t, uint32_t, uint16_t)
+REF_OP(min, MIN, int32_t, int8_t, int32_t, int16_t)
+REF_OP(minu, MINU, uint32_t, uint8_t, uint32_t, uint16_t)
+REF_OP(max, MAX, int32_t, int8_t, int32_t, int16_t)
+REF_OP(maxu, MAXU, uint32_t, uint8_t, uint32_t, uint16_t)
+REF_OP(srl, SRL, uint32_t, uint8_t, uint32_t, uint16_t)
+REF_OP(sra, SRA, int32_t, int8_t, int32_t, int16_t)
+REF_OP(sll, SLL, uint32_t, uint8_t, uint32_t, uint16_t)
+
+REF_DOTP(dotsp, DOTSP)
+REF_DOTP(dotup, DOTUP)
+REF_DOTP(dotusp, DOTUSP)
+REF_SDOTP(sdotsp, DOTSP)
+REF_SDOTP(sdotup, DOTUP)
+REF_SDOTP(sdotusp, DOTUSP)
+
+REF_DIV(add_div2_8, ADD, int32_t, int8_t, 2)
+REF_DIV(add_div4_8, ADD, int32_t, int8_t, 4)
+REF_DIV(add_div2_16, ADD, int32_t, int16_t, 2)
+REF_DIV(add_div4_16, ADD, int32_t, int16_t, 4)
+REF_DIV(sub_div2_8, SUB, int32_t, int8_t, 2)
+REF_DIV(sub_div4_8, SUB, int32_t, int8_t, 4)
+REF_DIV(sub_div2_16, SUB, int32_t, int16_t, 2)
+REF_DIV(sub_div4_16, SUB, int32_t, int16_t, 4)
+
+static uint32_t ref_shuffle_8(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_SHUFFLE_8(a, b); }
+static uint32_t ref_shuffle_16(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_SHUFFLE_16(a, b); }
+static uint32_t ref_shuffle2_8(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_SHUFFLE2_8(a, b, c); }
+static uint32_t ref_shuffle2_16(uint32_t a, uint32_t b, uint32_t c) { return ref_VEC_SHUFFLE2_16(a, b, c); }
+
+// Instructions with a register, scalar and immediate version
+#define INSN_OP(insn, imm)                                                                       \
+  { "pv." #insn ".h", pv_##insn##_h_exec, ref_##insn##_16, IMM_NONE },                           \
+  { "pv." #insn ".sc.h", pv_##insn##_sc_h_exec, ref_##insn##_16_sc, IMM_NONE },                  \
+  { "pv." #insn ".sci.h", pv_##insn##_sci_h_exec, ref_##insn##_16_sc, imm },                     \
+  { "pv." #insn ".b", pv_##insn##_b_exec, ref_##insn##_8, IMM_NONE },                            \
+  { "pv." #insn ".sc.b", pv_##insn##_sc_b_exec, ref_##insn##_8_sc, IMM_NONE },                   \
+  { "pv." #insn ".sci.b", pv_##insn##_sci_b_exec, ref_##insn##_8_sc, imm }
+
+#define INSN_DOTP(insn, imm)                                                                     \
+  { "pv." #insn ".h", pv_##insn##_h_exec, ref_##insn##_16, IMM_NONE },                           \
+  { "pv." #insn ".sc.h", pv_##insn##_h_sc_exec, ref_##insn##_16_sc, IMM_NONE },                  \
+  { "pv." #insn ".sci.h", pv_##insn##_h_sci_exec, ref_##insn##_16_sc, imm },                     \
+  { "pv." #insn ".b", pv_##insn##_b_exec, ref_##insn##_8, IMM_NONE },                            \
+  { "pv." #insn ".sc.b", pv_##insn##_b_sc_exec, ref_##insn##_8_sc, IMM_NONE },                   \
+  { "pv." #insn ".sci.b", pv_##insn##_b_sci_exec, ref_##insn##_8_sc, imm }
+
+#define INSN_SDOTP(insn)                                                                         \
+  { "pv." #insn ".h", pv_##insn##_h_exec, ref_##insn##_16, IMM_NONE },                           \
+  { "pv." #insn ".sc.h", pv_##insn##_h_sc_exec, ref_##insn##_16_sc, IMM_NONE },                  \
+  { "pv." #insn ".b", pv_##insn##_b_exec, ref_##insn##_8, IMM_NONE },                            \
+  { "pv." #insn ".sc.b", pv_##insn##_b_sc_exec, ref_##insn##_8_sc, IMM_NONE }
+
+static insn_bench_t benchs[] = {
+  INSN_OP(add, IMM_SIGNED),
+  INSN_OP(sub, IMM_SIGNED),
+  INSN_OP(avg, IMM_SIGNED),
+  INSN_OP(avgu, IMM_UNSIGNED),
+  INSN_OP(min, IMM_SIGNED),
+  INSN_OP(minu, IMM_UNSIGNED),
+  INSN_OP(max, IMM_SIGNED),
+  INSN_OP(maxu, IMM_UNSIGNED),
+  INSN_OP(srl, IMM_UNSIGNED),
+  INSN_OP(sra, IMM_SIGNED),
+  INSN_OP(sll, IMM_UNSIGNED),
+  INSN_DOTP(dotsp, IMM_SIGNED),
+  INSN_DOTP(dotup, IMM_UNSIGNED),
+  INSN_DOTP(dotusp, IMM_SIGNED),
+  INSN_SDOTP(sdotsp),
+  INSN_SDOTP(sdotup),
+  INSN_SDOTP(sdotusp),
+  { "pv.shuffle.h", pv_shuffle_h_exec, ref_shuffle_16, IMM_NONE },
+  { "pv.shuffle.b", pv_shuffle_b_exec, ref_shuffle_8, IMM_NONE },
+  { "pv.shuffle2.h", pv_shuffle2_h_exec, ref_shuffle2_16, IMM_NONE },
+  { "pv.shuffle2.b", pv_shuffle2_b_exec, ref_shuffle2_8, IMM_NONE },
+  // Gap8 versions dividing the result
+  { "pv.add.b.div2", lib_VEC_ADD_8_DIV2_exec, ref_add_div2_8, IMM_NONE },
+  { "pv.add.b.div4", lib_VEC_ADD_8_DIV4_exec, ref_add_div4_8, IMM_NONE },
+  { "pv.add.h.div2", lib_VEC_ADD_16_DIV2_exec, ref_add_div2_16, IMM_NONE },
+  { "pv.add.h.div4", lib_VEC_ADD_16_DIV4_exec, ref_add_div4_16, IMM_NONE },
+  { "pv.sub.b.div2", lib_VEC_SUB_8_DIV2_exec, ref_sub_div2_8, IMM_NONE },
+  { "pv.sub.b.div4", lib_VEC_SUB_8_DIV4_exec, ref_sub_div4_8, IMM_NONE },
+  { "pv.sub.h.div2", lib_VEC_SUB_16_DIV2_exec, ref_sub_div2_16, IMM_NONE },
+  { "pv.sub.h.div4", lib_VEC_SUB_16_DIV4_exec, ref_sub_div4_16, IMM_NONE },
+};
+
+// Sets the operands of the instruction and returns the value seen by the
+// reference for the second one
+static uint32_t set_operands(insn_bench_t *bench, uint32_t a, uint32_t b, uint32_t c)
+{
+  iss->cpu.regfile.regs[REG_RS1] = a;
+  iss->cpu.regfile.regs[REG_RS2] = b;
+  iss->cpu.regfile.regs[REG_RD] = c;
+
+  // Immediates are 6 bits, sign-extended or not
+  if (bench->imm == IMM_SIGNED)
+  {
+    insn.sim[0] = ((int32_t)(b << 26)) >> 26;
+    return insn.sim[0];
+  }
+  else if (bench->imm == IMM_UNSIGNED)
+  {
+    insn.uim[0] = b & 0x3f;
+    return insn.uim[0];
+  }
+
+  return b;
+}
+
+static int check(insn_bench_t *bench)
+{
+  for (int i=0; i<CHECK_ITER; i++)
+  {
+    uint32_t a = rand_operand(), b = rand_operand(), c = rand_operand();
+    uint32_t op_b = set_operands(bench, a, b, c);
+    uint32_t expected = bench->ref(a, op_b, c);
+    bench->handler(iss, &insn);
+    uint32_t result = iss->cpu.regfile.regs[REG_RD];
+    if (result != expected)
+    {
+      printf("%s: mismatch (rs1: 0x%8.8x, rs2/imm: 0x%8.8x, rd: 0x%8.8x, expected: 0x%8.8x, got: 0x%8.8x)\n",
+        bench->name, a, op_b, c, expected, result);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Results are chained through the register file so that the operations
+// cannot be removed or overlapped
+static double bench_handler(insn_bench_t *bench)
+{
+  set_operands(bench, rand_u32(), rand_u32(), rand_u32());
+  iss_reg_t *regs = iss->cpu.regfile.regs;
+
+  clock_t start = ::clock();
+  for (int i=0; i<BENCH_ITER; i++)
+  {
+    bench->handler(iss, &insn);
+    regs[REG_RS1] = regs[REG_RD] ^ i;
+  }
+  clock_t end = ::clock();
+
+  double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
+  return BENCH_ITER / time_elapsed_in_seconds / 1000000;
+}
+
+static double bench_ref(insn_bench_t *bench)
+{
+  uint32_t b = set_operands(bench, rand_u32(), rand_u32(), rand_u32());
+  iss_reg_t *regs = iss->cpu.regfile.regs;
+
+  clock_t start = ::clock();
+  for (int i=0; i<BENCH_ITER; i++)
+  {
+    regs[REG_RD] = bench->ref(regs[REG_RS1], b, regs[REG_RD]);
+    regs[REG_RS1] = regs[REG_RD] ^ i;
+  }
+  clock_t end = ::clock();
+
+  double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
+  return BENCH_ITER / time_elapsed_in_seconds / 1000000;
+}
+
+int main()
+{
+  int errors = 0;
+
+  insn.in_regs[0] = REG_RS1;
+  insn.in_regs[1] = REG_RS2;
+  insn.in_regs[2] = REG_RD;
+  insn.out_regs[0] = REG_RD;
+
+#if defined(ISS_VEC_HOST_SIMD)
+  printf("Using host SIMD (SSE4.1) for byte shuffles\n");
+#else
+  printf("Using scalar implementation\n");
+#endif
+
+  for (unsigned int i=0; i<sizeof(benchs)/sizeof(benchs[0]); i++)
+  {
+    insn_bench_t *bench = &benchs[i];
+    errors += check(bench);
+    printf("Benchmarking %s\n", bench->name);
+    printf("%f %f\n", bench_ref(bench), bench_handler(bench));
+  }
+
+  if (errors)
+    printf("Found %d errors\n", errors);
+
+  return errors != 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks the TCDM bank conflict model of the L1 interleaver. All the master
+// ports access the same bank in the same cycle, which must serialize them,
+// then the bank must still be busy in the next cycle, and free again later.
+// Requests queued by a single master in one cycle, as done by cores running
+// ahead with temporal decoupling, must not wait more than one access of each
+// master.
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <vp/itf/wire.hpp>
+#include <stdio.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <vector>
+
+class master : public vp::component
+{
+
+public:
+
+  master(const char *config);
+
+  int build();
+
+  void start();
+
+  static void test(void *_this, vp::clock_event *event);
+
+private:
+
+  int64_t access(int port, int bank, int word);
+  void check(const char *name, int64_t value, int64_t expected);
+
+  vp::trace trace;
+  std::vector<vp::io_master *> out;
+  vp::wire_master<uint32_t> stalls_itf;
+  vp::wire_master<uint32_t> nb_conflicts_itf;
+  vp::clock_event *event;
+  int nb_ports;
+  int nb_banks;
+  int step = 0;
+  int nb_errors = 0;
+};
+
+// Reads a word of the specified bank and returns the latency of the access
+int64_t master::access(int port, int bank, int word)
+{
+  uint32_t data;
+  vp::io_req *req = this->out[port]->req_new((word * this->nb_banks + bank) * 4, (uint8_t *)&data, 4, false);
+
+  if (this->out[port]->req(req) != vp::IO_REQ_OK)
+  {
+    printf("Access failed (port: %d, bank: %d)\n", port, bank);
+    exit(1);
+  }
+
+  int64_t latency = req->get_latency();
+  this->out[port]->req_del(req);
+  return latency;
+}
+
+void master::check(const char *name, int64_t value, int64_t expected)
+{
+  if (value != expected)
+  {
+    printf("%s: got %" PRId64 " instead of %" PRId64 "\n", name, value, expected);
+    this->nb_errors++;
+  }
+}
+
+void master::test(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+  int n = _this->nb_ports;
+
+  switch (_this->step)
+  {
+    case 0:
+    {
+      // Same bank from all ports in the same cycle, each access waits for
+      // the previous ones
+      std::vector<int64_t> latencies;
+      for (int i=0; i<n; i++)
+      {
+        latencies.push_back(_this->access(i, 0, i));
+      }
+      for (int i=0; i<n; i++)
+      {
+        _this->check("Same cycle accesses", latencies[i], i);
+      }
+
+      // Other banks are not impacted
+      _this->check("Other bank access", _this->access(0, 1, 0), 0);
+
+      _this->event_enqueue(event, 1);
+      break;
+    }
+
+    case 1:
+      // The bank is still serving the accesses of the previous cycle
+      _this->check("Next cycle access", _this->access(0, 0, 0), n - 1);
+      _this->check("Next cycle other bank access", _this->access(1, 2, 0), 0);
+
+      _this->event_enqueue(event, 2 * n);
+      break;
+
+    case 2:
+    {
+      // Everything has been served
+      _this->check("Later access", _this->access(0, 0, 0), 0);
+
+      // Many accesses queued from one master in the same cycle
+      for (int i=0; i<3*n; i++)
+      {
+        _this->check("Queued access", _this->access(0, 3, i), std::min(i, n));
+      }
+
+      uint32_t stalls, nb_conflicts;
+      _this->stalls_itf.sync_back(&stalls);
+      _this->nb_conflicts_itf.sync_back(&nb_conflicts);
+      _this->check("Bank stalls", stalls, n * (n - 1) / 2 + n - 1);
+      _this->check("Bank conflicts", nb_conflicts, n);
+
+      if (_this->nb_errors)
+      {
+        printf("Got %d errors\n", _this->nb_errors);
+        exit(1);
+      }
+
+      printf("All checks passed\n");
+      exit(0);
+    }
+  }
+
+  _this->step++;
+}
+
+int master::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  this->nb_ports = get_config_int("nb_ports");
+  this->nb_banks = get_config_int("nb_banks");
+
+  for (int i=0; i<this->nb_ports; i++)
+  {
+    vp::io_master *port = new vp::io_master();
+    this->out.push_back(port);
+    new_master_port("out_" + std::to_string(i), port);
+  }
+
+  new_master_port("stalls", &stalls_itf);
+  new_master_port("nb_conflicts", &nb_conflicts_itf);
+
+  return 0;
+}
+
+void master::start()
+{
+  this->event = event_new(master::test);
+  event_enqueue(this->event, 1);
+}
+
+
+master::master(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new master(config);
+}
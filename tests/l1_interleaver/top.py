@@ -0,0 +1,48 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ 
+import vp_core as vp
+
+# Several master ports of the same component are connected to the TCDM
+# interleaver, so that they can access the same bank in the same cycle.
+
+class component(vp.component):
+
+    def build(self):
+
+        clock = self.new('clock', component='vp/clock_domain', config=self.get_config().get_config('clock_domain'))
+
+        interleaver_config = self.get_config().get_config('interleaver')
+
+        interleaver = self.new('interleaver', component='pulp/cluster/l1_interleaver', config=interleaver_config)
+
+        master = self.new('master', component='master', config=self.get_config().get_config('master'))
+
+        clock.get_port('out').bind_to(interleaver.get_port('clock'))
+        clock.get_port('out').bind_to(master.get_port('clock'))
+
+        for i in range(0, interleaver_config.get_config('nb_masters').get_int()):
+            master.get_port('out_%d' % i).bind_to(interleaver.get_port('in_%d' % i))
+
+        for i in range(0, interleaver_config.get_config('nb_slaves').get_int()):
+            bank = self.new('bank_%d' % i, component='slave', config=self.get_config().get_config('bank'))
+            clock.get_port('out').bind_to(bank.get_port('clock'))
+            interleaver.get_port('out_%d' % i).bind_to(bank.get_port('in'))
+
+        master.get_port('stalls').bind_to(interleaver.get_port('stalls[0]'))
+        master.get_port('nb_conflicts').bind_to(interleaver.get_port('nb_conflicts[0]'))
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks the host storage of the memories (vp/mem_backing.hpp): lazy filling
+// with the initial pattern, the tracking of written bytes, copies of the
+// content, populating many chunks, and the preload and writeback files.
+
+#include <vp/mem_backing.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#define FILL 0x57
+
+static int nb_errors = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) \
+    { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      nb_errors++; \
+    } \
+  } while(0)
+
+// Resident host memory of the process, in bytes
+static uint64_t get_rss()
+{
+  long size, resident = 0;
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (file)
+  {
+    if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+      resident = 0;
+    fclose(file);
+  }
+  return (uint64_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+static void test_lazy_fill()
+{
+  uint64_t size = 4ULL << 30;
+  uint64_t rss = get_rss();
+  vp::mem_backing backing;
+
+  CHECK(backing.init(size, FILL) == 0);
+  uint8_t *data = backing.get_data();
+
+  // The memory must not rely on trapping faults
+  struct sigaction action;
+  CHECK(sigaction(SIGSEGV, NULL, &action) == 0 && action.sa_handler == SIG_DFL);
+
+  // Areas which are not populated read as zero
+  CHECK(data[size / 4] == 0);
+
+  // Only the populated chunks take host memory
+  backing.populate(0, 1);
+  backing.populate(size / 2 - 1, 3);
+  backing.populate(size / 2 + 12345, 1);
+  backing.populate(size - 1, 1);
+  CHECK(data[0] == FILL);
+  CHECK(data[size / 2 + 12345] == FILL);
+  CHECK(data[size - 1] == FILL);
+  CHECK(get_rss() - rss < 64ULL << 20);
+
+  data[size / 2] = 3;
+  CHECK(data[size / 2] == 3);
+  CHECK(data[size / 2 + 1] == FILL);
+  CHECK(data[size / 2 - 1] == FILL);
+
+  // Several threads touching the same chunks must all see the pattern before
+  // their own writes
+  std::vector<std::thread> threads;
+  for (int i=0; i<8; i++)
+  {
+    threads.emplace_back([&backing, data, i] {
+      for (int j=0; j<1000; j++)
+      {
+        uint64_t offset = (1ULL << 30) + j * 40000 + i;
+        backing.populate(offset, 1);
+        data[offset] = i + 1;
+      }
+    });
+  }
+  for (auto &thread: threads)
+    thread.join();
+
+  for (int i=0; i<8; i++)
+  {
+    for (int j=0; j<1000; j++)
+      CHECK(data[(1ULL << 30) + j * 40000 + i] == i + 1);
+  }
+  CHECK(data[(1ULL << 30) + 8] == FILL);
+
+  // Populated areas can be given to system calls, and so can the ones which
+  // are not, as they are plain anonymous memory
+  backing.populate(size - 100, 100);
+  FILE *file = fopen("/proc/self/statm", "r");
+  CHECK(file != NULL);
+  CHECK(fread(data + size - 100, 1, 10, file) > 0);
+  CHECK(fseek(file, 0, SEEK_SET) == 0);
+  CHECK(fread(data + size / 4, 1, 10, file) > 0);
+  fclose(file);
+
+  // Direct accesses are limited to the populated chunk
+  uint64_t base, area_size;
+  backing.populate_area(size / 2, &base, &area_size);
+  CHECK(base <= size / 2 && base + area_size > size / 2);
+  CHECK(area_size < size);
+}
+
+static void test_small()
+{
+  vp::mem_backing backing;
+  CHECK(backing.init(4096, 0x12) == 0);
+  CHECK(backing.get_data()[0] == 0x12 && backing.get_data()[4095] == 0x12);
+
+  // Lazy allocation disabled
+  vp::mem_backing eager;
+  CHECK(eager.init(16 << 20, 0x34, false, vp::mem_backing::HUGE_PAGES_NONE, 0) == 0);
+  CHECK(eager.get_data()[(16 << 20) - 1] == 0x34);
+}
+
+static void test_check()
+{
+  vp::mem_backing backing;
+  CHECK(backing.init(1 << 20, FILL, true) == 0);
+  CHECK(backing.has_check());
+
+  CHECK(!backing.check_is_set(100, 10));
+  backing.check_set(100, 200);
+  CHECK(backing.check_is_set(100, 200));
+  CHECK(backing.check_is_set(163, 64));
+  CHECK(backing.check_is_set(299, 1));
+  CHECK(!backing.check_is_set(99, 2));
+  CHECK(!backing.check_is_set(299, 2));
+
+  // Word boundaries
+  backing.check_set(1024, 64);
+  CHECK(backing.check_is_set(1024, 64));
+  CHECK(!backing.check_is_set(1023, 1));
+  CHECK(!backing.check_is_set(1088, 1));
+
+  vp::mem_backing no_check;
+  CHECK(no_check.init(4096) == 0);
+  CHECK(!no_check.has_check());
+}
+
+static void test_copy_to()
+{
+  uint64_t size = (8 << 20) + 100;
+  vp::mem_backing backing;
+  uint8_t *copy = new uint8_t[size];
+
+  CHECK(backing.init(size, FILL, false, vp::mem_backing::HUGE_PAGES_NONE, 1 << 16) == 0);
+  uint8_t *data = backing.get_data();
+  backing.populate(70000, 1);
+  data[70000] = 9;
+  backing.populate(size - 1, 1);
+  data[size - 1] = 10;
+
+  uint64_t rss = get_rss();
+  backing.copy_to(copy);
+
+  // The chunks which are not populated are copied from the pattern, without
+  // being populated
+  CHECK(get_rss() - rss < (size + (1 << 20)));
+  CHECK(copy[70000] == 9);
+  CHECK(copy[size - 1] == 10);
+  CHECK(copy[0] == FILL && copy[69999] == FILL && copy[4 << 20] == FILL);
+
+  int diffs = 0;
+  for (uint64_t i=0; i<size; i++)
+  {
+    if (copy[i] != (i == 70000 ? 9 : i == size - 1 ? 10 : FILL))
+      diffs++;
+  }
+  CHECK(diffs == 0);
+
+  delete[] copy;
+}
+
+// Populating every other chunk of a big memory must not depend on host limits
+// like the number of memory mappings, and must keep the other chunks intact
+static void test_many_chunks()
+{
+  uint64_t page_size = sysconf(_SC_PAGESIZE);
+  uint64_t nb_chunks = 200000;
+  uint64_t size = nb_chunks * page_size;
+  vp::mem_backing backing;
+
+  CHECK(backing.init(size, FILL, false, vp::mem_backing::HUGE_PAGES_NONE, page_size) == 0);
+  uint8_t *data = backing.get_data();
+
+  for (uint64_t chunk=0; chunk<nb_chunks; chunk+=2)
+  {
+    backing.populate(chunk * page_size, 1);
+    data[chunk * page_size] = chunk & 0xff;
+  }
+
+  int diffs = 0;
+  for (uint64_t chunk=0; chunk<nb_chunks; chunk+=2)
+  {
+    if (data[chunk * page_size] != (chunk & 0xff) || data[chunk * page_size + 1] != FILL)
+      diffs++;
+  }
+  CHECK(diffs == 0);
+
+  // An access crossing chunks populates all of them
+  CHECK(data[3 * page_size] == 0);
+  backing.populate(3 * page_size - 1, 2);
+  CHECK(data[3 * page_size - 1] == FILL && data[3 * page_size] == FILL);
+  CHECK(data[size - 1] == 0);
+  backing.populate(size - 1, 1);
+  CHECK(data[size - 1] == FILL);
+}
+
+static uint8_t file_byte(uint64_t offset)
+{
+  return (offset * 7 + (offset >> 12)) & 0xff;
+}
+
+static bool write_file(const char *path, uint64_t size)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return false;
+  for (uint64_t i=0; i<size; i++)
+    fputc(file_byte(i), file);
+  fclose(file);
+  return true;
+}
+
+// The file does not end on a page boundary, so that its last page is read
+// while the previous ones are mapped
+static void test_preload_writeback(uint64_t mem_size, uint64_t chunk_size, bool same_file)
+{
+  uint64_t page_size = sysconf(_SC_PAGESIZE);
+  uint64_t file_size = 3 * page_size + 100;
+  char preload_path[] = "/tmp/mem_backing_preload_XXXXXX";
+  char writeback_path[] = "/tmp/mem_backing_writeback_XXXXXX";
+  int fd;
+
+  fd = mkstemp(preload_path);
+  CHECK(fd >= 0);
+  close(fd);
+  fd = mkstemp(writeback_path);
+  CHECK(fd >= 0);
+  close(fd);
+
+  CHECK(write_file(preload_path, file_size));
+
+  // The preloaded file can also be the writeback one
+  if (same_file)
+  {
+    unlink(writeback_path);
+    strcpy(writeback_path, preload_path);
+  }
+
+  // The memory is released at the end of the block, which writes it back
+  {
+    vp::mem_backing backing;
+    CHECK(backing.init(mem_size, FILL, false, vp::mem_backing::HUGE_PAGES_NONE, chunk_size) == 0);
+    CHECK(backing.preload_file(preload_path) == 0);
+    uint8_t *data = backing.get_data();
+
+    // The preloaded content is populated, which includes the end of its last
+    // chunk
+    int diffs = 0;
+    for (uint64_t i=0; i<file_size; i++)
+    {
+      if (data[i] != file_byte(i))
+        diffs++;
+    }
+    CHECK(diffs == 0);
+
+    // The pattern is kept after the end of the file, in its last page and after
+    CHECK(data[file_size] == FILL);
+    CHECK(data[4 * page_size - 1] == FILL);
+    backing.populate(4 * page_size, 1);
+    CHECK(data[4 * page_size] == FILL);
+    backing.populate(mem_size - 1, 1);
+    CHECK(data[mem_size - 1] == FILL);
+
+    // Writes go to the memory, not to the file
+    data[10] = ~file_byte(10);
+    data[file_size - 1] = ~file_byte(file_size - 1);
+    data[file_size] = 1;
+    data[mem_size - 1] = 2;
+
+    FILE *file = fopen(preload_path, "rb");
+    CHECK(file != NULL);
+    fseek(file, 10, SEEK_SET);
+    CHECK(fgetc(file) == file_byte(10));
+    fclose(file);
+
+    CHECK(backing.setup_writeback_file(writeback_path) == 0);
+    data = backing.get_data();
+    CHECK(data[10] == (uint8_t)~file_byte(10));
+    CHECK(data[page_size] == file_byte(page_size));
+
+    // Written after the setup, must also end up in the file
+    data[20] = 3;
+  }
+
+  struct stat file_stat;
+  CHECK(stat(writeback_path, &file_stat) == 0 && (uint64_t)file_stat.st_size == mem_size);
+
+  uint8_t *content = new uint8_t[mem_size];
+  FILE *file = fopen(writeback_path, "rb");
+  CHECK(file != NULL && fread(content, 1, mem_size, file) == mem_size);
+  fclose(file);
+
+  int diffs = 0;
+  for (uint64_t i=0; i<mem_size; i++)
+  {
+    uint8_t expected = i < file_size ? file_byte(i) : FILL;
+    if (i == 10 || i == file_size - 1) expected = ~file_byte(i);
+    if (i == 20) expected = 3;
+    if (i == file_size) expected = 1;
+    if (i == mem_size - 1) expected = 2;
+    if (content[i] != expected)
+      diffs++;
+  }
+  CHECK(diffs == 0);
+
+  delete[] content;
+  unlink(preload_path);
+  unlink(writeback_path);
+}
+
+int main()
+{
+  test_lazy_fill();
+  test_small();
+  test_check();
+  test_copy_to();
+  test_many_chunks();
+
+  // Lazy memory with chunks smaller and bigger than the file, eager memory,
+  // and writeback to the preloaded file
+  test_preload_writeback(4 << 20, 4096, false);
+  test_preload_writeback(4 << 20, 1 << 21, false);
+  test_preload_writeback(64 << 10, 0, false);
+  test_preload_writeback(4 << 20, 4096, true);
+
+  if (nb_errors)
+  {
+    printf("Got %d errors\n", nb_errors);
+    return -1;
+  }
+
+  printf("All checks passed\n");
+  return 0;
+}